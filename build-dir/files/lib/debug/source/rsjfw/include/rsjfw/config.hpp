@@ -1,11 +1,17 @@
 #ifndef RSJFW_CONFIG_HPP
 #define RSJFW_CONFIG_HPP
 
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace rsjfw {
@@ -40,6 +46,10 @@ struct GeneralConfig {
   // DXVK (v2.1 format)
   bool dxvk = true;
   DxvkSourceConfig dxvkSource;
+  bool shaderWarmup = false; // Replay recorded pipelines after installs
+  // Closing the config window while Studio runs frees the UI but keeps
+  // the process waiting, so reopening it is instant
+  bool standby = true;
 
   // Wine/Proton (v2.1 format)
   WineSourceConfig wineSource;
@@ -72,36 +82,90 @@ struct WineConfig {
   std::string desktopResolution = "1920x1080";
 };
 
+struct PerformanceConfig {
+  std::string syncMode = "auto";   // auto, ntsync, fsync, esync or none
+  bool gamemode = false;           // Feral gamemode via libgamemodeauto
+  std::string studioCpus = "";     // CPU list for Studio, e.g. "0-7"
+  int wineserverCpu = -1;          // Core to pin the wineserver to
+  bool lowPriorityBackground = true; // nice/idle I/O for background work
+};
+
+struct LogsConfig {
+  int rotateMB = 64;     // Start a new file once a live log passes this
+  int maxAgeDays = 30;   // Archived logs older than this are deleted
+  int maxTotalMB = 1024; // Cap for everything under logs/
+  bool compress = true;  // zstd closed logs into old/
+};
+
+struct VersionsConfig {
+  int keep = 2;                    // Most recent Studio installs kept
+  std::vector<std::string> pinned; // Never removed
+  bool autoClean = true;           // Clean up after launching the newest
+  bool prefetch = true;            // Stage new versions in the background
+  int prefetchIntervalMinutes = 60;
+  int prefetchLimitKBps = 4096; // 0 for no cap
+};
+
+// One immutable version of the whole configuration
+struct ConfigSnapshot {
+  GeneralConfig general;
+  WineConfig wine;
+  PerformanceConfig performance;
+  LogsConfig logs;
+  VersionsConfig versions;
+  std::map<std::string, nlohmann::json> fflags; // FFlags are dynamic
+};
+
+// Readers take a snapshot (one atomic load, no lock) and keep a consistent
+// view for as long as they hold it. Writers copy the current snapshot,
+// modify the copy and publish it with update().
 class Config {
 public:
+  using Snapshot = std::shared_ptr<const ConfigSnapshot>;
+
   static Config &instance();
 
-  void load(const std::filesystem::path &configPath);
-  void save();
+  Snapshot snapshot() const { return current_.load(std::memory_order_acquire); }
 
-  // Getters
-  GeneralConfig &getGeneral() { return general_; }
-  WineConfig &getWine() { return wine_; }
+  // Copy-modify-publish, then save(). Concurrent updates are serialized
+  // and none is lost; `fn` must not call back into update().
+  void update(const std::function<void(ConfigSnapshot &)> &fn);
+
+  // Saves afterwards so the file picks up new keys and migrations, unless
+  // `normalize` is false (protocol launches leave the file alone)
+  void load(const std::filesystem::path &configPath, bool normalize = true);
+  // Marks the config dirty; a background thread writes it once changes
+  // have settled for a moment. Cheap enough to call from UI code.
+  void save();
+  // Writes pending changes now, on the calling thread
+  void flush();
 
-  // FFlags are dynamic, just expose the map
-  std::map<std::string, nlohmann::json> &getFFlags() { return fflags_; }
   void setFFlag(const std::string &key, const nlohmann::json &value);
-  std::recursive_mutex &getMutex() { return mutex_; }
 
   // Forbidden
   Config(const Config &) = delete;
   Config &operator=(const Config &) = delete;
 
 private:
-  Config() = default;
-  ~Config() = default;
+  Config();
+  ~Config();
+
+  static std::string serialize(const ConfigSnapshot &config);
+  void write();
+  void saverLoop(std::stop_token stop);
 
+  std::atomic<Snapshot> current_;
+  std::mutex updateMutex_; // Serializes writers; guards configPath_
   std::filesystem::path configPath_;
-  GeneralConfig general_;
-  WineConfig wine_;
-  std::map<std::string, nlohmann::json> fflags_;
 
-  std::recursive_mutex mutex_;
+  // Save coalescing
+  std::mutex saveMutex_;
+  std::condition_variable_any saveCv_;
+  bool dirty_ = false;
+  std::chrono::steady_clock::time_point lastSaveRequest_;
+  std::jthread saver_;
+  std::mutex writeMutex_;  // One write() at a time
+  size_t savedHash_ = 0;   // Hash of what config.json holds
 };
 
 } // namespace rsjfw
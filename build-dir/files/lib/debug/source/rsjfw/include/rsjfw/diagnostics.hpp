@@ -5,6 +5,7 @@
 #include <vector>
 #include <functional>
 #include <map>
+#include <mutex>
 
 namespace rsjfw {
 
@@ -33,10 +34,12 @@ class Diagnostics {
 public:
     static Diagnostics& instance();
 
-    // Runs all health checks and returns true if all are OK
+    // Runs all health checks and returns true if all are OK. Safe from
+    // any thread; concurrent runs take turns.
     bool runChecks();
     
-    const std::vector<std::pair<std::string, HealthStatus>>& getResults() const { return results_; }
+    // A copy of the last run's results
+    std::vector<std::pair<std::string, HealthStatus>> getResults() const;
     
     // Returns number of failing checks
     int failureCount() const;
@@ -46,7 +49,10 @@ public:
 
 private:
     Diagnostics() = default;
+    mutable std::mutex mutex_; // results_
     std::vector<std::pair<std::string, HealthStatus>> results_;
+    std::mutex runMutex_;      // One runChecks() at a time; pending_
+    std::vector<std::pair<std::string, HealthStatus>> pending_;
 
     // Helper methods
     void checkRoot();
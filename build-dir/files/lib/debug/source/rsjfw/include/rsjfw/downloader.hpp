@@ -3,7 +3,9 @@
 
 #include "rsjfw/config.hpp"
 #include "rsjfw/roblox_api.hpp"
+#include <cstdint>
 #include <functional>
+#include <stop_token>
 #include <string>
 #include <vector>
 
@@ -21,6 +23,14 @@ public:
   bool installVersion(const std::string &versionGUID,
                       ProgressCallback callback = nullptr);
 
+  // For background installs: caps the combined rate of package downloads
+  // (0 for none), and makes installVersion() give up once `stop` is
+  // requested. What was staged so far is resumed by the next install.
+  void setTransferLimit(uint64_t bytesPerSecond) {
+    maxBytesPerSecond_ = bytesPerSecond;
+  }
+  void setStopToken(std::stop_token stop) { stop_ = std::move(stop); }
+
   // v2.1: Unified GitHub API support
   struct GitHubAsset {
     std::string name;
@@ -44,36 +54,45 @@ public:
                    ProgressCallback callback = nullptr);
 
   // GitHub API interactions
-  std::vector<GitHubRelease> fetchReleases(const std::string &repo);
+  // Served from ReleaseCache. Pages older than the first are fetched only
+  // while looking for `wantTag`.
+  std::vector<GitHubRelease> fetchReleases(const std::string &repo,
+                                           const std::string &wantTag = "");
   bool validateRepo(const std::string &repo, std::string &outError);
 
   // Management
   struct InstalledRoot {
     std::string name;
     std::string path;
-    size_t sizeBytes;
-    bool isProton;
+    size_t sizeBytes = 0;
+    bool sizeKnown = false; // Sizing runs in the background
+    bool isProton = false;
 
     // Metadata for UI Sync
     std::string repo;
     std::string version;
     std::string asset;
   };
-  std::vector<InstalledRoot> getInstalledWineRoots();
-  std::vector<InstalledRoot> getInstalledDxvkRoots();
+  // Installed roots are listed by RootInventory
   bool deleteRoot(const std::string &path);
 
   std::string getLatestVersionGUID();
+  // What the last successful getLatestVersionGUID() returned for the
+  // configured channel, without touching the network. Empty if unknown.
+  std::string getCachedLatestVersionGUID();
   std::vector<std::string> getInstalledVersions();
 
 private:
   std::string rootDir_;
   std::string versionsDir_;
   std::string downloadsDir_;
+  uint64_t maxBytesPerSecond_ = 0;
+  std::stop_token stop_;
 
   std::string downloadLatestRobloxStudio(const std::string &versionGUID);
 
   bool downloadPackage(const std::string &versionGUID, const RobloxPackage &pkg,
+                       int64_t maxBytesPerSecond,
                        std::function<void(size_t, size_t)> progressCb);
   std::string extractArchive(const std::string &archivePath,
                              const std::string &destDir,
@@ -7,7 +7,9 @@
 namespace rsjfw {
 namespace dxvk {
 
-// Installs DXVK DLLs from the extracted directory into the Wine Prefix
+// Installs DXVK DLLs from the extracted directory into the Wine Prefix.
+// A manifest in the prefix records the source root and DLL hashes, so
+// unchanged installs are detected with stat calls alone.
 bool install(wine::Prefix& pfx, const std::string& dxvkRootDir);
 
 // Configures WINEDLLOVERRIDES for DXVK
@@ -0,0 +1,63 @@
+#ifndef RSJFW_EVENT_LOG_HPP
+#define RSJFW_EVENT_LOG_HPP
+
+#include "rsjfw/log_retention.hpp"
+#include "rsjfw/logger.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace rsjfw {
+
+enum class EventSource : uint8_t { RSJFW = 0, WINE = 1, STUDIO = 2 };
+
+struct Event {
+  uint64_t monoNs = 0;
+  EventSource source = EventSource::RSJFW;
+  LogLevel level = LogLevel::INFO;
+  std::string_view payload;
+};
+
+// Child process output stored once as binary records; text is only produced
+// when something looks at it (console echo, log viewer, search).
+//
+//   file   := header record*
+//   header := "RSJFWEV1" int64 wallOffsetNs   (CLOCK_REALTIME - MONOTONIC)
+//   record := uint32 size  uint64 monoNs  uint8 source  uint8 level  payload
+//
+// `size` counts the bytes after itself. Integers are little-endian. Every
+// file starts with a header, rotated ones included, so each renders alone.
+class EventLog {
+public:
+  static constexpr const char *EXTENSION = ".events";
+
+  bool open(const std::filesystem::path &path);
+  void close() { file_.close(); }
+  bool isOpen() const { return file_.isOpen(); }
+  void setMaxBytes(uint64_t bytes) { file_.setMaxBytes(bytes); }
+
+  void append(EventSource source, LogLevel level, std::string_view payload);
+
+  // Wine debug channels ("0024:err:module:...") are Wine's; anything else
+  // the child prints is Studio's
+  static void classify(std::string_view line, EventSource &source,
+                       LogLevel &level);
+
+  // "[YYYY-mm-dd HH:MM:SS.mmm] [LEVEL] [SOURCE] payload", no newline
+  static std::string format(const Event &event, int64_t wallOffsetNs);
+
+  // Renders `events` into the text file `text`. While the source keeps
+  // growing in place, later calls only append what was added since.
+  static bool render(const std::filesystem::path &events,
+                     const std::filesystem::path &text);
+
+  static bool isEventLog(const std::filesystem::path &path);
+
+private:
+  RotatingLogFile file_;
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_EVENT_LOG_HPP
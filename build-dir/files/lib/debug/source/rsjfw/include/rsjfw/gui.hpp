@@ -3,6 +3,7 @@
 
 #include "rsjfw/diagnostics.hpp"
 #include "rsjfw/page.hpp"
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -23,10 +24,20 @@ public:
 
   void run(const std::function<void()> &renderCallback);
 
+  // The loop sleeps until input arrives or something asks for a frame.
+  // wake() is safe from any thread; requestFrame() is for render code that
+  // is animating and wants another frame within `delay` seconds (0 = at the
+  // frame cap).
+  void wake();
+  void requestFrame(double delay = 0.0);
+
   void setProgress(float progress, const std::string &status);
   void setTaskProgress(const std::string &name, float progress,
                        const std::string &status);
   void removeTask(const std::string &name);
+  // Removes a task that has returned, unless it ended in "Error"
+  void finishTask(const std::string &name);
+  // Queued or running; a failed task does not count
   bool hasTask(const std::string &name);
   void setSubProgress(float progress, const std::string &status);
   void updateFixProgress(float progress, const std::string &status);
@@ -51,7 +62,10 @@ public:
   bool hasError() const { return !error_.empty(); }
 
   void close();
+  // Tears everything down, GLFW included; init() may be called again
   void shutdown();
+  // True if the last run() ended because the user closed the window
+  bool closedByUser() const { return closedByUser_; }
 
   // Page Navigation
   PageStack &pages() { return pages_; }
@@ -109,8 +123,13 @@ private:
   int currentSettingsTab_ = 0;
   int targetSettingsTab_ = 0;
 
-  bool shouldClose_ = false;
-  bool initialized_ = false;
+  // Seconds until the next frame is due, lowered by requestFrame()
+  double nextFrameDelay_ = 0.0;
+
+  std::atomic<bool> shouldClose_{false};
+  bool closedByUser_ = false;
+  std::atomic<bool> initialized_{false};
+  std::mutex wakeMutex_; // Keeps wake() out of glfwInit()/glfwTerminate()
   unsigned int logoTexture_ = 0;
   int logoWidth_ = 0;
   int logoHeight_ = 0;
@@ -4,17 +4,35 @@
 #include <string>
 #include <curl/curl.h>
 #include <functional>
+#include <map>
+#include <stop_token>
+#include <vector>
 
 namespace rsjfw {
 
 class HTTP {
 public:
     using ProgressCallback = std::function<void(size_t current, size_t total)>;
+
+    struct Response {
+        long status = 0;
+        std::string body;
+        std::map<std::string, std::string> headers; // Names lowercased
+    };
+
     static std::string get(const std::string& url);
-    static bool download(const std::string& url, const std::string& filepath, ProgressCallback callback = nullptr);
+    // Like get(), but sends extra "Name: value" headers and hands back the
+    // status and response headers instead of just the body. Throws only
+    // when no response arrived at all.
+    static Response request(const std::string& url, const std::vector<std::string>& headers = {});
+    // `maxBytesPerSecond` caps the transfer rate (0 for none). The transfer
+    // is aborted, and false returned, once `stop` is requested.
+    static bool download(const std::string& url, const std::string& filepath, ProgressCallback callback = nullptr,
+                         curl_off_t maxBytesPerSecond = 0, std::stop_token stop = {});
 
 private:
     static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::string* userp);
+    static size_t headerCallback(char* buffer, size_t size, size_t nitems, void* userp);
     static size_t fileWriteCallback(void* contents, size_t size, size_t nmemb, void* userp);
     static int progressCallback(void* clientp, double dltotal, double dlnow, double ultotal, double ulnow);
 };
@@ -39,6 +39,9 @@ private:
   std::string prefixDir_;
   std::string compatDataDir_;
 
+  // Studio version being launched; empty for winecfg and other tools
+  std::string activeVersion_;
+
   std::string findStudioExecutable(const std::string &versionDir);
   bool runWine(const std::string &executablePath,
                const std::vector<std::string> &args = {},
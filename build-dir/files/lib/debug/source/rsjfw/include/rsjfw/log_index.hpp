@@ -0,0 +1,90 @@
+#ifndef RSJFW_LOG_INDEX_HPP
+#define RSJFW_LOG_INDEX_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace rsjfw {
+
+// Line-offset index over a (possibly growing) log file, built on a worker
+// thread so the viewer only ever touches the rows it draws. Files are
+// scanned through mmap; appended bytes are indexed incrementally and a
+// truncated or replaced file is re-indexed from scratch.
+class LogIndex : public std::enable_shared_from_this<LogIndex> {
+public:
+  enum Level : uint8_t {
+    LEVEL_INFO = 1 << 0,
+    LEVEL_WARN = 1 << 1,
+    LEVEL_ERROR = 1 << 2,
+    LEVEL_ALL = LEVEL_INFO | LEVEL_WARN | LEVEL_ERROR
+  };
+
+  struct Row {
+    size_t lineNo = 0;
+    Level level = LEVEL_INFO;
+    std::string text;
+  };
+
+  static std::shared_ptr<LogIndex> create();
+  ~LogIndex();
+
+  // Switches to another file; the old index is dropped
+  void open(const std::string &path);
+  // Picks up anything appended since the last scan
+  void refresh();
+  // Rebuilds the visible row list on the worker when the mask changes
+  void setFilter(unsigned levelMask);
+
+  size_t lineCount();
+  size_t visibleCount();
+  bool busy();
+
+  // Visible rows [first, last), read straight from the file
+  void rows(size_t first, size_t last, std::vector<Row> &out);
+  // Everything indexed so far, for the clipboard
+  std::string text();
+
+  static Level classify(const char *data, size_t len);
+
+private:
+  struct Line {
+    uint64_t offset;
+    uint32_t length;
+    Level level;
+  };
+
+  LogIndex() = default;
+
+  void schedule();
+  void work();
+  void scan();
+  void refilter();
+
+  std::mutex mutex_;
+  std::string path_;
+  uint64_t generation_ = 0;      // Bumped by open()
+  uint64_t indexedGeneration_ = 0;
+  int fd_ = -1;                  // Used for row reads, swapped by the worker
+  dev_t dev_ = 0;
+  ino_t ino_ = 0;
+
+  // Only the worker writes these; it reads them without the lock
+  std::vector<Line> lines_;
+  std::vector<uint32_t> visible_;
+  uint64_t indexedBytes_ = 0; // End of the last complete line
+  bool partialTail_ = false;  // Last entry has no newline yet
+  unsigned visibleMask_ = LEVEL_ALL;
+
+  unsigned mask_ = LEVEL_ALL;
+  bool pendingScan_ = false;
+  bool pendingFilter_ = false;
+  bool running_ = false;
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_LOG_INDEX_HPP
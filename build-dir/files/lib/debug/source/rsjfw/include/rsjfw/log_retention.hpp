@@ -0,0 +1,89 @@
+#ifndef RSJFW_LOG_RETENTION_HPP
+#define RSJFW_LOG_RETENTION_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+namespace rsjfw {
+
+// Append-only log file that moves itself aside once it passes a size limit
+// and carries on in a fresh file at the same path. Holds a shared flock so
+// retention never archives a file someone is still writing.
+class RotatingLogFile {
+public:
+  RotatingLogFile() = default;
+  ~RotatingLogFile();
+
+  RotatingLogFile(const RotatingLogFile &) = delete;
+  RotatingLogFile &operator=(const RotatingLogFile &) = delete;
+
+  bool open(const std::filesystem::path &path, bool append);
+  bool write(const char *data, size_t len);
+  void close();
+
+  bool isOpen() const { return fd_ >= 0; }
+  uint64_t size() const { return size_; }
+  const std::filesystem::path &path() const { return path_; }
+
+  // 0 disables rotation
+  void setMaxBytes(uint64_t bytes) { maxBytes_ = bytes; }
+  // Written at the start of every new file, including after a rotation.
+  // Set before open().
+  void setHeader(std::string header) { header_ = std::move(header); }
+
+private:
+  bool openFd(bool append);
+  void rotate();
+
+  std::mutex mutex_;
+  std::filesystem::path path_;
+  int fd_ = -1;
+  uint64_t size_ = 0;
+  std::atomic<uint64_t> maxBytes_{0};
+  std::string header_;
+};
+
+// Keeps logs/ bounded: closed logs are compressed into old/ as .log.zst,
+// then archives past the age limit and the oldest files over the total size
+// cap are deleted. Driven by the "logs" section of the config.
+class LogRetention {
+public:
+  static LogRetention &instance();
+
+  // Runs a pass on a background-priority worker; calls coalesce
+  void schedule();
+  void run();
+
+  // Moves a live log aside as <stem>_<YYYYmmdd_HHMMSS>.log in the same
+  // directory, stamped with `when`. Returns the new path, or empty.
+  static std::filesystem::path archive(const std::filesystem::path &live,
+                                       std::time_t when);
+
+  static bool isCompressed(const std::filesystem::path &path);
+  // Plain or compressed text logs and event logs
+  static bool isLogFile(const std::filesystem::path &path);
+
+  // Path that can be read as plain text: the file itself, or a copy under
+  // <cache>/log_view for archives (decompressed) and event logs (rendered).
+  // Empty on failure.
+  static std::filesystem::path readablePath(const std::filesystem::path &path);
+
+  static bool compress(const std::filesystem::path &src,
+                       const std::filesystem::path &dest);
+  static bool decompress(const std::filesystem::path &src,
+                         const std::filesystem::path &dest);
+
+private:
+  LogRetention() = default;
+
+  std::mutex runMutex_;
+  std::atomic<bool> queued_{false};
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_LOG_RETENTION_HPP
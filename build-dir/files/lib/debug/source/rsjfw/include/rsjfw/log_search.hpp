@@ -0,0 +1,99 @@
+#ifndef RSJFW_LOG_SEARCH_HPP
+#define RSJFW_LOG_SEARCH_HPP
+
+#include "rsjfw/log_index.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rsjfw {
+
+// Case-insensitive substring search across everything under
+// PathManager::logs() (including old/, its .zst archives and event logs,
+// which are searched as rendered text). Files are cut into blocks and a
+// trigram -> block postings index is kept in <cache>/log_search.idx, so a
+// query only reads the blocks that can match plus each file's unindexed
+// tail. The index catches up incrementally as Logger writes.
+class LogSearch {
+public:
+  struct Hit {
+    std::string file; // Relative to the logs directory
+    size_t line = 0;
+    std::string timestamp;
+    LogIndex::Level level = LogIndex::LEVEL_INFO;
+    std::string text;
+  };
+
+  struct Result {
+    std::vector<Hit> hits;
+    bool truncated = false; // Stopped at maxHits
+    std::map<std::string, size_t> fileCounts;
+    std::map<LogIndex::Level, size_t> levelCounts;
+    size_t blocksRead = 0;
+    double millis = 0.0;
+  };
+
+  static LogSearch &instance();
+
+  // Hooks the Logger so the session log is indexed as it grows. Older logs
+  // are caught up lazily by sync().
+  void attach();
+
+  // Indexes new data in every log, drops deleted files and saves the index
+  void sync();
+  void scheduleSync();
+
+  Result search(const std::string &query,
+                unsigned levelMask = LogIndex::LEVEL_ALL,
+                size_t maxHits = 2000);
+
+private:
+  struct Block {
+    uint32_t file;
+    uint64_t offset;
+    uint32_t length;
+    uint64_t firstLine;
+  };
+
+  struct File {
+    std::string name;
+    uint64_t dev = 0;
+    uint64_t ino = 0;
+    uint64_t fingerprint = 0; // Hash of the first bytes, catches rewrites
+    uint32_t fingerprintLen = 0;
+    uint64_t indexedBytes = 0; // End of the last block
+    uint64_t lines = 0;        // Lines before indexedBytes
+    bool alive = true;
+  };
+
+  LogSearch() = default;
+
+  void load();
+  bool save();
+  void indexFile(uint32_t fileId, const std::filesystem::path &path,
+                 uint64_t size, bool growing);
+  void resetFile(uint32_t fileId);
+  void compact();
+
+  std::mutex mutex_;
+  std::mutex syncMutex_; // One sync at a time
+  bool loaded_ = false;
+  bool dirty_ = false;
+  std::vector<File> files_;
+  std::vector<Block> blocks_;
+  std::vector<bool> deadBlocks_;
+  size_t deadCount_ = 0;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+
+  std::atomic<uint64_t> nextLiveSync_{0};
+  std::atomic<bool> syncQueued_{false};
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_LOG_SEARCH_HPP
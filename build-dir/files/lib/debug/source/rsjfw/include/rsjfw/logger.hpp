@@ -6,8 +6,15 @@
 #include <iostream>
 #include <filesystem>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <iomanip>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "rsjfw/log_retention.hpp"
 
 namespace rsjfw {
 
@@ -18,13 +25,36 @@ enum class LogLevel {
     ERROR
 };
 
+// Producers format a record and push it into a bounded MPSC ring; a writer
+// thread drains the ring and writes each batch with a single write(2).
 class Logger {
 public:
     static Logger& instance();
 
+    // Minimum level is INFO unless verbose, overridable with RSJFW_LOG_LEVEL.
+    // Until init() opens a log file, records only go to the console.
+    void configure(bool verbose);
+    // configure(), then open the session log and start the writer
     void init(const std::filesystem::path& logPath, bool verbose);
     void log(LogLevel level, const std::string& message);
 
+    bool verbose() const { return verbose_; }
+    void setLevel(LogLevel level) { minLevel_.store(static_cast<int>(level), std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= minLevel_.load(std::memory_order_relaxed);
+    }
+
+    // Blocks until everything logged so far is on disk
+    void flush();
+
+    // The session log moves aside and starts over past this size (0 = never)
+    void setRotateBytes(uint64_t bytes) { file_.setMaxBytes(bytes); }
+
+    // Called after each write with the log file and its new size. Runs on
+    // the writer thread; keep it cheap.
+    using WriteListener = std::function<void(const std::filesystem::path&, uint64_t)>;
+    void setWriteListener(WriteListener listener);
+
     // Forbidden
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
@@ -33,19 +63,54 @@ private:
     Logger() = default;
     ~Logger();
 
-    std::ofstream logFile_;
-    bool verbose_ = false;
-    std::mutex mutex_;
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        LogLevel level;
+        std::string text;
+    };
+
+    static constexpr size_t RING_SIZE = 8192; // Power of two
 
-    std::string getTimestamp();
-    std::string getLevelString(LogLevel level);
+    bool tryPush(LogLevel level, std::string& text);
+    bool tryPop(LogLevel& level, std::string& text);
+    void writerLoop(std::stop_token stop);
+    void echo(LogLevel level, const std::string& line);
+
+    std::unique_ptr<Slot[]> ring_;
+    std::atomic<uint64_t> head_{0}; // Next slot producers claim
+    std::atomic<uint64_t> tail_{0}; // Next slot the writer reads
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> writerIdle_{false};
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> written_{0};
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable flushedCv_;
+    std::jthread writer_;
+
+    RotatingLogFile file_;
+    std::filesystem::path logPath_;
+    WriteListener listener_;
+    std::atomic<bool> verbose_{false};
+    std::atomic<int> minLevel_{static_cast<int>(LogLevel::INFO)};
+    std::mutex mutex_; // listener_, and console output
+
+    static const char* getTimestamp();
+    static const char* getLevelString(LogLevel level);
 };
 
-// Convenience macros
-#define LOG_DEBUG(msg) rsjfw::Logger::instance().log(rsjfw::LogLevel::DEBUG, msg)
-#define LOG_INFO(msg) rsjfw::Logger::instance().log(rsjfw::LogLevel::INFO, msg)
-#define LOG_WARN(msg) rsjfw::Logger::instance().log(rsjfw::LogLevel::WARNING, msg)
-#define LOG_ERROR(msg) rsjfw::Logger::instance().log(rsjfw::LogLevel::ERROR, msg)
+// Convenience macros. The message is not evaluated below the active level.
+#define RSJFW_LOG_AT(level, msg)                                   \
+    do {                                                           \
+        if (rsjfw::Logger::instance().enabled(level))              \
+            rsjfw::Logger::instance().log(level, msg);             \
+    } while (0)
+
+#define LOG_DEBUG(msg) RSJFW_LOG_AT(rsjfw::LogLevel::DEBUG, msg)
+#define LOG_INFO(msg) RSJFW_LOG_AT(rsjfw::LogLevel::INFO, msg)
+#define LOG_WARN(msg) RSJFW_LOG_AT(rsjfw::LogLevel::WARNING, msg)
+#define LOG_ERROR(msg) RSJFW_LOG_AT(rsjfw::LogLevel::ERROR, msg)
 
 } // namespace rsjfw
 
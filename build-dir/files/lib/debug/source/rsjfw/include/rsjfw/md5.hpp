@@ -0,0 +1,34 @@
+#ifndef RSJFW_MD5_HPP
+#define RSJFW_MD5_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace rsjfw {
+
+// RFC 1321 MD5. Roblox names every package by the MD5 of its zip, which
+// is all this is used for; it is not a security boundary.
+class Md5 {
+public:
+  Md5();
+
+  void update(const void *data, size_t len);
+  // Lowercase hex digest. Finishes the hash; call once.
+  std::string hexDigest();
+
+  // Digest of a whole file, or empty if it cannot be read
+  static std::string file(const std::filesystem::path &path);
+
+private:
+  void transform(const uint8_t block[64]);
+
+  uint32_t state_[4];
+  uint64_t length_ = 0; // Bytes hashed so far
+  uint8_t buffer_[64];
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_MD5_HPP
@@ -5,6 +5,7 @@
 #include "rsjfw/downloader.hpp"
 #include "rsjfw/page.hpp"
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -25,19 +26,23 @@ public:
   void renderDxvkTab();
   void renderFFlagsTab();
   void renderEnvTab();
+  void renderPerformanceTab();
 
   void renderInstalledRoots(bool wine);
 
   void update();
   void ensureVersions();
   void ensureVersions(const std::string &repo);
+  void loadOlderVersions(const std::string &repo);
 
 private:
   GUI *gui_;
 
   // Version/Asset caching (v2.1)
   std::map<std::string, std::vector<Downloader::GitHubRelease>> releaseCache_;
-  std::set<std::string> fetching_; // Repo strings currently being fetched
+  std::set<std::string> fetching_;     // Repo strings currently being fetched
+  std::set<std::string> moreReleases_; // Repos with older pages not loaded
+  std::mutex releaseMutex_; // Guards releaseCache_, fetching_, moreReleases_
 };
 
 } // namespace rsjfw
@@ -3,7 +3,13 @@
 
 #include "rsjfw/page.hpp"
 #include "rsjfw/diagnostics.hpp"
+#include "rsjfw/log_index.hpp"
+#include "rsjfw/log_search.hpp"
+#include "rsjfw/shader_cache.hpp"
 #include "imgui.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace rsjfw {
 
@@ -31,10 +37,26 @@ private:
     
     std::vector<std::pair<std::string, HealthStatus>> healthChecks_;
     void runHealthChecks();
+    void renderStorageUsage();
     
     std::vector<std::string> logFiles_;
     int selectedLog_ = 0;
+    std::shared_ptr<LogIndex> logIndex_;
+    size_t jumpLine_ = 0; // Set by a search hit, consumed by the viewer
     void refreshLogList();
+
+    char searchQuery_[256] = "";
+    LogSearch::Result searchResult_;
+    bool hasSearchResult_ = false;
+    std::mutex searchMutex_;
+    std::atomic<bool> searching_{false};
+    void runLogSearch();
+    void renderLogSearch();
+
+    ShaderCache::Stats shaderStats_;
+    std::mutex shaderStatsMutex_;
+    std::atomic<bool> shaderStatsLoading_{false};
+    void refreshShaderStats();
 };
 
 } // namespace rsjfw
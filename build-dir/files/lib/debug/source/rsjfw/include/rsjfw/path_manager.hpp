@@ -12,8 +12,13 @@ public:
 
     // Initializes paths based on optional root override.
     // If rootOverride is empty, it checks RSJFW_PATH env, then XDG defaults.
+    // Creates the directory layout and runs legacy migrations.
     void init(const std::string& rootOverride = "");
 
+    // Only works out the paths; nothing on disk is touched. Used by the
+    // protocol fast path, migrations wait for the next full start.
+    void resolve(const std::string& rootOverride = "");
+
     std::filesystem::path root() const { return rootDir_; }
     std::filesystem::path versions() const { return versionsDir_; }
     std::filesystem::path prefix() const { return prefixDir_; }
@@ -21,9 +26,16 @@ public:
     std::filesystem::path downloads() const { return downloadsDir_; }
     std::filesystem::path wine() const { return wineDir_; }
     std::filesystem::path dxvk() const { return dxvkDir_; }
+    std::filesystem::path cache() const { return cacheDir_; }
+    // Deleted trees wait here until Storage has reclaimed them
+    std::filesystem::path trash() const { return trashDir_; }
     
     // Returns the path where the Vulkan layer .so should be found
     std::filesystem::path layerLib() const;
+
+    // Returns the path of rsjfw-helper.exe, the in-prefix batch helper.
+    // Empty if it is not installed.
+    std::filesystem::path helperExe() const;
     
     // Returns the absolute path to the running RSJFW executable
     std::filesystem::path rsjfwExe() const;
@@ -34,6 +46,8 @@ public:
     // Returns coordination paths
     std::filesystem::path inbox() const { return inboxDir_; }
     std::filesystem::path lockFile() const { return lockFilePath_; }
+    // The primary instance's CommandServer
+    std::filesystem::path commandSocket() const { return inboxDir_ / "rsjfw.sock"; }
 
     // Returns true if running from a local development path
     bool isLocalBuild() const;
@@ -48,6 +62,8 @@ private:
     std::filesystem::path downloadsDir_;
     std::filesystem::path wineDir_;
     std::filesystem::path dxvkDir_;
+    std::filesystem::path cacheDir_;
+    std::filesystem::path trashDir_;
     std::filesystem::path currentLogPath_;
     std::filesystem::path inboxDir_;
     std::filesystem::path lockFilePath_;
@@ -0,0 +1,81 @@
+#ifndef RSJFW_PERFORMANCE_HPP
+#define RSJFW_PERFORMANCE_HPP
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace rsjfw {
+namespace wine {
+class Prefix;
+}
+
+// Scheduling and synchronisation tweaks applied to Studio launches, driven
+// by the "performance" section of the config.
+class Performance {
+public:
+  struct Capabilities {
+    bool ntsync = false;     // /dev/ntsync present and usable
+    bool fsync = false;      // futex_waitv syscall (Linux 5.16+)
+    std::string gamemodeLib; // libgamemodeauto path, empty if missing
+    int cpuCount = 1;
+    std::string kernel;
+  };
+
+  // Sync primitives a Wine/Proton build understands, read from its ntdll
+  // (or the proton script)
+  struct SyncSupport {
+    bool ntsync = false;
+    bool fsync = false;
+    bool esync = false;
+  };
+
+  static Performance &instance();
+
+  // Detected once and cached for the process lifetime
+  const Capabilities &capabilities();
+
+  // Cached per prefix in .rsjfw_sync.json and rescanned when the build
+  // changes
+  SyncSupport wineSyncSupport(const std::string &wineRoot,
+                              const std::string &prefixDir = "");
+
+  // Best primitive both the kernel and the build support, or the configured
+  // override. Returns "ntsync", "fsync", "esync" or "none".
+  std::string selectSync(const std::string &wineRoot,
+                         const std::string &prefixDir, std::string *reason);
+
+  // Sync primitive, gamemode and CPU affinity for the Studio process tree
+  void configureEnvironment(wine::Prefix &pfx, bool isProton);
+
+  // Waits for the prefix's wineserver to appear and pins it to the
+  // configured core. Blocks for up to timeoutMs; run it off the launch path.
+  void pinWineserver(const std::string &prefixDir, std::stop_token stop = {},
+                     int timeoutMs = 30000);
+
+  // Lowers CPU (nice) and I/O (idle class) priority of the calling thread
+  // if "performance.low_priority_background" is on. Only for threads that
+  // exist to do background work.
+  static void enterBackgroundPriority();
+  // Lowers the calling thread's priority, or with `low` false restores
+  // it. Raising nice again needs RLIMIT_NICE headroom; without it only
+  // the I/O class comes back.
+  static void setBackgroundPriority(bool low);
+
+  // Parses "0-3,8,10-11" into a sorted CPU list; nullopt on syntax errors
+  static std::optional<std::vector<int>> parseCpuList(const std::string &spec);
+
+private:
+  Performance() = default;
+
+  std::mutex mutex_;
+  std::optional<Capabilities> caps_;
+  std::map<std::string, SyncSupport> syncCache_; // keyed by ntdll path+mtime
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_PERFORMANCE_HPP
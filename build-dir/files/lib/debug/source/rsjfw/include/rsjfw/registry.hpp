@@ -1,16 +1,24 @@
 #ifndef RSJFW_REGISTRY_HPP
 #define RSJFW_REGISTRY_HPP
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "rsjfw/wine.hpp"
 
 namespace rsjfw {
+namespace wine {
+class HelperSession;
+}
 
+// Registry access for a prefix. Goes through one rsjfw-helper.exe session
+// for the lifetime of the Registry when the helper is installed, and falls
+// back to `wine reg` / regedit per call when it is not.
 class Registry {
 public:
   Registry(rsjfw::wine::Prefix &pfx);
+  ~Registry();
 
   bool add(const std::string &key, const std::string &valueName,
            const std::string &value);
@@ -25,8 +33,16 @@ public:
   std::vector<unsigned char> readBinary(const std::string &key,
                                         const std::string &valueName);
 
+  // Writes all entries; without the helper, as one regedit import
+  bool apply(const std::vector<wine::Prefix::RegistryEntry> &entries);
+
 private:
+  // `reg query` for a REG_BINARY value, as plain hex
+  std::string queryBinary(const std::string &key,
+                          const std::string &valueName);
+
   rsjfw::wine::Prefix &pfx_;
+  std::unique_ptr<wine::HelperSession> helper_;
 };
 
 } // namespace rsjfw
@@ -0,0 +1,76 @@
+#ifndef RSJFW_RELEASE_CACHE_HPP
+#define RSJFW_RELEASE_CACHE_HPP
+
+#include "rsjfw/downloader.hpp"
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace rsjfw {
+
+// GitHub release lists, kept per repo in <cache>/releases/. The first page
+// is revalidated with If-None-Match, and GitHub does not count a 304
+// against the rate limit. Older pages are only fetched when asked for, by
+// following the Link header. Set GITHUB_TOKEN to authenticate and get the
+// higher limit. When offline or rate limited the cached list is returned.
+class ReleaseCache {
+public:
+  using Release = Downloader::GitHubRelease;
+
+  static ReleaseCache &instance();
+
+  // Whatever is on disk, without touching the network
+  std::vector<Release> cached(const std::string &repo);
+
+  // Up-to-date releases, newest first. If `wantTag` is given and not among
+  // them, older pages are fetched until it turns up or none are left.
+  std::vector<Release> fetch(const std::string &repo,
+                             const std::string &wantTag = "");
+
+  // Fetches the next older page. False once there is none.
+  bool fetchMore(const std::string &repo);
+  bool hasMore(const std::string &repo);
+
+  ReleaseCache(const ReleaseCache &) = delete;
+  ReleaseCache &operator=(const ReleaseCache &) = delete;
+
+private:
+  ReleaseCache() = default;
+
+  struct Page {
+    std::string url;
+    std::string etag;
+    std::vector<Release> releases;
+  };
+
+  struct Entry {
+    std::mutex mutex; // Held across requests, so callers share one fetch
+    bool loaded = false;
+    std::vector<Page> pages;
+    std::string next; // Link rel="next" of the last page
+    std::chrono::system_clock::time_point checked{};
+  };
+
+  std::shared_ptr<Entry> entry(const std::string &repo);
+  void load(const std::string &repo, Entry &e);
+  void save(const std::string &repo, const Entry &e);
+  enum class PageResult { UPDATED, NOT_MODIFIED, FAILED };
+
+  // Fetches `url` into `page`, revalidating against its etag if it has
+  // one. `page` and `next` are only touched when UPDATED.
+  PageResult fetchPage(const std::string &url, Page &page, std::string &next);
+  bool revalidate(const std::string &repo, Entry &e);
+  static std::vector<Release> flatten(const Entry &e);
+  static std::filesystem::path pathFor(const std::string &repo);
+
+  std::mutex mutex_; // entries_
+  std::map<std::string, std::shared_ptr<Entry>> entries_;
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_RELEASE_CACHE_HPP
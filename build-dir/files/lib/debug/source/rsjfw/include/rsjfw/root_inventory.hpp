@@ -0,0 +1,69 @@
+#ifndef RSJFW_ROOT_INVENTORY_HPP
+#define RSJFW_ROOT_INVENTORY_HPP
+
+#include "rsjfw/downloader.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace rsjfw {
+
+struct RootInventorySnapshot {
+  std::vector<Downloader::InstalledRoot> wine;
+  std::vector<Downloader::InstalledRoot> dxvk;
+  bool ready = false; // false until the first listing is in
+};
+
+// The Wine/Proton and DXVK builds under PathManager::wine() and dxvk().
+// A background thread lists them, sizes each tree once with
+// Storage::treeSize() and keeps the result in <root>/rsjfw_size.json next
+// to rsjfw_meta.json. inotify on wine/, dxvk/ and every root triggers a
+// rescan, where unchanged roots come straight from rsjfw_size.json.
+// Readers get an immutable snapshot and never block or touch the disk.
+class RootInventory {
+public:
+  using Snapshot = std::shared_ptr<const RootInventorySnapshot>;
+
+  static RootInventory &instance();
+
+  // Starts the watcher and the first scan; later calls do nothing.
+  // `onChange` runs on the inventory thread after each publish.
+  void start(std::function<void()> onChange = {});
+  void stop();
+
+  Snapshot snapshot() const { return current_.load(std::memory_order_acquire); }
+  bool scanning() const { return scanning_.load(); }
+
+  // Rescans soon, for changes inotify cannot see
+  void invalidate() { dirty_ = true; }
+
+  RootInventory(const RootInventory &) = delete;
+  RootInventory &operator=(const RootInventory &) = delete;
+
+private:
+  RootInventory();
+  ~RootInventory();
+
+  void loop(std::stop_token stop);
+  void scan(std::stop_token stop);
+  void publish(RootInventorySnapshot next);
+  void watch(const std::filesystem::path &dir);
+
+  std::atomic<Snapshot> current_;
+  std::atomic<bool> dirty_{true};
+  std::atomic<bool> scanning_{false};
+  std::mutex startMutex_; // worker_, onChange_
+  std::function<void()> onChange_;
+  int inotifyFd_ = -1;
+  std::jthread worker_;
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_ROOT_INVENTORY_HPP
@@ -0,0 +1,89 @@
+#ifndef RSJFW_SHADER_CACHE_HPP
+#define RSJFW_SHADER_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace rsjfw {
+namespace wine {
+class Prefix;
+}
+
+// Per Studio version and GPU driver pipeline/state caches for DXVK,
+// VKD3D-Proton and the Mesa/NVIDIA driver caches underneath them.
+// Layout: <root>/cache/shaders/<versionGUID>/<gpuKey>/
+class ShaderCache {
+public:
+  struct VersionStats {
+    std::string version;
+    std::string gpuKey;
+    uint64_t sizeBytes = 0;
+    uint64_t files = 0;
+    int64_t loadedEntries = -1; // State cache entries DXVK read last session
+    int sessions = 0;
+  };
+
+  struct Stats {
+    uint64_t totalBytes = 0;
+    std::vector<VersionStats> versions;
+  };
+
+  // Fossilize tooling used for the post-install warm-up pass
+  struct WarmupSupport {
+    std::string replayer; // fossilize-replay binary, empty if missing
+    bool recorder = false; // VK_LAYER_fossilize manifest installed
+  };
+
+  static ShaderCache &instance();
+
+  // Identifies the GPU and driver build the caches are valid for
+  std::string gpuKey();
+
+  std::filesystem::path dirFor(const std::string &versionGUID);
+
+  // Points the cache variables at the version's directory
+  void configureEnvironment(wine::Prefix &pfx, const std::string &versionGUID);
+
+  // Seeds a freshly installed version from the newest cache for the same
+  // GPU, then prunes caches that can no longer be used. Safe to run in the
+  // background; never clobbers a cache DXVK already created.
+  void prewarm(const std::string &versionGUID);
+
+  // Drops caches for versions that are no longer installed, and DXVK state
+  // caches built by a different DXVK root.
+  void prune(const std::string &dxvkRoot);
+
+  WarmupSupport warmupSupport();
+
+  // True until a warm-up pass has completed for this version and GPU
+  bool needsWarmup(const std::string &versionGUID);
+
+  // Post-install stage: seeds the cache, replays recorded pipelines into the
+  // driver cache with fossilize-replay and pulls the Studio binaries and
+  // shaders into the page cache.
+  bool warmup(const std::string &versionGUID,
+              const std::filesystem::path &versionDir,
+              std::function<void(float, const std::string &)> progress);
+
+  // Picks hit information out of DXVK's log output
+  void observe(const std::string &versionGUID, const std::string &line);
+
+  Stats stats();
+  void clear();
+
+private:
+  ShaderCache() = default;
+
+  std::filesystem::path base() const;
+
+  std::mutex mutex_;
+  std::string gpuKey_;
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_SHADER_CACHE_HPP
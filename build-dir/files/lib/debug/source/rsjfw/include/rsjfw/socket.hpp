@@ -1,9 +1,13 @@
 #ifndef RSJFW_SOCKET_HPP
 #define RSJFW_SOCKET_HPP
 
+#include <chrono>
 #include <filesystem>
 #include <functional>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace rsjfw {
 
@@ -13,14 +17,54 @@ public:
   ~SingleInstance();
 
   // Returns true if this is the primary instance (acquired the lock).
-  // Returns false if another instance is already running.
-  bool isPrimary();
+  // Returns false if another instance is already running, after waiting
+  // up to `wait` for it to let go.
+  bool isPrimary(std::chrono::milliseconds wait = {});
 
 private:
   std::string lockPath_;
   int lockFd_ = -1;
 };
 
+// Unix socket the primary instance listens on for requests from later
+// invocations. A request is a list of strings, each NUL-terminated, ended
+// by the client shutting down its write side; the reply is one line,
+// "OK" or "ERR <reason>" by convention. Connections from other users are
+// refused (SO_PEERCRED). Only the holder of the SingleInstance lock should
+// listen, as listen() replaces whatever socket file is there.
+class CommandServer {
+public:
+  using Handler =
+      std::function<std::string(const std::vector<std::string> &request)>;
+
+  explicit CommandServer(const std::filesystem::path &socketPath);
+  ~CommandServer();
+
+  CommandServer(const CommandServer &) = delete;
+  CommandServer &operator=(const CommandServer &) = delete;
+
+  // Binds and serves on a thread of its own. `handler` runs on that
+  // thread, one request at a time.
+  bool listen(Handler handler);
+
+  // Sends `request` to the server at `socketPath`. The reply; empty if the
+  // request went out but no reply came; nullopt if nobody is listening or
+  // the request could not be sent.
+  static std::optional<std::string>
+  send(const std::filesystem::path &socketPath,
+       const std::vector<std::string> &request);
+
+private:
+  void serve(std::stop_token stop);
+  void handle(int client);
+
+  std::string socketPath_;
+  int listenFd_ = -1;
+  int stopFd_ = -1; // eventfd; wakes serve() for shutdown
+  Handler handler_;
+  std::jthread thread_;
+};
+
 } // namespace rsjfw
 
 #endif // RSJFW_SOCKET_HPP
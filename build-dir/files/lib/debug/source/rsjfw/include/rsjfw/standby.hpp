@@ -0,0 +1,57 @@
+#ifndef RSJFW_STANDBY_HPP
+#define RSJFW_STANDBY_HPP
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+
+namespace rsjfw {
+
+// What is left of the config editor while its window is closed and Studio
+// still runs. The GUI is shut down completely (window, GL context, ImGui
+// state, font atlas, logo texture) and freed heap is handed back to the
+// kernel, leaving a thread blocked on pidfds of the Studio processes and
+// the CommandServer thread. Running `rsjfw config` again brings it back;
+// a plain `rsjfw launch` makes it exit so the launch can take the lock.
+class Standby {
+public:
+  static Standby &instance();
+
+  enum class Wake {
+    SHOW,      // Someone asked for the window
+    NO_STUDIO, // No Studio left in the prefix
+    HAND_OFF   // Another invocation takes over; exit and free the lock
+  };
+
+  // Blocks until show is requested or no Studio runs in `prefixDir`.
+  // Returns NO_STUDIO at once if none is running now.
+  Wake wait(const std::filesystem::path &prefixDir);
+
+  // Safe from any thread. Ends wait(); while the window is up, the GUI
+  // raises it instead.
+  void requestShow();
+  // Consumes a pending request
+  bool takeShowRequest() { return showRequested_.exchange(false); }
+  // Ends a wait() in progress with HAND_OFF. False if not waiting, i.e.
+  // the window is up.
+  bool handOff();
+
+  Standby(const Standby &) = delete;
+  Standby &operator=(const Standby &) = delete;
+
+private:
+  Standby();
+  ~Standby();
+
+  void notify();
+
+  int eventFd_ = -1;
+  std::atomic<bool> showRequested_{false};
+  std::mutex mutex_; // waiting_, handOff_
+  bool waiting_ = false;
+  bool handOff_ = false;
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_STANDBY_HPP
@@ -0,0 +1,90 @@
+#ifndef RSJFW_STORAGE_HPP
+#define RSJFW_STORAGE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace rsjfw {
+
+struct StorageUsage {
+  struct Item {
+    std::string name;
+    std::filesystem::path path;
+    uint64_t bytes = 0;
+  };
+  std::vector<Item> items; // versions, wine, dxvk, downloads, logs, ...
+  uint64_t totalBytes = 0;
+  uint64_t freeBytes = 0; // On the filesystem holding the root
+  bool ready = false;
+};
+
+// Disk space under PathManager::root().
+//
+// discard() renames a tree into <root>/trash/, so it is gone from the
+// user's point of view at once, and a background task reclaims the space
+// with a parallel unlinkat walk. Trees on another disk are renamed to a
+// hidden sibling instead, with a symlink to it left in trash/. Whatever an
+// earlier run left in trash/ is picked up by sweep(). usage() is a snapshot
+// of how much each data directory takes, computed in the background by
+// refreshUsage().
+class Storage {
+public:
+  static Storage &instance();
+
+  // Moves `path` away and deletes it in the background. With `recreate`,
+  // an empty directory takes its place. False if `path` could not be moved.
+  bool discard(const std::filesystem::path &path, bool recreate = false);
+
+  // Deletes leftovers in trash/ from earlier runs
+  void sweep();
+
+  // Files and bytes reclaimed so far, and whether deletion is still running
+  struct Progress {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    size_t pending = 0; // Trees still queued or being deleted
+  };
+  Progress progress() const;
+
+  std::shared_ptr<const StorageUsage> usage() const {
+    return usage_.load(std::memory_order_acquire);
+  }
+  void refreshUsage();
+  bool measuring() const { return measuring_.load(); }
+
+  // Total size of the regular files below `root`, walked in parallel with
+  // statx. Stops early, with a partial sum, once `stop` is requested.
+  static uint64_t treeSize(const std::filesystem::path &root,
+                           std::stop_token stop = {});
+
+  Storage(const Storage &) = delete;
+  Storage &operator=(const Storage &) = delete;
+
+private:
+  Storage();
+
+  void enqueue(std::filesystem::path path);
+  void drain(std::stop_token stop);
+  void removeTree(const std::filesystem::path &path, std::stop_token stop);
+
+  mutable std::mutex mutex_; // queue_, draining_
+  std::deque<std::filesystem::path> queue_;
+  bool draining_ = false;
+  std::atomic<size_t> active_{0};
+  std::atomic<uint64_t> removedFiles_{0};
+  std::atomic<uint64_t> removedBytes_{0};
+
+  std::atomic<std::shared_ptr<const StorageUsage>> usage_;
+  std::atomic<bool> measuring_{false};
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_STORAGE_HPP
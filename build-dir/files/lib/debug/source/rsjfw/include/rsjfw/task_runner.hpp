@@ -4,19 +4,73 @@
 #include <functional>
 #include <thread>
 #include <vector>
+#include <deque>
 #include <mutex>
+#include <condition_variable>
 #include <memory>
 #include <future>
 #include <atomic>
+#include <chrono>
+#include <string>
+#include <stop_token>
+#include <type_traits>
 
 namespace rsjfw {
 
+enum class TaskPriority {
+    INTERACTIVE, // Someone is waiting on it: fetches, fixes, the launch itself
+    BACKGROUND   // Installs, indexing, maintenance
+};
+
+// Returned by TaskRunner::run(). Tasks see cancel() through the stop_token
+// they were given; a task cancelled before it starts is skipped. done() is
+// also true for a task that was never accepted; rejected() tells the two
+// apart.
+class TaskHandle {
+public:
+    TaskHandle() = default;
+
+    void cancel() { if (state_) state_->stop.request_stop(); }
+    bool done() const { return !state_ || state_->done.load(); }
+    bool rejected() const { return !state_ || state_->rejected; }
+
+private:
+    friend class TaskRunner;
+    struct State {
+        std::stop_source stop;
+        std::atomic<bool> done{false};
+        bool rejected = false; // Set before run() returns
+    };
+    std::shared_ptr<State> state_;
+};
+
+// Fixed pool of workers, one set per priority. Every worker owns a deque:
+// tasks submitted from a worker go to the back of its own deque, others are
+// spread round-robin, and idle workers steal from the front of their
+// siblings' deques. Background workers run each task at reduced CPU and
+// idle I/O priority while "performance.low_priority_background" is on, so
+// background tasks no longer lower their own.
 class TaskRunner {
 public:
+    using Task = std::function<void(std::stop_token)>;
+    using ProgressSink = std::function<void(const std::string& name, float progress,
+                                            const std::string& status)>;
+    using FinishSink = std::function<void(const std::string& name)>;
+
     static TaskRunner& instance();
 
-    // Runs a task in a managed jthread
-    void run(std::function<void()> task);
+    // `fn` takes a std::stop_token or nothing. A named task shows up as the
+    // worker's thread name and can report progress().
+    template<typename F>
+    TaskHandle run(F&& fn, TaskPriority priority = TaskPriority::INTERACTIVE,
+                   std::string name = {}) {
+        if constexpr (std::is_invocable_v<std::decay_t<F>&, std::stop_token>) {
+            return submit(Task(std::forward<F>(fn)), priority, std::move(name));
+        } else {
+            return submit([fn = std::forward<F>(fn)](std::stop_token) mutable { fn(); },
+                          priority, std::move(name));
+        }
+    }
 
     // Runs a task and returns a future for its result
     template<typename F, typename... Args>
@@ -26,16 +80,33 @@ public:
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
         std::future<return_type> res = task->get_future();
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        threads_.emplace_back([task]() {
-            (*task)();
-        });
-        
+        submit([task](std::stop_token) { (*task)(); }, TaskPriority::INTERACTIVE, {});
         return res;
     }
 
-    // Ensures all threads are joined. Called on app shutdown.
+    // Waits for `future`. On a worker, runs the tasks it queued itself in the
+    // meantime, so a task waiting on its own subtask cannot starve the pool.
+    template<typename T>
+    void wait(std::future<T>& future) {
+        if (!onWorker()) {
+            future.wait();
+            return;
+        }
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runLocal())
+                future.wait_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    // Reports progress for the named task running on this thread
+    static void progress(float progress, const std::string& status);
+    // Where progress() goes; the GUI shows it in its task list
+    void setProgressSink(ProgressSink sink);
+    // Told when a task that reported progress ends, however it ended
+    void setFinishSink(FinishSink sink);
+
+    // Cancels running tasks, drops queued ones and joins the workers.
+    // Called on app shutdown.
     void shutdown();
 
     ~TaskRunner();
@@ -46,8 +117,46 @@ public:
 private:
     TaskRunner() = default;
 
-    std::vector<std::jthread> threads_;
-    std::mutex mutex_;
+    struct Job {
+        Task fn;
+        std::shared_ptr<TaskHandle::State> state;
+        std::string name;
+    };
+
+    struct Worker {
+        std::mutex mutex; // jobs, current
+        std::deque<Job> jobs;
+        std::shared_ptr<TaskHandle::State> current;
+        std::jthread thread;
+        bool lowPriority = false; // Worker thread only
+    };
+
+    struct Pool {
+        explicit Pool(TaskPriority priority) : priority(priority) {}
+
+        TaskPriority priority;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<size_t> queued{0};
+        std::atomic<size_t> next{0};
+        std::mutex mutex; // Sleeping workers only
+        std::condition_variable_any cv;
+    };
+
+    TaskHandle submit(Task fn, TaskPriority priority, std::string name);
+    void start();
+    void workerLoop(std::stop_token stop, Pool& pool, size_t index);
+    bool take(Pool& pool, size_t index, Job& job);
+    bool runLocal();
+    void execute(Worker& worker, Job& job);
+    static bool onWorker();
+
+    Pool interactive_{TaskPriority::INTERACTIVE};
+    Pool background_{TaskPriority::BACKGROUND};
+    std::mutex mutex_; // started_, stopping_, sink_, finishSink_
+    bool started_ = false;
+    bool stopping_ = false;
+    ProgressSink sink_;
+    FinishSink finishSink_;
 };
 
 } // namespace rsjfw
@@ -0,0 +1,57 @@
+#ifndef RSJFW_UPDATER_HPP
+#define RSJFW_UPDATER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+namespace rsjfw {
+
+// Fetches Studio updates before they are needed. While RSJFW or Studio
+// runs, a background-priority thread asks for the latest version every
+// "versions.prefetch_interval_minutes" and stages anything new with
+// Downloader::installVersion(), downloads capped at
+// "versions.prefetch_limit_kbps". The next launch then finds it installed.
+// Checks are skipped while NetworkManager reports a metered connection.
+// An install cut short by stop() resumes from its staging directory.
+class Updater {
+public:
+  static Updater &instance();
+
+  // Starts polling, first after `delay`; later calls do nothing
+  void start(std::chrono::seconds delay = std::chrono::minutes(2));
+  // Aborts a running download and joins. Call before installing in the
+  // foreground so the two do not share the staging directory.
+  void stop();
+
+  bool installing() const { return installing_.load(); }
+  // Last version staged by this process, or empty
+  std::string staged() const;
+
+  // True if NetworkManager says the default connection is metered. False
+  // when that cannot be told, e.g. without NetworkManager or gdbus.
+  static bool metered();
+
+  Updater(const Updater &) = delete;
+  Updater &operator=(const Updater &) = delete;
+
+private:
+  Updater() = default;
+  ~Updater();
+
+  void loop(std::stop_token stop, std::chrono::seconds delay);
+  void check(std::stop_token stop);
+
+  mutable std::mutex mutex_; // worker_, staged_
+  std::jthread worker_;
+  std::string staged_;
+  std::atomic<bool> installing_{false};
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_UPDATER_HPP
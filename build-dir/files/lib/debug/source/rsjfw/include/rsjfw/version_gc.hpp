@@ -0,0 +1,46 @@
+#ifndef RSJFW_VERSION_GC_HPP
+#define RSJFW_VERSION_GC_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <string>
+
+namespace rsjfw {
+
+// Keeps versions/ from growing by a full Studio tree every update. Once the
+// newest install has launched, everything but the "versions.keep" most
+// recent installs, the pinned ones and the robloxVersion override goes to
+// Storage::discard(). Versions a running process was started from are left
+// alone. Each pass also drops downloads/*.part files and version
+// directories without AppSettings.xml that nobody has touched for a while.
+class VersionGC {
+public:
+  static VersionGC &instance();
+
+  // Runs a pass on a background-priority worker after `launched` started;
+  // calls coalesce
+  void schedule(const std::string &launched = "");
+  // Returns the bytes reclaimed
+  uint64_t run(const std::string &launched = "", std::stop_token stop = {});
+
+  // Bytes reclaimed by the last pass
+  uint64_t lastReclaimed() const { return lastReclaimed_.load(); }
+  bool running() const { return queued_.load() || busy_.load(); }
+
+  VersionGC(const VersionGC &) = delete;
+  VersionGC &operator=(const VersionGC &) = delete;
+
+private:
+  VersionGC() = default;
+
+  std::mutex runMutex_;
+  std::atomic<bool> queued_{false};
+  std::atomic<bool> busy_{false};
+  std::atomic<uint64_t> lastReclaimed_{0};
+};
+
+} // namespace rsjfw
+
+#endif // RSJFW_VERSION_GC_HPP
@@ -7,6 +7,8 @@
 #include <memory>
 #include <filesystem>
 #include <functional>
+#include <spawn.h>
+#include <sys/types.h>
 
 namespace rsjfw {
 namespace wine {
@@ -31,7 +33,12 @@ public:
     void appendEnv(const std::string& key, const std::string& value);
     std::string getEnv(const std::string& key) const;
 
-    // Runs a command within the Wineprefix
+    // Restricts processes started from this prefix to the given CPUs
+    // (empty = no restriction)
+    void setCpuAffinity(const std::vector<int>& cpus) { cpuAffinity_ = cpus; }
+
+    // Runs a command within the Wineprefix, started with posix_spawn so the
+    // (large, multi-threaded) GUI process is never forked
     // Returns true on success (exit code 0), false otherwise
     // onOutput: Optional callback for stdout/stderr streaming
     // cwd: Optional working directory for the process
@@ -40,6 +47,11 @@ public:
     // Wrapper to run 'wine' or 'wine64' based on availability
     bool wine(const std::string& exe, const std::vector<std::string>& args, std::function<void(const std::string&)> onOutput = nullptr, const std::string& cwd = "", bool wait = true);
 
+    // Starts `target` under Wine with stdin and stdout on pipes, for
+    // talking to a long-lived process. The caller owns both fds and must
+    // reap the returned pid. -1 on failure.
+    pid_t winePiped(const std::string& target, const std::vector<std::string>& args, int& toChild, int& fromChild);
+
     // Helper to resolve a binary path (accounting for Proton structure)
     std::string bin(const std::string& prog) const;
 
@@ -61,9 +73,24 @@ private:
     std::string root_;
     std::string dir_;
     std::map<std::string, std::string> env_;
-    
-    // Internal helper to construct full environment vector
-    std::vector<std::string> buildEnv() const;
+    std::vector<int> cpuAffinity_;
+
+    // The child environment: the process environment at the time it was
+    // built, with env_ and WINEPREFIX on top. Immutable and shared, so the
+    // pointers stay valid when the Prefix is copied.
+    struct EnvBlock {
+        std::vector<std::string> strings;
+        std::vector<char*> envp; // Into strings, null-terminated
+    };
+    // Built on first use and kept until setEnv()/appendEnv()
+    mutable std::shared_ptr<const EnvBlock> envCache_;
+    const EnvBlock& envBlock() const;
+
+    // posix_spawnp() with the cached environment, affinity and a clean
+    // signal state. Returns 0 or the errno, which is logged.
+    int spawn(const std::string& exe, const std::vector<std::string>& args, const posix_spawn_file_actions_t* actions, pid_t& pid) const;
+    // The Wine (or Proton) binary and arguments that run `target`
+    std::string wineCommand(const std::string& target, const std::vector<std::string>& args, std::vector<std::string>& finalArgs) const;
 };
 
 } // namespace wine
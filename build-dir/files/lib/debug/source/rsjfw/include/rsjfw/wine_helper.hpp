@@ -0,0 +1,73 @@
+#ifndef RSJFW_WINE_HELPER_HPP
+#define RSJFW_WINE_HELPER_HPP
+
+#include "rsjfw/wine.hpp"
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace rsjfw {
+namespace wine {
+
+// One rsjfw-helper.exe (src/helper) running inside a prefix, fed requests
+// over a pipe. Registry and file queries then share a single Wine process
+// start instead of paying for a `wine reg` each. Started on first use and
+// told to quit on destruction; keep one for a setup phase.
+//
+// Every query returns nullopt (or false) when the helper is not installed,
+// failed to start or stopped answering, and the caller falls back to the
+// standalone Wine tools. Once failed, a session stays failed.
+class HelperSession {
+public:
+  explicit HelperSession(Prefix &pfx);
+  ~HelperSession();
+
+  HelperSession(const HelperSession &) = delete;
+  HelperSession &operator=(const HelperSession &) = delete;
+
+  // Starts the helper if needed; false if it cannot be used
+  bool available();
+
+  struct RegValue {
+    std::string type; // REG_SZ, REG_DWORD, REG_BINARY, ...
+    std::string data; // REG_DWORD in decimal, REG_BINARY in plain hex
+  };
+
+  std::optional<bool> regExists(const std::string &key,
+                                const std::string &valueName);
+  // nullopt both when the value is missing and when the helper failed;
+  // failed() tells the two apart
+  std::optional<RegValue> regRead(const std::string &key,
+                                  const std::string &valueName);
+  bool regWrite(const std::string &key, const std::string &valueName,
+                const std::string &type, const std::string &value);
+  // `path` is a Windows path, e.g. C:\windows\system32\d3d11.dll
+  std::optional<bool> fileExists(const std::string &path);
+  std::optional<std::string> env(const std::string &name);
+
+  bool failed() const { return failed_; }
+
+private:
+  bool start();
+  void stop();
+  void fail(const std::string &why);
+  // Sends one request; the reply's fields after OK/ERR, with `ok` set.
+  // nullopt if the helper did not answer.
+  std::optional<std::vector<std::string>>
+  call(const std::vector<std::string> &request, bool &ok);
+  bool readLine(std::string &line, int timeoutMs);
+
+  Prefix &pfx_;
+  pid_t pid_ = -1;
+  int toHelper_ = -1;
+  int fromHelper_ = -1;
+  bool started_ = false;
+  bool failed_ = false;
+  std::string pending_; // Read but not yet consumed
+};
+
+} // namespace wine
+} // namespace rsjfw
+
+#endif // RSJFW_WINE_HELPER_HPP
@@ -1,44 +1,81 @@
 #include "rsjfw/config.hpp"
 #include "rsjfw/logger.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <unistd.h>
 
 namespace rsjfw {
 
 using json = nlohmann::json;
 
+namespace {
+// A burst of save() calls (slider drags, installs) becomes one write once
+// it has been quiet this long, but never waits more than SAVE_MAX_DELAY
+constexpr auto SAVE_DEBOUNCE = std::chrono::milliseconds(500);
+constexpr auto SAVE_MAX_DELAY = std::chrono::seconds(5);
+} // namespace
+
 Config &Config::instance() {
   static Config instance;
   return instance;
 }
 
-void Config::load(const std::filesystem::path &path) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  configPath_ = path;
+Config::Config() : current_(std::make_shared<const ConfigSnapshot>()) {}
+
+void Config::update(const std::function<void(ConfigSnapshot &)> &fn) {
+  {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    auto next = std::make_shared<ConfigSnapshot>(*snapshot());
+    fn(*next);
+    current_.store(std::move(next), std::memory_order_release);
+  }
+  save();
+}
+
+void Config::load(const std::filesystem::path &path, bool normalize) {
+  {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    configPath_ = path;
+  }
 
   if (!std::filesystem::exists(path)) {
     LOG_WARN("Config file not found at " + path.string() + ". Using defaults.");
-    save();
+    if (normalize)
+      save();
     return;
   }
 
   try {
     std::ifstream file(path);
-    json j;
-    file >> j;
+    std::string contents((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    {
+      std::lock_guard<std::mutex> writeLock(writeMutex_);
+      savedHash_ = std::hash<std::string>{}(contents);
+    }
+    json j = json::parse(contents);
+
+    ConfigSnapshot next;
+    auto &general = next.general;
 
     if (j.contains("general")) {
       auto &g = j["general"];
-      general_.renderer = g.value("renderer", "D3D11");
-      general_.dxvk = g.value("dxvk", true);
+      general.renderer = g.value("renderer", "D3D11");
+      general.dxvk = g.value("dxvk", true);
+      general.shaderWarmup = g.value("shader_warmup", false);
+      general.standby = g.value("standby", true);
 
       // v2.1: Load new source config format, or migrate from old
       if (g.contains("wine_source_config")) {
         auto &ws = g["wine_source_config"];
-        general_.wineSource.repo = ws.value("repo", "vinegarhq/wine-builds");
-        general_.wineSource.version = ws.value("version", "latest");
-        general_.wineSource.asset = ws.value("asset", "");
-        general_.wineSource.installedRoot = ws.value("installed_root", "");
+        general.wineSource.repo = ws.value("repo", "vinegarhq/wine-builds");
+        general.wineSource.version = ws.value("version", "latest");
+        general.wineSource.asset = ws.value("asset", "");
+        general.wineSource.installedRoot = ws.value("installed_root", "");
       } else {
         // Migrate from old format
         std::string oldSource = "";
@@ -59,27 +96,27 @@ void Config::load(const std::filesystem::path &path) {
         }
         // Convert known keywords to repos
         if (oldSource == "VINEGAR")
-          general_.wineSource.repo = "vinegarhq/wine-builds";
+          general.wineSource.repo = "vinegarhq/wine-builds";
         else if (oldSource == "GE-PROTON")
-          general_.wineSource.repo = "GloriousEggroll/proton-ge-custom";
+          general.wineSource.repo = "GloriousEggroll/proton-ge-custom";
         else if (oldSource == "CACHY-PROTON")
-          general_.wineSource.repo = "CachyOS/proton-cachyos";
+          general.wineSource.repo = "CachyOS/proton-cachyos";
         else if (!oldSource.empty() && oldSource.find('/') != std::string::npos)
-          general_.wineSource.repo = oldSource;
+          general.wineSource.repo = oldSource;
         else
-          general_.wineSource.repo = "vinegarhq/wine-builds";
+          general.wineSource.repo = "vinegarhq/wine-builds";
 
-        general_.wineSource.version = g.value("wine_version", "latest");
-        general_.wineSource.installedRoot = g.value("wine_root", "");
+        general.wineSource.version = g.value("wine_version", "latest");
+        general.wineSource.installedRoot = g.value("wine_root", "");
       }
 
       // v2.1: Load DXVK source config
       if (g.contains("dxvk_source_config")) {
         auto &ds = g["dxvk_source_config"];
-        general_.dxvkSource.repo = ds.value("repo", "doitsujin/dxvk");
-        general_.dxvkSource.version = ds.value("version", "latest");
-        general_.dxvkSource.asset = ds.value("asset", "");
-        general_.dxvkSource.installedRoot = ds.value("installed_root", "");
+        general.dxvkSource.repo = ds.value("repo", "doitsujin/dxvk");
+        general.dxvkSource.version = ds.value("version", "latest");
+        general.dxvkSource.asset = ds.value("asset", "");
+        general.dxvkSource.installedRoot = ds.value("installed_root", "");
       } else {
         // Migrate from old format
         std::string oldSource = "";
@@ -97,110 +134,274 @@ void Config::load(const std::filesystem::path &path) {
           }
         }
         if (!oldSource.empty() && oldSource.find('/') != std::string::npos)
-          general_.dxvkSource.repo = oldSource;
+          general.dxvkSource.repo = oldSource;
         else
-          general_.dxvkSource.repo = "doitsujin/dxvk";
+          general.dxvkSource.repo = "doitsujin/dxvk";
 
-        general_.dxvkSource.version = g.value("dxvk_version", "latest");
-        general_.dxvkSource.installedRoot = g.value("dxvk_root", "");
+        general.dxvkSource.version = g.value("dxvk_version", "latest");
+        general.dxvkSource.installedRoot = g.value("dxvk_root", "");
       }
 
       // Keep legacy fields for backwards compat with older code paths
-      general_.dxvkVersion = general_.dxvkSource.version;
-      general_.dxvkRoot = general_.dxvkSource.installedRoot;
-      general_.wineVersion = general_.wineSource.version;
-      general_.wineRoot = general_.wineSource.installedRoot;
-      general_.dxvkCustomPath = g.value("dxvk_custom_path", "");
-      general_.dxvkCustomUrl = g.value("dxvk_custom_url", "");
-      general_.wineCustomUrl = g.value("wine_custom_url", "");
-
-      general_.robloxVersion = g.value("roblox_version", "");
-      general_.channel = g.value("channel", "production");
-      general_.selectedGpu = g.value("selected_gpu", -1);
+      general.dxvkVersion = general.dxvkSource.version;
+      general.dxvkRoot = general.dxvkSource.installedRoot;
+      general.wineVersion = general.wineSource.version;
+      general.wineRoot = general.wineSource.installedRoot;
+      general.dxvkCustomPath = g.value("dxvk_custom_path", "");
+      general.dxvkCustomUrl = g.value("dxvk_custom_url", "");
+      general.wineCustomUrl = g.value("wine_custom_url", "");
+
+      general.robloxVersion = g.value("roblox_version", "");
+      general.channel = g.value("channel", "production");
+      general.selectedGpu = g.value("selected_gpu", -1);
 
       if (g.contains("env")) {
         for (auto &[key, val] : g["env"].items()) {
-          general_.customEnv[key] = val;
+          general.customEnv[key] = val;
         }
       }
     }
 
     if (j.contains("wine")) {
       auto &w = j["wine"];
-      wine_.desktopMode = w.value("desktop_mode", false);
-      wine_.multipleDesktops = w.value("multiple_desktops", false);
-      wine_.desktopResolution = w.value("desktop_resolution", "1920x1080");
+      next.wine.desktopMode = w.value("desktop_mode", false);
+      next.wine.multipleDesktops = w.value("multiple_desktops", false);
+      next.wine.desktopResolution = w.value("desktop_resolution", "1920x1080");
+    }
+
+    if (j.contains("performance")) {
+      auto &p = j["performance"];
+      if (p.contains("sync_mode"))
+        next.performance.syncMode = p.value("sync_mode", "auto");
+      else
+        next.performance.syncMode =
+            p.value("fast_sync", true) ? "auto" : "esync";
+      next.performance.gamemode = p.value("gamemode", false);
+      next.performance.studioCpus = p.value("studio_cpus", "");
+      next.performance.wineserverCpu = p.value("wineserver_cpu", -1);
+      next.performance.lowPriorityBackground =
+          p.value("low_priority_background", true);
+    }
+
+    if (j.contains("logs")) {
+      auto &l = j["logs"];
+      next.logs.rotateMB = l.value("rotate_mb", 64);
+      next.logs.maxAgeDays = l.value("max_age_days", 30);
+      next.logs.maxTotalMB = l.value("max_total_mb", 1024);
+      next.logs.compress = l.value("compress", true);
+    }
+
+    if (j.contains("versions")) {
+      auto &v = j["versions"];
+      next.versions.keep = v.value("keep", 2);
+      next.versions.pinned = v.value("pinned", std::vector<std::string>{});
+      next.versions.autoClean = v.value("auto_clean", true);
+      next.versions.prefetch = v.value("prefetch", true);
+      next.versions.prefetchIntervalMinutes =
+          v.value("prefetch_interval_minutes", 60);
+      next.versions.prefetchLimitKBps = v.value("prefetch_limit_kbps", 4096);
     }
 
     if (j.contains("fflags")) {
-      fflags_.clear();
+      next.fflags.clear();
       for (auto &[key, val] : j["fflags"].items()) {
-        fflags_[key] = val;
+        next.fflags[key] = val;
       }
     }
 
+    {
+      std::lock_guard<std::mutex> lock(updateMutex_);
+      current_.store(std::make_shared<const ConfigSnapshot>(std::move(next)),
+                     std::memory_order_release);
+    }
     LOG_INFO("Configuration loaded from " + path.string());
-    save();
+    if (normalize)
+      save();
 
   } catch (const std::exception &e) {
     LOG_ERROR("Failed to parse config file: " + std::string(e.what()));
   }
 }
 
+Config::~Config() {
+  if (saver_.joinable()) {
+    saver_.request_stop();
+    saver_.join();
+  }
+  if (dirty_)
+    flush();
+}
+
 void Config::save() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  if (configPath_.empty())
+  {
+    std::lock_guard<std::mutex> lock(saveMutex_);
+    dirty_ = true;
+    lastSaveRequest_ = std::chrono::steady_clock::now();
+    if (!saver_.joinable())
+      saver_ = std::jthread([this](std::stop_token stop) { saverLoop(stop); });
+  }
+  saveCv_.notify_one();
+}
+
+void Config::flush() {
+  {
+    std::lock_guard<std::mutex> lock(saveMutex_);
+    dirty_ = false;
+  }
+  write();
+}
+
+void Config::saverLoop(std::stop_token stop) {
+  std::unique_lock<std::mutex> lock(saveMutex_);
+  while (saveCv_.wait(lock, stop, [this] { return dirty_; })) {
+    auto latest = std::chrono::steady_clock::now() + SAVE_MAX_DELAY;
+    for (;;) {
+      auto deadline = std::min(lastSaveRequest_ + SAVE_DEBOUNCE, latest);
+      if (std::chrono::steady_clock::now() >= deadline)
+        break;
+      saveCv_.wait_until(lock, stop, deadline, [] { return false; });
+      if (stop.stop_requested())
+        return; // The destructor flushes
+    }
+    if (!dirty_)
+      continue; // flush() got there first
+    dirty_ = false;
+    lock.unlock();
+    write();
+    lock.lock();
+  }
+}
+
+void Config::write() {
+  std::lock_guard<std::mutex> writeLock(writeMutex_);
+  std::filesystem::path path;
+  std::string data;
+  {
+    std::lock_guard<std::mutex> lock(updateMutex_);
+    path = configPath_;
+  }
+  if (path.empty())
+    return;
+  try {
+    data = serialize(*snapshot());
+  } catch (const std::exception &e) {
+    LOG_ERROR("Failed to serialize config: " + std::string(e.what()));
+    return;
+  }
+
+  size_t hash = std::hash<std::string>{}(data);
+  if (hash == savedHash_ && std::filesystem::exists(path))
+    return; // Same bytes as on disk
+
+  std::error_code ec;
+  if (path.has_parent_path())
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+  // Write a sibling, fsync it and rename it over the old file so a crash
+  // leaves either the old or the new config, never a truncated one
+  std::filesystem::path tmp = path;
+  tmp += ".tmp";
+  int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  bool ok = fd >= 0;
+  size_t done = 0;
+  while (ok && done < data.size()) {
+    ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+    if (n < 0 && errno == EINTR)
+      continue;
+    ok = n > 0;
+    if (ok)
+      done += n;
+  }
+  ok = ok && ::fsync(fd) == 0;
+  int err = errno;
+  if (fd >= 0)
+    ::close(fd);
+  if (ok) {
+    std::filesystem::rename(tmp, path, ec);
+    ok = !ec;
+    err = ec.value();
+  }
+  if (!ok) {
+    std::filesystem::remove(tmp, ec);
+    LOG_ERROR("Failed to write config file: " +
+              std::string(std::strerror(err)));
     return;
+  }
 
-  if (configPath_.has_parent_path()) {
-    std::filesystem::create_directories(configPath_.parent_path());
+  std::filesystem::path dir =
+      path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+  int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirFd >= 0) {
+    ::fsync(dirFd);
+    ::close(dirFd);
   }
 
+  savedHash_ = hash;
+  LOG_INFO("Configuration saved to " + path.string());
+}
+
+std::string Config::serialize(const ConfigSnapshot &config) {
+  const auto &general = config.general;
   json j;
 
   // v2.1: Save new source config format
-  j["general"] = {{"renderer", general_.renderer},
-                  {"dxvk", general_.dxvk},
+  j["general"] = {{"renderer", general.renderer},
+                  {"dxvk", general.dxvk},
+                  {"shader_warmup", general.shaderWarmup},
+                  {"standby", general.standby},
                   {"wine_source_config",
-                   {{"repo", general_.wineSource.repo},
-                    {"version", general_.wineSource.version},
-                    {"asset", general_.wineSource.asset},
-                    {"installed_root", general_.wineSource.installedRoot}}},
+                   {{"repo", general.wineSource.repo},
+                    {"version", general.wineSource.version},
+                    {"asset", general.wineSource.asset},
+                    {"installed_root", general.wineSource.installedRoot}}},
                   {"dxvk_source_config",
-                   {{"repo", general_.dxvkSource.repo},
-                    {"version", general_.dxvkSource.version},
-                    {"asset", general_.dxvkSource.asset},
-                    {"installed_root", general_.dxvkSource.installedRoot}}},
-                  {"roblox_version", general_.robloxVersion},
-                  {"channel", general_.channel},
-                  {"selected_gpu", general_.selectedGpu}};
+                   {{"repo", general.dxvkSource.repo},
+                    {"version", general.dxvkSource.version},
+                    {"asset", general.dxvkSource.asset},
+                    {"installed_root", general.dxvkSource.installedRoot}}},
+                  {"roblox_version", general.robloxVersion},
+                  {"channel", general.channel},
+                  {"selected_gpu", general.selectedGpu}};
 
   j["general"]["env"] = json::object();
-  for (const auto &[key, val] : general_.customEnv) {
+  for (const auto &[key, val] : general.customEnv) {
     j["general"]["env"][key] = val;
   }
 
-  j["wine"]["desktop_mode"] = wine_.desktopMode;
-  j["wine"]["multiple_desktops"] = wine_.multipleDesktops;
-  j["wine"]["desktop_resolution"] = wine_.desktopResolution;
+  j["wine"]["desktop_mode"] = config.wine.desktopMode;
+  j["wine"]["multiple_desktops"] = config.wine.multipleDesktops;
+  j["wine"]["desktop_resolution"] = config.wine.desktopResolution;
+
+  j["performance"]["sync_mode"] = config.performance.syncMode;
+  j["performance"]["gamemode"] = config.performance.gamemode;
+  j["performance"]["studio_cpus"] = config.performance.studioCpus;
+  j["performance"]["wineserver_cpu"] = config.performance.wineserverCpu;
+  j["performance"]["low_priority_background"] =
+      config.performance.lowPriorityBackground;
+
+  j["logs"]["rotate_mb"] = config.logs.rotateMB;
+  j["logs"]["max_age_days"] = config.logs.maxAgeDays;
+  j["logs"]["max_total_mb"] = config.logs.maxTotalMB;
+  j["logs"]["compress"] = config.logs.compress;
+
+  j["versions"]["keep"] = config.versions.keep;
+  j["versions"]["pinned"] = config.versions.pinned;
+  j["versions"]["auto_clean"] = config.versions.autoClean;
+  j["versions"]["prefetch"] = config.versions.prefetch;
+  j["versions"]["prefetch_interval_minutes"] =
+      config.versions.prefetchIntervalMinutes;
+  j["versions"]["prefetch_limit_kbps"] = config.versions.prefetchLimitKBps;
 
   j["fflags"] = json::object();
-  for (const auto &[key, val] : fflags_) {
+  for (const auto &[key, val] : config.fflags) {
     j["fflags"][key] = val;
   }
 
-  try {
-    std::ofstream file(configPath_);
-    file << j.dump(4);
-    LOG_INFO("Configuration saved to " + configPath_.string());
-  } catch (const std::exception &e) {
-    LOG_ERROR("Failed to write config file: " + std::string(e.what()));
-  }
+  return j.dump(4);
 }
 
 void Config::setFFlag(const std::string &key, const nlohmann::json &value) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  fflags_[key] = value;
+  update([&](ConfigSnapshot &config) { config.fflags[key] = value; });
 }
 
 } // namespace rsjfw
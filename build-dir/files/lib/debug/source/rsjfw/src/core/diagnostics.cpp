@@ -23,7 +23,14 @@ Diagnostics &Diagnostics::instance() {
   return instance;
 }
 
+std::vector<std::pair<std::string, HealthStatus>>
+Diagnostics::getResults() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return results_;
+}
+
 int Diagnostics::failureCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
   int count = 0;
   for (const auto &check : results_) {
     if (!check.second.ok)
@@ -37,17 +44,27 @@ void Diagnostics::fixIssue(const std::string &name,
   // Provide a no-op callback if nullptr to prevent bad_function_call
   auto safeCb = progressCb ? progressCb : [](float, std::string) {};
 
-  for (const auto &check : results_) {
-    if (check.first == name && check.second.fixable && check.second.fixAction) {
-      check.second.fixAction(safeCb);
-      return;
+  // Run outside the lock; fixes take a while and may report progress
+  std::function<void(std::function<void(float, std::string)>)> fix;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &check : results_) {
+      if (check.first == name && check.second.fixable &&
+          check.second.fixAction) {
+        fix = check.second.fixAction;
+        break;
+      }
     }
   }
-  safeCb(0.0f, "Issue not found or not fixable");
+  if (fix)
+    fix(safeCb);
+  else
+    safeCb(0.0f, "Issue not found or not fixable");
 }
 
 bool Diagnostics::runChecks() {
-  results_.clear();
+  std::lock_guard<std::mutex> runLock(runMutex_);
+  pending_.clear();
 
   checkRoot();
   checkConfig();
@@ -60,13 +77,17 @@ bool Diagnostics::runChecks() {
   checkFlatpak();
   checkSystem();
 
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.swap(pending_);
+  }
   return failureCount() == 0;
 }
 
 void Diagnostics::checkRoot() {
   auto &pm = PathManager::instance();
   bool rootOk = std::filesystem::exists(pm.root());
-  results_.push_back({"RSJFW Root",
+  pending_.push_back({"RSJFW Root",
                       {rootOk,
                        rootOk ? "Accessible" : "Missing/Inaccessible",
                        pm.root().string(),
@@ -86,16 +107,17 @@ void Diagnostics::checkConfig() {
       !configOk,
       [pm](std::function<void(float, std::string)> cb) {
         cb(0.1f, "Regenerating Config...");
-        Config::instance().save();
+        Config::instance().flush();
         cb(1.0f, "Complete");
       },
       HealthCategory::CONFIG,
       {"json", "settings"}};
-  results_.push_back({"Configuration", configStatus});
+  pending_.push_back({"Configuration", configStatus});
 }
 
 void Diagnostics::checkWine() {
-  auto &cfg = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &cfg = config->general;
   auto appState = State::instance().get();
   bool downloadingWine = (appState == AppState::DOWNLOADING_WINE);
 
@@ -156,7 +178,8 @@ void Diagnostics::checkWine() {
           return;
         }
 
-        auto &cfgInst = Config::instance().getGeneral();
+        auto configInst = Config::instance().snapshot();
+        const auto &cfgInst = configInst->general;
 
         // Determine the Wine source to download from
         std::string repo = "";
@@ -200,7 +223,7 @@ void Diagnostics::checkWine() {
       },
       HealthCategory::WINE,
       {"runner", "dxvk"}};
-  results_.push_back({"Wine Source", wineStatus});
+  pending_.push_back({"Wine Source", wineStatus});
 }
 
 void Diagnostics::checkLayer() {
@@ -249,7 +272,7 @@ void Diagnostics::checkLayer() {
   else if (!layerOk && canBuild)
     layerStatus.detail = "Library missing. Click FIX to build from source.";
 
-  results_.push_back({"RSJFW Layer", layerStatus});
+  pending_.push_back({"RSJFW Layer", layerStatus});
 }
 
 void Diagnostics::checkPrefix() {
@@ -271,7 +294,7 @@ void Diagnostics::checkPrefix() {
                             },
                             HealthCategory::WINE,
                             {"prefix", "registry"}};
-  results_.push_back({"Wine Prefix", pfxHealth});
+  pending_.push_back({"Wine Prefix", pfxHealth});
 }
 
 void Diagnostics::checkDesktop() {
@@ -341,7 +364,7 @@ void Diagnostics::checkDesktop() {
         "Enforcing local helper for dev build: " + pm.rsjfwExe().string();
   }
 
-  results_.push_back({"Desktop Entry", desktopStatus});
+  pending_.push_back({"Desktop Entry", desktopStatus});
 }
 
 void Diagnostics::checkProtocol() {
@@ -373,7 +396,7 @@ void Diagnostics::checkProtocol() {
       },
       HealthCategory::SYSTEM,
       {"integration", "protocol"}};
-  results_.push_back({"Protocol Handlers", protoStatus});
+  pending_.push_back({"Protocol Handlers", protoStatus});
 }
 
 void Diagnostics::checkLegacy() {
@@ -393,7 +416,7 @@ void Diagnostics::checkLegacy() {
         },
         HealthCategory::LEGACY,
         {"migration", "cleanup"}};
-    results_.push_back({"Legacy Data", legacyStatus});
+    pending_.push_back({"Legacy Data", legacyStatus});
   }
 
   std::filesystem::path legacyConfig = std::filesystem::path(getenv("HOME")) /
@@ -419,7 +442,7 @@ void Diagnostics::checkLegacy() {
         },
         HealthCategory::LEGACY,
         {"migration", "cleanup"}};
-    results_.push_back({"Legacy Config", legacyCfgStatus});
+    pending_.push_back({"Legacy Config", legacyCfgStatus});
   }
 }
 
@@ -455,12 +478,12 @@ void Diagnostics::checkFlatpak() {
     if (!canWrite)
       fpStatus.detail = "RSJFW cannot write to its data directory inside "
                         "Flatpak. Check permissions.";
-    results_.push_back({"Environment", fpStatus});
+    pending_.push_back({"Environment", fpStatus});
 
     // 2. Check XDG Portal (rough check)
     bool hasPortal = (std::getenv("DBUS_SESSION_BUS_ADDRESS") != nullptr);
     if (!hasPortal) {
-      results_.push_back({"Desktop Portal",
+      pending_.push_back({"Desktop Portal",
                           {false,
                            "Missing DBus",
                            "xdg-desktop-portal",
@@ -508,7 +531,7 @@ void Diagnostics::checkSystem() {
                               {"dependency", "build"}};
   if (!buildToolsOk)
     buildStatus.detail = "Install these packages to enable source-based fixes.";
-  results_.push_back({"Build Tools", buildStatus});
+  pending_.push_back({"Build Tools", buildStatus});
 
   // 2. Vulkan Tools - use 'which' for faster detection
   bool vkToolsOk = (system("which vulkaninfo > /dev/null 2>&1") == 0);
@@ -522,12 +545,12 @@ void Diagnostics::checkSystem() {
                                 {"dependency", "vulkan"}};
   if (!vkToolsOk)
     vkToolsStatus.detail = "Install vulkan-tools for better diagnostics.";
-  results_.push_back({"Vulkan Tools", vkToolsStatus});
+  pending_.push_back({"Vulkan Tools", vkToolsStatus});
 
   // 3. Graphics Info - use 'which' for faster detection
   bool glxOk = (system("which glxinfo > /dev/null 2>&1") == 0);
   if (!glxOk) {
-    results_.push_back({"Graphics Info",
+    pending_.push_back({"Graphics Info",
                         {false,
                          "Missing glxinfo",
                          "mesa-utils",
@@ -561,7 +584,8 @@ void Diagnostics::checkSystem() {
         int major = 0, minor = 0;
         sscanf(result.c_str(), "%d.%d", &major, &minor);
 
-        std::string configDxvk = Config::instance().getGeneral().dxvkVersion;
+        std::string configDxvk =
+            Config::instance().snapshot()->general.dxvkVersion;
 
         // Logic: DXVK 2.0+ requires Vulkan 1.3
         // DXVK 1.10.x requires Vulkan 1.1
@@ -590,13 +614,14 @@ void Diagnostics::checkSystem() {
             gpuIssue,
             [](std::function<void(float, std::string)> cb) {
               cb(0.5f, "Configuring Sarek/Legacy DXVK...");
-              auto &cfg = Config::instance().getGeneral();
-              cfg.dxvkSource.version = "v1.10.3";
-              cfg.dxvkSource.repo =
-                  "doitsujin/dxvk"; // Ensure using official repo
-              cfg.dxvkSource.installedRoot =
-                  ""; // Clear root to trigger re-download of new version
-              Config::instance().save();
+              Config::instance().update([](ConfigSnapshot &next) {
+                auto &cfg = next.general;
+                cfg.dxvkSource.version = "v1.10.3";
+                cfg.dxvkSource.repo =
+                    "doitsujin/dxvk"; // Ensure using official repo
+                cfg.dxvkSource.installedRoot =
+                    ""; // Clear root to trigger re-download of new version
+              });
               cb(1.0f,
                  "Set DXVK to v1.10.3 (Sarek) - Will download on next save");
             },
@@ -609,7 +634,7 @@ void Diagnostics::checkSystem() {
                              " (Requires 1.3). Recommend: Sarek/1.10.3.";
         }
         // Always push back status so user sees checks passed
-        results_.push_back({"GPU Compatibility", gpuStatus});
+        pending_.push_back({"GPU Compatibility", gpuStatus});
       }
     }
   }
@@ -2,10 +2,14 @@
 #include "rsjfw/config.hpp"
 #include "rsjfw/http.hpp"
 #include "rsjfw/logger.hpp"
+#include "rsjfw/md5.hpp"
 #include "rsjfw/path_manager.hpp"
+#include "rsjfw/release_cache.hpp"
+#include "rsjfw/storage.hpp"
 #include "rsjfw/task_runner.hpp"
 #include "rsjfw/zip_util.hpp"
 #include <algorithm>
+#include <cctype>
 #include <condition_variable>
 #include <cstdio>
 #include <filesystem>
@@ -19,6 +23,13 @@
 
 namespace rsjfw {
 
+namespace {
+std::filesystem::path latestVersionCachePath(const std::string &channel) {
+  return PathManager::instance().cache() /
+         ("latest_version_" + (channel.empty() ? "LIVE" : channel));
+}
+} // namespace
+
 Downloader::Downloader(const std::string &rootDir) {
   auto &pathMgr = PathManager::instance();
   rootDir_ = pathMgr.root().string();
@@ -27,7 +38,8 @@ Downloader::Downloader(const std::string &rootDir) {
 }
 
 std::string Downloader::getLatestVersionGUID() {
-  auto &cfg = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &cfg = config->general;
 
   if (!cfg.robloxVersion.empty()) {
     std::cout << "[RSJFW] Using version override: " << cfg.robloxVersion
@@ -35,24 +47,51 @@ std::string Downloader::getLatestVersionGUID() {
     return cfg.robloxVersion;
   }
 
-  return RobloxAPI::getLatestVersionGUID(cfg.channel);
+  std::string guid = RobloxAPI::getLatestVersionGUID(cfg.channel);
+  if (!guid.empty()) {
+    std::error_code ec;
+    auto cacheFile = latestVersionCachePath(cfg.channel);
+    std::filesystem::create_directories(cacheFile.parent_path(), ec);
+    std::ofstream out(cacheFile, std::ios::trunc);
+    out << guid << "\n";
+  }
+  return guid;
+}
+
+std::string Downloader::getCachedLatestVersionGUID() {
+  auto config = Config::instance().snapshot();
+  const auto &cfg = config->general;
+  if (!cfg.robloxVersion.empty())
+    return cfg.robloxVersion;
+
+  std::ifstream in(latestVersionCachePath(cfg.channel));
+  std::string guid;
+  std::getline(in, guid);
+  return guid;
 }
 
 std::vector<std::string> Downloader::getInstalledVersions() {
-  std::vector<std::string> versions;
-  if (!std::filesystem::exists(versionsDir_))
-    return versions;
-
-  for (const auto &entry : std::filesystem::directory_iterator(versionsDir_)) {
-    if (entry.is_directory()) {
-      std::string name = entry.path().filename().string();
-      if (isVersionInstalled(name)) {
-        versions.push_back(name);
-      }
-    }
+  // AppSettings.xml is the last thing an install writes, so its mtime is
+  // when the version was installed. GUIDs are hashes and sort arbitrarily.
+  std::vector<std::pair<std::filesystem::file_time_type, std::string>> found;
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(versionsDir_, ec)) {
+    // Hidden entries are staging directories
+    if (!entry.is_directory(ec) ||
+        entry.path().filename().string().starts_with("."))
+      continue;
+    auto installed =
+        std::filesystem::last_write_time(entry.path() / "AppSettings.xml", ec);
+    if (!ec)
+      found.emplace_back(installed, entry.path().filename().string());
   }
 
-  std::sort(versions.rbegin(), versions.rend());
+  // Newest first
+  std::sort(found.rbegin(), found.rend());
+  std::vector<std::string> versions;
+  for (auto &[installed, name] : found)
+    versions.push_back(std::move(name));
   return versions;
 }
 
@@ -85,16 +124,25 @@ bool Downloader::installVersion(const std::string &versionGUID,
     std::cout << "[RSJFW] Found " << packages.size()
               << " packages to install.\n";
 
-    std::string installDir =
-        (std::filesystem::path(versionsDir_) / versionGUID).string();
-    if (std::filesystem::exists(installDir)) {
+    std::filesystem::path installDir =
+        std::filesystem::path(versionsDir_) / versionGUID;
+    if (isVersionInstalled(versionGUID)) {
       std::cout << "[RSJFW] Version " << versionGUID << " already installed.\n";
       if (callback)
         callback("Already installed", 1.0f, packages.size(), packages.size());
       return true;
     }
-
-    std::filesystem::create_directories(installDir);
+    // Left over from an unfinished install before installs were staged
+    Storage::instance().discard(installDir);
+
+    // Everything is extracted into a hidden staging directory that is
+    // renamed into place once complete, so versions/<guid> is either a full
+    // install or absent. A marker per extracted package lets an interrupted
+    // install carry on with just the missing ones.
+    std::filesystem::path stagingDir =
+        std::filesystem::path(versionsDir_) / (".staging-" + versionGUID);
+    std::filesystem::path doneDir = stagingDir / ".rsjfw-done";
+    std::filesystem::create_directories(doneDir);
 
     static const std::unordered_map<std::string, std::string> packageMap = {
         {"ApplicationConfig.zip", "ApplicationConfig/"},
@@ -135,15 +183,26 @@ bool Downloader::installVersion(const std::string &versionGUID,
     std::mutex queueMutex;
     std::condition_variable cv;
     std::queue<size_t> packageQueue;
-    for (size_t i = 0; i < packages.size(); ++i)
-      packageQueue.push(i);
+    int alreadyDone = 0;
+    for (size_t i = 0; i < packages.size(); ++i) {
+      if (std::filesystem::exists(doneDir / packages[i].checksum))
+        alreadyDone++;
+      else
+        packageQueue.push(i);
+    }
+    if (alreadyDone > 0)
+      LOG_INFO("Resuming install of " + versionGUID + ", " +
+               std::to_string(alreadyDone) + " of " +
+               std::to_string(packages.size()) + " packages already done");
 
-    std::atomic<int> completedPackages{0};
+    std::atomic<int> completedPackages{alreadyDone};
     std::atomic<bool> failed{false};
     std::mutex callbackMutex;
 
     const int numThreads = 4;
     std::vector<std::jthread> workers;
+    // The cap is shared between the parallel downloads
+    int64_t perTransferLimit = (int64_t)(maxBytesPerSecond_ / numThreads);
 
     for (int t = 0; t < numThreads; ++t) {
       workers.emplace_back([&]() {
@@ -151,7 +210,7 @@ bool Downloader::installVersion(const std::string &versionGUID,
           size_t pkgIdx;
           {
             std::unique_lock<std::mutex> lock(queueMutex);
-            if (packageQueue.empty() || failed)
+            if (packageQueue.empty() || failed || stop_.stop_requested())
               return;
             pkgIdx = packageQueue.front();
             packageQueue.pop();
@@ -165,8 +224,8 @@ bool Downloader::installVersion(const std::string &versionGUID,
               callback(pkg.name, 0.0f, completedPackages, packages.size());
           }
 
-          bool success =
-              downloadPackage(versionGUID, pkg, [&](size_t cur, size_t tot) {
+          bool success = downloadPackage(
+              versionGUID, pkg, perTransferLimit, [&](size_t cur, size_t tot) {
                 if (failed)
                   return;
                 std::lock_guard<std::mutex> lock(callbackMutex);
@@ -191,8 +250,7 @@ bool Downloader::installVersion(const std::string &versionGUID,
 
           std::string pkgPath =
               (std::filesystem::path(downloadsDir_) / pkg.checksum).string();
-          std::string destPath =
-              (std::filesystem::path(installDir) / subDir).string();
+          std::string destPath = (stagingDir / subDir).string();
 
           std::filesystem::create_directories(destPath);
           if (!ZipUtil::extract(pkgPath, destPath)) {
@@ -203,6 +261,7 @@ bool Downloader::installVersion(const std::string &versionGUID,
 
           // Post-extraction Zip Cleanup (As per user strategy)
           std::filesystem::remove(pkgPath);
+          std::ofstream(doneDir / pkg.checksum).flush();
 
           completedPackages++;
           {
@@ -217,12 +276,13 @@ bool Downloader::installVersion(const std::string &versionGUID,
     // Wait for workers
     workers.clear(); // std::jthread joins on destruction
 
-    if (failed)
+    // The staging directory stays for the next attempt to resume
+    if (failed || completedPackages < (int)packages.size())
       return false;
 
     std::vector<std::string> qtSearchPaths = {
-        (std::filesystem::path(installDir) / "Qt5").string(),
-        (std::filesystem::path(installDir) / "Plugins" / "Qt5").string()};
+        (stagingDir / "Qt5").string(),
+        (stagingDir / "Plugins" / "Qt5").string()};
 
     for (const auto &searchPath : qtSearchPaths) {
       if (std::filesystem::exists(searchPath)) {
@@ -230,8 +290,7 @@ bool Downloader::installVersion(const std::string &versionGUID,
                   << " to root...\n";
         for (const auto &entry :
              std::filesystem::directory_iterator(searchPath)) {
-          std::filesystem::path target =
-              std::filesystem::path(installDir) / entry.path().filename();
+          std::filesystem::path target = stagingDir / entry.path().filename();
           if (std::filesystem::exists(target))
             std::filesystem::remove_all(target);
           std::filesystem::rename(entry.path(), target);
@@ -241,16 +300,30 @@ bool Downloader::installVersion(const std::string &versionGUID,
     }
 
     // Create AppSettings.xml
-    std::filesystem::path appSettingsPath =
-        std::filesystem::path(installDir) / "AppSettings.xml";
-    std::ofstream ofs(appSettingsPath);
-    if (ofs) {
-      ofs << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
-          << "<Settings>\r\n"
-          << "        <ContentFolder>content</ContentFolder>\r\n"
-          << "        <BaseUrl>http://www.roblox.com</BaseUrl>\r\n"
-          << "        <Channel>production</Channel>\r\n"
-          << "</Settings>\r\n";
+    std::filesystem::path appSettingsPath = stagingDir / "AppSettings.xml";
+    {
+      std::ofstream ofs(appSettingsPath);
+      if (ofs) {
+        ofs << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+            << "<Settings>\r\n"
+            << "        <ContentFolder>content</ContentFolder>\r\n"
+            << "        <BaseUrl>http://www.roblox.com</BaseUrl>\r\n"
+            << "        <Channel>production</Channel>\r\n"
+            << "</Settings>\r\n";
+      }
+    }
+
+    std::filesystem::remove_all(doneDir);
+    std::error_code ec;
+    std::filesystem::rename(stagingDir, installDir, ec);
+    if (ec) {
+      // Someone else finished the same version first
+      if (!isVersionInstalled(versionGUID)) {
+        LOG_ERROR("Failed to move " + versionGUID + " into place: " +
+                  ec.message());
+        return false;
+      }
+      Storage::instance().discard(stagingDir);
     }
 
     if (callback)
@@ -267,11 +340,27 @@ bool Downloader::installVersion(const std::string &versionGUID,
 
 bool Downloader::downloadPackage(
     const std::string &versionGUID, const RobloxPackage &pkg,
-    std::function<void(size_t, size_t)> progressCb) {
+    int64_t maxBytesPerSecond, std::function<void(size_t, size_t)> progressCb) {
   std::string destPath =
       (std::filesystem::path(downloadsDir_) / pkg.checksum).string();
 
-  if (std::filesystem::exists(destPath)) {
+  // Packages are named by the MD5 of their zip
+  std::string expected = pkg.checksum;
+  std::transform(expected.begin(), expected.end(), expected.begin(),
+                 ::tolower);
+  auto verified = [&]() {
+    std::string actual = Md5::file(destPath);
+    if (actual == expected)
+      return true;
+    LOG_WARN("Checksum mismatch for " + pkg.name + ": expected " + expected +
+             ", got " + (actual.empty() ? "unreadable file" : actual));
+    std::error_code ec;
+    std::filesystem::remove(destPath, ec);
+    return false;
+  };
+
+  // Kept from an interrupted install
+  if (std::filesystem::exists(destPath) && verified()) {
     if (progressCb) {
       size_t sz = std::filesystem::file_size(destPath);
       progressCb(sz, sz);
@@ -280,44 +369,30 @@ bool Downloader::downloadPackage(
   }
 
   std::string url = RobloxAPI::BASE_URL + versionGUID + "-" + pkg.name;
-  try {
-    return HTTP::download(url, destPath, progressCb);
-  } catch (const std::exception &e) {
-    std::cerr << "[RSJFW] Failed to download package " << pkg.name << ": "
-              << e.what() << "\n";
-    return false;
+  // One retry covers a corrupted transfer
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    try {
+      if (HTTP::download(url, destPath, progressCb, maxBytesPerSecond,
+                         stop_) &&
+          verified())
+        return true;
+    } catch (const std::exception &e) {
+      std::cerr << "[RSJFW] Failed to download package " << pkg.name << ": "
+                << e.what() << "\n";
+      return false;
+    }
+    if (stop_.stop_requested())
+      return false;
   }
+  return false;
 }
 
 // Unified GitHub API support (v2.1)
 std::vector<Downloader::GitHubRelease>
-Downloader::fetchReleases(const std::string &repo) {
-  std::vector<GitHubRelease> releases;
+Downloader::fetchReleases(const std::string &repo, const std::string &wantTag) {
   if (repo.empty() || repo == "SYSTEM" || repo == "CUSTOM_PATH")
-    return releases;
-
-  std::string url = "https://api.github.com/repos/" + repo + "/releases";
-  try {
-    std::string response = HTTP::get(url);
-    auto j = nlohmann::json::parse(response);
-    if (!j.is_array())
-      return releases;
-
-    for (const auto &rel : j) {
-      GitHubRelease release;
-      release.tag = rel["tag_name"];
-      for (const auto &asset : rel["assets"]) {
-        GitHubAsset ga;
-        ga.name = asset["name"];
-        ga.url = asset["browser_download_url"];
-        ga.size = asset["size"];
-        release.assets.push_back(ga);
-      }
-      releases.push_back(release);
-    }
-  } catch (...) {
-  }
-  return releases;
+    return {};
+  return ReleaseCache::instance().fetch(repo, wantTag);
 }
 
 bool Downloader::validateRepo(const std::string &repo, std::string &outError) {
@@ -346,118 +421,17 @@ bool Downloader::validateRepo(const std::string &repo, std::string &outError) {
 }
 
 bool Downloader::deleteRoot(const std::string &path) {
-  if (path.empty() || !std::filesystem::exists(path))
-    return false;
-  try {
-    std::filesystem::remove_all(path);
-    return true;
-  } catch (...) {
+  if (path.empty())
     return false;
-  }
-}
-
-std::vector<Downloader::InstalledRoot> Downloader::getInstalledWineRoots() {
-  std::vector<InstalledRoot> roots;
-  std::filesystem::path wineDir = std::filesystem::path(rootDir_) / "wine";
-  if (!std::filesystem::exists(wineDir))
-    return roots;
-
-  for (const auto &entry : std::filesystem::directory_iterator(wineDir)) {
-    if (entry.is_directory()) {
-      std::filesystem::path bin = entry.path() / "bin/wine";
-      if (!std::filesystem::exists(bin))
-        bin = entry.path() / "files/bin/wine";
-
-      if (std::filesystem::exists(bin)) {
-        InstalledRoot ir;
-        ir.name = entry.path().filename().string();
-        ir.path = entry.path().string();
-        ir.isProton = std::filesystem::exists(entry.path() / "proton");
-
-        size_t total = 0;
-        try {
-          for (const auto &p : std::filesystem::recursive_directory_iterator(
-                   entry.path(), std::filesystem::directory_options::
-                                     skip_permission_denied)) {
-            if (p.is_regular_file())
-              total += p.file_size();
-          }
-        } catch (...) {
-        }
-        ir.sizeBytes = total;
-
-        // Try to read metadata
-        try {
-          std::filesystem::path metaPath = entry.path() / "rsjfw_meta.json";
-          if (std::filesystem::exists(metaPath)) {
-            std::ifstream ifs(metaPath);
-            auto meta = nlohmann::json::parse(ifs);
-            ir.repo = meta.value("repo", "");
-            ir.version = meta.value("tag", "");
-            ir.asset = meta.value("asset", "");
-          }
-        } catch (...) {
-        }
-
-        roots.push_back(ir);
-      }
-    }
-  }
-  return roots;
-}
-
-std::vector<Downloader::InstalledRoot> Downloader::getInstalledDxvkRoots() {
-  std::vector<InstalledRoot> roots;
-  std::filesystem::path dxvkDir = std::filesystem::path(rootDir_) / "dxvk";
-  if (!std::filesystem::exists(dxvkDir))
-    return roots;
-
-  for (const auto &entry : std::filesystem::directory_iterator(dxvkDir)) {
-    if (entry.is_directory()) {
-      if (std::filesystem::exists(entry.path() / "x64") ||
-          std::filesystem::exists(entry.path() / "x86")) {
-        InstalledRoot ir;
-        ir.name = entry.path().filename().string();
-        ir.path = entry.path().string();
-        ir.isProton = false;
-
-        size_t total = 0;
-        try {
-          for (const auto &p : std::filesystem::recursive_directory_iterator(
-                   entry.path(), std::filesystem::directory_options::
-                                     skip_permission_denied)) {
-            if (p.is_regular_file())
-              total += p.file_size();
-          }
-        } catch (...) {
-        }
-        ir.sizeBytes = total;
-
-        // Try to read metadata
-        try {
-          std::filesystem::path metaPath = entry.path() / "rsjfw_meta.json";
-          if (std::filesystem::exists(metaPath)) {
-            std::ifstream ifs(metaPath);
-            auto meta = nlohmann::json::parse(ifs);
-            ir.repo = meta.value("repo", "");
-            ir.version = meta.value("tag", "");
-            ir.asset = meta.value("asset", "");
-          }
-        } catch (...) {
-        }
-
-        roots.push_back(ir);
-      }
-    }
-  }
-  return roots;
+  return Storage::instance().discard(path);
 }
 
 bool Downloader::installWine(const std::string &repo,
                              const std::string &version,
                              const std::string &assetName,
                              ProgressCallback callback) {
-  auto &genCfg = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &genCfg = config->general;
   std::filesystem::path wineDir = std::filesystem::path(rootDir_) / "wine";
 
   // Skip if already correct
@@ -475,7 +449,7 @@ bool Downloader::installWine(const std::string &repo,
     url = repo;
   } else {
     // Fetch from GitHub
-    auto releases = fetchReleases(repo);
+    auto releases = fetchReleases(repo, version == "latest" ? "" : version);
     Downloader::GitHubRelease *targetRel = nullptr;
     if (version == "latest" && !releases.empty()) {
       targetRel = &releases[0];
@@ -611,8 +585,9 @@ bool Downloader::installWine(const std::string &repo,
       } catch (...) {
       }
 
-      genCfg.wineSource.installedRoot = extractedRoot;
-      Config::instance().save();
+      Config::instance().update([&](ConfigSnapshot &next) {
+        next.general.wineSource.installedRoot = extractedRoot;
+      });
       if (std::filesystem::exists(destFile))
         std::filesystem::remove(destFile);
       if (callback)
@@ -634,7 +609,8 @@ bool Downloader::installDxvk(const std::string &repo,
                              const std::string &version,
                              const std::string &assetName,
                              ProgressCallback callback) {
-  auto &genCfg = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &genCfg = config->general;
   std::filesystem::path dxvkDir = std::filesystem::path(rootDir_) / "dxvk";
 
   // Check if already installed
@@ -652,7 +628,7 @@ bool Downloader::installDxvk(const std::string &repo,
     url = repo;
   } else {
     // Fetch from GitHub
-    auto releases = fetchReleases(repo);
+    auto releases = fetchReleases(repo, version == "latest" ? "" : version);
     Downloader::GitHubRelease *targetRel = nullptr;
     if (version == "latest" && !releases.empty()) {
       targetRel = &releases[0];
@@ -771,9 +747,9 @@ bool Downloader::installDxvk(const std::string &repo,
       } catch (...) {
       }
 
-      genCfg.dxvkSource.installedRoot =
-          extractedRoot; // Standardize on dxvkRoot
-      Config::instance().save();
+      Config::instance().update([&](ConfigSnapshot &next) {
+        next.general.dxvkSource.installedRoot = extractedRoot;
+      });
       std::filesystem::remove(destFile);
       LOG_INFO("Successfully installed DXVK to " + extractedRoot);
       if (callback)
@@ -1,55 +1,279 @@
 #include "rsjfw/dxvk.hpp"
 #include "rsjfw/logger.hpp"
+#include "nlohmann/json.hpp"
 #include <filesystem>
+#include <fstream>
 #include <cstdlib>
+#include <cstdio>
+#include <map>
 #include <vector>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
+using json = nlohmann::json;
 
 namespace rsjfw {
 namespace dxvk {
 
-bool install(wine::Prefix& pfx, const std::string& dxvkRootDir) {
-    if (!fs::exists(dxvkRootDir)) {
-        LOG_ERROR("DXVK root dir not found: " + dxvkRootDir);
+namespace {
+
+const char* MANIFEST_NAME = ".rsjfw_dxvk.json";
+
+struct SyncEntry {
+    fs::path src;
+    fs::path dest;
+};
+
+// FNV-1a over the file contents; only used when a DLL is actually (re)installed
+std::string hashFile(const fs::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return "";
+
+    uint64_t h = 0xcbf29ce484222325ULL;
+    char buf[65536];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(buf[i]);
+            h *= 0x100000001b3ULL;
+        }
+    }
+    ::close(fd);
+    if (n < 0) return "";
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+    return hex;
+}
+
+int64_t mtimeNs(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+// Clones the file when the filesystem supports reflinks (btrfs, xfs, bcachefs),
+// so the prefix shares extents with the DXVK root without depending on it.
+bool reflinkFile(const fs::path& src, const fs::path& dest) {
+    int in = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+
+    fs::path tmp = dest;
+    tmp += ".rsjfw-tmp";
+    int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
         return false;
     }
 
-    auto copyDlls = [&](const fs::path& sourceDir, const fs::path& destDir) {
-        if (!fs::exists(sourceDir)) return;
-        fs::create_directories(destDir);
-        for (const auto& entry : fs::directory_iterator(sourceDir)) {
-            if (entry.path().extension() == ".dll") {
-                try {
-                    fs::copy_file(entry.path(), destDir / entry.path().filename(), fs::copy_options::overwrite_existing);
-                    LOG_INFO("Installed " + entry.path().filename().string() + " to " + destDir.string());
-                } catch (const std::exception& e) {
-                    LOG_ERROR("Failed to copy DLL: " + std::string(e.what()));
-                }
+    bool ok = ::ioctl(out, FICLONE, in) == 0;
+    ::close(out);
+    ::close(in);
+
+    if (!ok) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tmp, dest, ec);
+    if (ec) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<SyncEntry> collectDlls(const fs::path& sourceDir, const fs::path& destDir) {
+    std::vector<SyncEntry> entries;
+    std::error_code ec;
+    if (!fs::exists(sourceDir, ec)) return entries;
+
+    for (const auto& entry : fs::directory_iterator(sourceDir, ec)) {
+        if (entry.path().extension() == ".dll") {
+            entries.push_back({entry.path(), destDir / entry.path().filename()});
+        }
+    }
+    return entries;
+}
+
+// Warm path: one stat per source and destination DLL, no reads
+bool manifestMatches(const fs::path& manifestPath, const std::string& dxvkRootDir) {
+    std::ifstream f(manifestPath);
+    if (!f.is_open()) return false;
+
+    try {
+        json j;
+        f >> j;
+        if (j.value("source_root", "") != dxvkRootDir) return false;
+
+        const auto& files = j.at("files");
+        if (!files.is_array() || files.empty()) return false;
+
+        for (const auto& file : files) {
+            struct stat srcSt, destSt;
+            std::string src = file.at("src").get<std::string>();
+            std::string dest = file.at("dest").get<std::string>();
+
+            if (::stat(src.c_str(), &srcSt) != 0 || ::stat(dest.c_str(), &destSt) != 0) return false;
+
+            if (srcSt.st_size != file.at("size").get<int64_t>() ||
+                mtimeNs(srcSt) != file.at("src_mtime").get<int64_t>()) {
+                return false;
+            }
+
+            // Catches wineboot --update restoring builtin stubs over our DLLs
+            if (destSt.st_size != srcSt.st_size ||
+                mtimeNs(destSt) != file.at("dest_mtime").get<int64_t>()) {
+                return false;
             }
         }
-    };
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+bool install(wine::Prefix& pfx, const std::string& dxvkRootDir) {
+    if (!fs::exists(dxvkRootDir)) {
+        LOG_ERROR("DXVK root dir not found: " + dxvkRootDir);
+        return false;
+    }
 
     fs::path system32 = fs::path(pfx.dir()) / "drive_c" / "windows" / "system32";
     fs::path syswow64 = fs::path(pfx.dir()) / "drive_c" / "windows" / "syswow64";
-    
+    fs::path manifestPath = fs::path(pfx.dir()) / MANIFEST_NAME;
+
+    if (manifestMatches(manifestPath, dxvkRootDir)) {
+        LOG_DEBUG("DXVK DLLs up to date in " + pfx.dir() + ", skipping sync");
+        return true;
+    }
+
     fs::path rootPath(dxvkRootDir);
-    
-    copyDlls(rootPath / "x64", system32);
-    
+
+    std::vector<SyncEntry> entries = collectDlls(rootPath / "x64", system32);
+    std::vector<SyncEntry> wow;
     if (fs::exists(rootPath / "x32")) {
-        copyDlls(rootPath / "x32", syswow64);
+        wow = collectDlls(rootPath / "x32", syswow64);
     } else if (fs::exists(rootPath / "x86")) {
-        copyDlls(rootPath / "x86", syswow64);
+        wow = collectDlls(rootPath / "x86", syswow64);
+    }
+    entries.insert(entries.end(), wow.begin(), wow.end());
+
+    if (entries.empty()) {
+        LOG_ERROR("No DXVK DLLs found in " + dxvkRootDir);
+        return false;
+    }
+
+    // Hashes of what is currently installed, so unchanged DLLs are only re-stat'd
+    std::map<std::string, std::string> previousHashes;
+    {
+        std::ifstream f(manifestPath);
+        if (f.is_open()) {
+            try {
+                json j;
+                f >> j;
+                for (const auto& file : j.at("files")) {
+                    previousHashes[file.at("dest").get<std::string>()] = file.value("hash", "");
+                }
+            } catch (...) {}
+        }
+    }
+
+    json manifest;
+    manifest["source_root"] = dxvkRootDir;
+    manifest["files"] = json::array();
+
+    bool allOk = true;
+    for (const auto& e : entries) {
+        std::error_code ec;
+        fs::create_directories(e.dest.parent_path(), ec);
+
+        std::string srcHash = hashFile(e.src);
+        if (srcHash.empty()) {
+            LOG_ERROR("Failed to read DLL: " + e.src.string());
+            allOk = false;
+            continue;
+        }
+
+        struct stat destSt;
+        bool destPresent = ::lstat(e.dest.c_str(), &destSt) == 0 && S_ISREG(destSt.st_mode);
+        auto prev = previousHashes.find(e.dest.string());
+        bool upToDate = destPresent && prev != previousHashes.end() && prev->second == srcHash &&
+                        hashFile(e.dest) == srcHash;
+
+        std::string mode = "unchanged";
+        if (!upToDate) {
+            // Old installs may have left a symlink here; never write through it
+            if (::lstat(e.dest.c_str(), &destSt) == 0 && !S_ISREG(destSt.st_mode)) {
+                fs::remove(e.dest, ec);
+            }
+
+            if (reflinkFile(e.src, e.dest)) {
+                mode = "reflink";
+            } else {
+                try {
+                    fs::copy_file(e.src, e.dest, fs::copy_options::overwrite_existing);
+                    mode = "copy";
+                } catch (const std::exception& ex) {
+                    LOG_ERROR("Failed to copy DLL: " + std::string(ex.what()));
+                    allOk = false;
+                    continue;
+                }
+            }
+            LOG_INFO("Installed " + e.src.filename().string() + " to " + e.dest.parent_path().string() + " (" + mode + ")");
+        }
+
+        struct stat srcSt;
+        if (::stat(e.src.c_str(), &srcSt) != 0 || ::stat(e.dest.c_str(), &destSt) != 0) {
+            allOk = false;
+            continue;
+        }
+
+        manifest["files"].push_back({
+            {"src", e.src.string()},
+            {"dest", e.dest.string()},
+            {"size", static_cast<int64_t>(srcSt.st_size)},
+            {"src_mtime", mtimeNs(srcSt)},
+            {"dest_mtime", mtimeNs(destSt)},
+            {"hash", srcHash},
+            {"mode", mode}
+        });
+    }
+
+    // A partial sync must not be recorded, otherwise the next launch would skip it
+    if (!allOk) {
+        std::error_code ec;
+        fs::remove(manifestPath, ec);
+        return false;
     }
 
+    fs::path tmp = manifestPath;
+    tmp += ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        if (!f.is_open()) {
+            LOG_WARN("Could not write DXVK manifest: " + tmp.string());
+            return true;
+        }
+        f << manifest.dump(4);
+    }
+    std::error_code ec;
+    fs::rename(tmp, manifestPath, ec);
+    if (ec) LOG_WARN("Could not write DXVK manifest: " + ec.message());
+
     return true;
 }
 
 void envOverride(wine::Prefix& pfx, bool enabled) {
     std::string val = "d3d9,d3d10core,d3d11,dxgi=";
     val += (enabled ? "n,b" : "b,n");
-    
+
     pfx.appendEnv("WINEDLLOVERRIDES", val);
 }
 
@@ -0,0 +1,313 @@
+#include "rsjfw/event_log.hpp"
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace rsjfw {
+
+namespace {
+
+constexpr char MAGIC[8] = {'R', 'S', 'J', 'F', 'W', 'E', 'V', '1'};
+constexpr size_t HEADER_BYTES = 16;
+constexpr size_t RECORD_FIXED = 10; // monoNs + source + level
+constexpr size_t MAX_PAYLOAD = 1 << 20;
+constexpr size_t READ_CHUNK = 1 << 20;
+
+uint64_t nowNs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void putLE(std::string &out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i)
+    out += (char)((value >> (8 * i)) & 0xff);
+}
+
+uint64_t getLE(const char *in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i)
+    value |= (uint64_t)(unsigned char)in[i] << (8 * i);
+  return value;
+}
+
+bool writeAll(int fd, const char *data, size_t len) {
+  while (len > 0) {
+    ssize_t n = ::write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+const char *levelName(LogLevel level) {
+  switch (level) {
+  case LogLevel::DEBUG:
+    return "DEBUG";
+  case LogLevel::INFO:
+    return "INFO";
+  case LogLevel::WARNING:
+    return "WARN";
+  case LogLevel::ERROR:
+    return "ERROR";
+  }
+  return "UNKNOWN";
+}
+
+const char *sourceName(EventSource source) {
+  switch (source) {
+  case EventSource::RSJFW:
+    return "RSJFW";
+  case EventSource::WINE:
+    return "WINE";
+  case EventSource::STUDIO:
+    return "STUDIO";
+  }
+  return "UNKNOWN";
+}
+
+// Where render() left off for each text file it maintains
+struct RenderState {
+  dev_t dev = 0;
+  ino_t ino = 0;
+  uint64_t consumed = 0;
+  uint64_t textBytes = 0;
+  int64_t wallOffsetNs = 0;
+};
+
+std::mutex renderMutex;
+std::unordered_map<std::string, RenderState> renderStates;
+
+// Formats every complete record in [data, data + len) and returns the
+// number of bytes used. Stops early at anything that is not a record.
+size_t parseRecords(const char *data, size_t len, int64_t wallOffsetNs,
+                    std::string &out) {
+  size_t pos = 0;
+  while (len - pos >= 4 + RECORD_FIXED) {
+    uint32_t size = (uint32_t)getLE(data + pos, 4);
+    if (size < RECORD_FIXED || size > RECORD_FIXED + MAX_PAYLOAD)
+      break;
+    if (len - pos < 4 + (size_t)size)
+      break;
+    const char *rec = data + pos + 4;
+    Event event;
+    event.monoNs = getLE(rec, 8);
+    event.source = (EventSource)(unsigned char)rec[8];
+    event.level = (LogLevel)(unsigned char)rec[9];
+    event.payload = std::string_view(rec + RECORD_FIXED, size - RECORD_FIXED);
+    out += EventLog::format(event, wallOffsetNs);
+    out += '\n';
+    pos += 4 + size;
+  }
+  return pos;
+}
+
+} // namespace
+
+bool EventLog::open(const fs::path &path) {
+  int64_t wallOffsetNs =
+      (int64_t)(nowNs(CLOCK_REALTIME) - nowNs(CLOCK_MONOTONIC));
+  std::string header(MAGIC, sizeof(MAGIC));
+  putLE(header, (uint64_t)wallOffsetNs, 8);
+  file_.setHeader(std::move(header));
+  // A previous file's offset would no longer match this boot's clock
+  return file_.open(path, false);
+}
+
+void EventLog::append(EventSource source, LogLevel level,
+                      std::string_view payload) {
+  while (!payload.empty() &&
+         (payload.back() == '\n' || payload.back() == '\r'))
+    payload.remove_suffix(1);
+  if (payload.size() > MAX_PAYLOAD)
+    payload = payload.substr(0, MAX_PAYLOAD);
+
+  std::string record;
+  record.reserve(4 + RECORD_FIXED + payload.size());
+  putLE(record, RECORD_FIXED + payload.size(), 4);
+  putLE(record, nowNs(CLOCK_MONOTONIC), 8);
+  record += (char)source;
+  record += (char)level;
+  record.append(payload);
+  file_.write(record.data(), record.size());
+}
+
+void EventLog::classify(std::string_view line, EventSource &source,
+                        LogLevel &level) {
+  source = EventSource::STUDIO;
+  level = LogLevel::INFO;
+
+  // Skip the "%04x:" pid/tid prefixes Wine puts in front of the channel
+  size_t pos = 0;
+  for (int i = 0; i < 2; ++i) {
+    size_t end = pos;
+    while (end < line.size() && std::isxdigit((unsigned char)line[end]))
+      ++end;
+    if (end - pos < 4 || end >= line.size() || line[end] != ':')
+      break;
+    pos = end + 1;
+  }
+
+  static const struct {
+    const char *prefix;
+    LogLevel level;
+  } channels[] = {{"err:", LogLevel::ERROR},
+                  {"warn:", LogLevel::WARNING},
+                  {"fixme:", LogLevel::WARNING},
+                  {"trace:", LogLevel::DEBUG},
+                  {"wine:", LogLevel::INFO},
+                  {"wineserver:", LogLevel::INFO}};
+  std::string_view rest = line.substr(pos);
+  for (const auto &channel : channels) {
+    if (rest.starts_with(channel.prefix)) {
+      source = EventSource::WINE;
+      level = channel.level;
+      return;
+    }
+  }
+}
+
+std::string EventLog::format(const Event &event, int64_t wallOffsetNs) {
+  int64_t wallNs = (int64_t)event.monoNs + wallOffsetNs;
+  time_t seconds = (time_t)(wallNs / 1000000000);
+  int millis = (int)((wallNs / 1000000) % 1000);
+
+  struct tm tm;
+  localtime_r(&seconds, &tm);
+  char stamp[40];
+  size_t n = std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+  snprintf(stamp + n, sizeof(stamp) - n, ".%03d", millis);
+
+  std::string line;
+  line.reserve(event.payload.size() + 48);
+  line += '[';
+  line += stamp;
+  line += "] [";
+  line += levelName(event.level);
+  line += "] [";
+  line += sourceName(event.source);
+  line += "] ";
+  line.append(event.payload);
+  return line;
+}
+
+bool EventLog::isEventLog(const fs::path &path) {
+  fs::path p = LogRetention::isCompressed(path) ? path.stem() : path;
+  return p.extension() == EXTENSION;
+}
+
+bool EventLog::render(const fs::path &events, const fs::path &text) {
+  int in = ::open(events.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (in < 0 || ::fstat(in, &st) != 0) {
+    if (in >= 0)
+      ::close(in);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(renderMutex);
+  RenderState &state = renderStates[text.string()];
+  struct stat textSt;
+  bool resume = state.consumed >= HEADER_BYTES && state.dev == st.st_dev &&
+                state.ino == st.st_ino &&
+                (uint64_t)st.st_size >= state.consumed &&
+                ::stat(text.c_str(), &textSt) == 0 &&
+                (uint64_t)textSt.st_size == state.textBytes;
+  if (resume && (uint64_t)st.st_size == state.consumed) {
+    ::close(in);
+    return true;
+  }
+
+  // A fresh render goes through a temporary so readers never see half of it
+  fs::path target = text;
+  if (!resume)
+    target += ".tmp";
+  int out = ::open(target.c_str(),
+                   O_WRONLY | O_CREAT | O_CLOEXEC |
+                       (resume ? O_APPEND : O_TRUNC),
+                   0644);
+  if (out < 0) {
+    ::close(in);
+    return false;
+  }
+
+  RenderState next = resume ? state : RenderState{};
+  next.dev = st.st_dev;
+  next.ino = st.st_ino;
+
+  std::vector<char> chunk(READ_CHUNK);
+  std::string pending, rendered;
+  uint64_t readPos = next.consumed;
+  bool ok = true;
+  for (;;) {
+    ssize_t n = ::pread(in, chunk.data(), chunk.size(), readPos);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      ok = n == 0;
+      break;
+    }
+    readPos += n;
+    pending.append(chunk.data(), n);
+
+    size_t used = 0;
+    if (next.consumed == 0) {
+      if (pending.size() < HEADER_BYTES)
+        continue;
+      if (std::memcmp(pending.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        ok = false;
+        break;
+      }
+      next.wallOffsetNs = (int64_t)getLE(pending.data() + sizeof(MAGIC), 8);
+      used = HEADER_BYTES;
+    }
+    used += parseRecords(pending.data() + used, pending.size() - used,
+                         next.wallOffsetNs, rendered);
+    pending.erase(0, used);
+    next.consumed += used;
+    // Whatever is left can only be the start of one record
+    if (pending.size() > 4 + RECORD_FIXED + MAX_PAYLOAD) {
+      ok = false;
+      break;
+    }
+
+    if (!writeAll(out, rendered.data(), rendered.size())) {
+      ok = false;
+      break;
+    }
+    next.textBytes += rendered.size();
+    rendered.clear();
+  }
+  ::close(in);
+  ::close(out);
+
+  std::error_code ec;
+  if (ok && !resume) {
+    fs::rename(target, text, ec);
+    ok = !ec;
+  }
+  if (!ok) {
+    if (!resume)
+      fs::remove(target, ec);
+    renderStates.erase(text.string());
+    return false;
+  }
+  state = next;
+  return true;
+}
+
+} // namespace rsjfw
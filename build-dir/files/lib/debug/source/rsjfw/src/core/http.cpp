@@ -1,4 +1,6 @@
 #include "rsjfw/http.hpp"
+#include <algorithm>
+#include <cctype>
 #include <stdexcept>
 #include <fstream>
 #include <iostream>
@@ -34,8 +36,56 @@ std::string HTTP::get(const std::string& url) {
     return response;
 }
 
+size_t HTTP::headerCallback(char* buffer, size_t size, size_t nitems, void* userp) {
+    auto* headers = static_cast<std::map<std::string, std::string>*>(userp);
+    std::string line(buffer, size * nitems);
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+        // A status line starts the headers of every response, redirects included
+        if (line.rfind("HTTP/", 0) == 0) headers->clear();
+        return size * nitems;
+    }
+    std::string name = line.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    size_t start = line.find_first_not_of(" \t", colon + 1);
+    size_t end = line.find_last_not_of(" \t\r\n");
+    (*headers)[name] = (start == std::string::npos || end < start) ? "" : line.substr(start, end - start + 1);
+    return size * nitems;
+}
+
+HTTP::Response HTTP::request(const std::string& url, const std::vector<std::string>& headers) {
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        throw std::runtime_error("Failed to initialize cURL");
+    }
+
+    Response response;
+    struct curl_slist* list = nullptr;
+    for (const auto& header : headers) list = curl_slist_append(list, header.c_str());
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36");
+
+    CURLcode res = curl_easy_perform(curl);
+    if (res == CURLE_OK) curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(list);
+    if (res != CURLE_OK) {
+        throw std::runtime_error("cURL request failed: " + std::string(curl_easy_strerror(res)));
+    }
+    return response;
+}
+
 struct ProgressData {
     HTTP::ProgressCallback callback;
+    std::stop_token stop;
 };
 
 size_t HTTP::fileWriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
@@ -47,13 +97,15 @@ size_t HTTP::fileWriteCallback(void* contents, size_t size, size_t nmemb, void*
 
 int HTTP::progressCallback(void* clientp, double dltotal, double dlnow, double ultotal, double ulnow) {
     ProgressData* data = static_cast<ProgressData*>(clientp);
+    if (data && data->stop.stop_requested()) return 1; // Aborts the transfer
     if (data && data->callback && dltotal > 0) {
         data->callback(static_cast<size_t>(dlnow), static_cast<size_t>(dltotal));
     }
     return 0;
 }
 
-bool HTTP::download(const std::string& url, const std::string& filepath, ProgressCallback callback) {
+bool HTTP::download(const std::string& url, const std::string& filepath, ProgressCallback callback,
+                    curl_off_t maxBytesPerSecond, std::stop_token stop) {
     CURL* curl = curl_easy_init();
     if (!curl) return false;
 
@@ -64,7 +116,7 @@ bool HTTP::download(const std::string& url, const std::string& filepath, Progres
         return false;
     }
 
-    ProgressData data{callback};
+    ProgressData data{callback, stop};
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, fileWriteCallback);
@@ -72,7 +124,9 @@ bool HTTP::download(const std::string& url, const std::string& filepath, Progres
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36");
     
-    if (callback) {
+    if (maxBytesPerSecond > 0) curl_easy_setopt(curl, CURLOPT_MAX_RECV_SPEED_LARGE, maxBytesPerSecond);
+
+    if (callback || stop.stop_possible()) {
         curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
         curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, progressCallback);
         curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, &data);
@@ -3,9 +3,15 @@
 #include "rsjfw/diagnostics.hpp"
 #include "rsjfw/downloader.hpp"
 #include "rsjfw/dxvk.hpp"
+#include "rsjfw/event_log.hpp"
 #include "rsjfw/http.hpp"
+#include "rsjfw/log_retention.hpp"
 #include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/performance.hpp"
 #include "rsjfw/registry.hpp"
+#include "rsjfw/shader_cache.hpp"
+#include "rsjfw/task_runner.hpp"
 #include "rsjfw/wine.hpp"
 #include <algorithm>
 #include <chrono>
@@ -15,6 +21,7 @@
 #include <fstream>
 #include <random>
 #include <signal.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
@@ -25,14 +32,15 @@ Launcher::Launcher(const std::string &rootDir) : rootDir_(rootDir) {
   versionsDir_ = (std::filesystem::path(rootDir) / "versions").string();
   prefixDir_ = (std::filesystem::path(rootDir) / "prefix").string();
   compatDataDir_ = (std::filesystem::path(rootDir) / "compatdata").string();
-
-  std::filesystem::create_directories(prefixDir_);
+  // The prefix directory is created by setupPrefix(), or by Wine itself
 }
 
 bool Launcher::setupPrefix(ProgressCb progressCb) {
   if (progressCb)
     progressCb(0.0f, "Initializing Wine Prefix...");
-  auto &genCfg = Config::instance().getGeneral();
+  std::filesystem::create_directories(prefixDir_);
+  auto config = Config::instance().snapshot();
+  const auto &genCfg = config->general;
 
   bool isProton = (genCfg.wineSource.repo.find("proton") != std::string::npos ||
                    genCfg.wineSource.repo == "GE-PROTON" ||
@@ -111,7 +119,7 @@ bool Launcher::setupPrefix(ProgressCb progressCb) {
                        "EncryptionKey", ss.str(), "REG_BINARY"});
   }
 
-  if (!pfx.registryApply(entries)) {
+  if (!reg.apply(entries)) {
     LOG_ERROR("Failed to apply registry batch.");
     return false;
   }
@@ -125,7 +133,8 @@ bool Launcher::setupPrefix(ProgressCb progressCb) {
 // Terminates all running Wine processes within the prefix
 bool Launcher::killStudio() {
   LOG_INFO("Killing all Studio processes in prefix...");
-  auto &genCfg = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &genCfg = config->general;
 
   bool isProton = (genCfg.wineSource.repo.find("proton") != std::string::npos ||
                    genCfg.wineSource.repo == "GE-PROTON" ||
@@ -150,11 +159,11 @@ bool Launcher::openWineConfiguration() {
 // Installs DXVK globally into the prefix
 bool Launcher::setupDxvk(const std::string &versionGUID,
                          ProgressCb progressCb) {
-  bool useDxvk = Config::instance().getGeneral().dxvk;
-  if (!useDxvk)
+  auto config = Config::instance().snapshot();
+  const auto &genCfg = config->general;
+  if (!genCfg.dxvk)
     return true;
 
-  auto &genCfg = Config::instance().getGeneral();
   std::string dxvkRoot = "";
 
   if (genCfg.dxvkSource.repo == "CUSTOM_PATH") {
@@ -196,7 +205,8 @@ bool Launcher::setupDxvk(const std::string &versionGUID,
         });
 
     if (success) {
-      dxvkRoot = Config::instance().getGeneral().dxvkSource.installedRoot;
+      dxvkRoot =
+          Config::instance().snapshot()->general.dxvkSource.installedRoot;
     } else {
       LOG_ERROR("Failed to download DXVK.");
       return false;
@@ -218,28 +228,12 @@ bool Launcher::setupDxvk(const std::string &versionGUID,
 bool Launcher::launchLatest(const std::vector<std::string> &extraArgs,
                             ProgressCb progressCb, OutputCb outputCb,
                             bool wait) {
-  if (!std::filesystem::exists(versionsDir_)) {
-    LOG_ERROR("Versions directory not found.");
-    return false;
-  }
-
-  std::vector<std::string> versions;
-  for (const auto &entry : std::filesystem::directory_iterator(versionsDir_)) {
-    if (entry.is_directory()) {
-      std::string fname = entry.path().filename().string();
-      if (fname.find("version-") == 0) {
-        versions.push_back(fname);
-      }
-    }
-  }
-
+  auto versions = Downloader(rootDir_).getInstalledVersions();
   if (versions.empty()) {
     LOG_ERROR("No Roblox Studio versions found.");
     return false;
   }
-
-  std::sort(versions.begin(), versions.end());
-  std::string latestVersion = versions.back();
+  std::string latestVersion = versions.front();
 
   LOG_INFO("Launching latest version: " + latestVersion);
 
@@ -289,7 +283,7 @@ bool Launcher::setupFFlags(const std::string &versionGUID,
 
   std::filesystem::path jsonPath = settingsDir / "ClientAppSettings.json";
 
-  nlohmann::json fflags = Config::instance().getFFlags();
+  nlohmann::json fflags = Config::instance().snapshot()->fflags;
 
   std::ofstream file(jsonPath);
   if (file.is_open()) {
@@ -310,14 +304,18 @@ bool Launcher::launchVersion(const std::string &versionGUID,
   }
 
   LOG_INFO("Launching version " + versionGUID);
-  return runWine(exe, extraArgs, outputCb, wait);
+  activeVersion_ = versionGUID;
+  bool ok = runWine(exe, extraArgs, outputCb, wait);
+  activeVersion_.clear();
+  return ok;
 }
 
 // Executes a command using wine with the configured environment
 bool Launcher::runWine(const std::string &executablePath,
                        const std::vector<std::string> &args, OutputCb outputCb,
                        bool wait) {
-  auto &genCfg = Config::instance().getGeneral();
+  // Local copy: discovery and repair below fill in the Wine root
+  GeneralConfig genCfg = Config::instance().snapshot()->general;
 
   if (genCfg.wineSource.installedRoot.empty() &&
       genCfg.wineSource.repo != "SYSTEM" &&
@@ -343,7 +341,10 @@ bool Launcher::runWine(const std::string &executablePath,
 
           if (std::filesystem::exists(binCheck)) {
             genCfg.wineSource.installedRoot = entry.path().string();
-            Config::instance().save();
+            Config::instance().update([&](ConfigSnapshot &next) {
+              next.general.wineSource.installedRoot =
+                  genCfg.wineSource.installedRoot;
+            });
             std::cout << "[RSJFW] Discovered wineRoot: "
                       << genCfg.wineSource.installedRoot << "\n";
             break;
@@ -403,7 +404,7 @@ bool Launcher::runWine(const std::string &executablePath,
     if (success) {
       // Reload config
       genCfg.wineSource.installedRoot =
-          Config::instance().getGeneral().wineSource.installedRoot;
+          Config::instance().snapshot()->general.wineSource.installedRoot;
       // Update prefix object with new root
       pfx = rsjfw::wine::Prefix(genCfg.wineSource.installedRoot, winePrefix);
       wineValid = true;
@@ -428,7 +429,8 @@ bool Launcher::runWine(const std::string &executablePath,
     pfx.kill();
   }
 
-  auto &wineCfg = Config::instance().getWine();
+  auto config = Config::instance().snapshot();
+  const auto &wineCfg = config->wine;
   std::string resolution = wineCfg.desktopResolution;
   // Sanitize resolution
   resolution.erase(std::remove(resolution.begin(), resolution.end(), ' '),
@@ -490,34 +492,63 @@ bool Launcher::runWine(const std::string &executablePath,
   std::cout << "[RSJFW] Launching: " << executablePath
             << (target == "explorer" ? " (Desktop Mode)" : "") << "\n";
 
-  std::string logDir = std::string(getenv("HOME")) + "/.local/share/rsjfw/logs";
+  std::filesystem::path logDir = PathManager::instance().logs();
   std::filesystem::create_directories(logDir);
-  std::string logPath = logDir + "/studio_latest.log";
+  std::filesystem::path logPath =
+      logDir / (std::string("studio_latest") + EventLog::EXTENSION);
+
+  // Keep the previous session instead of truncating it; retention compresses
+  // and eventually prunes it
+  struct stat logSt;
+  if (::stat(logPath.c_str(), &logSt) == 0 && logSt.st_size > 0) {
+    LogRetention::archive(logPath, logSt.st_mtime);
+    LogRetention::instance().schedule();
+  }
 
-  std::shared_ptr<std::ofstream> logFile =
-      std::make_shared<std::ofstream>(logPath);
+  auto events = std::make_shared<EventLog>();
+  events->setMaxBytes(
+      (uint64_t)std::max(config->logs.rotateMB, 0) << 20);
+  if (events->open(logPath))
+    events->append(EventSource::RSJFW, LogLevel::INFO,
+                   "Launching " + executablePath + " (" + target + ")");
+  else
+    LOG_WARN("Could not open " + logPath.string());
+
+  // Child output is stored once in the event log; the console only gets a
+  // copy when someone is watching it
+  bool echo = ::isatty(STDOUT_FILENO) || Logger::instance().verbose();
+
+  if (config->performance.wineserverCpu >= 0) {
+    TaskRunner::instance().run(
+        [winePrefix](std::stop_token stop) {
+          Performance::instance().pinWineserver(winePrefix, stop);
+        },
+        TaskPriority::BACKGROUND, "Pin wineserver");
+  }
 
   std::string studioCwd =
       std::filesystem::path(executablePath).parent_path().string();
 
   return pfx.wine(
       target, launchArgs,
-      [logFile, outputCb](const std::string &line) {
-        std::cout << line;
-
-        if (logFile && logFile->is_open())
-          *logFile << line;
+      [events, echo, outputCb,
+       version = activeVersion_](const std::string &line) {
+        if (echo)
+          std::cout << line;
+
+        ShaderCache::instance().observe(version, line);
+
+        if (events->isOpen() && line.find_first_not_of("\r\n") !=
+                                    std::string::npos) {
+          EventSource source;
+          LogLevel level;
+          EventLog::classify(line, source, level);
+          events->append(source, level, line);
+        }
 
         if (outputCb)
           outputCb(line);
 
-        std::string rawLine = line;
-        if (!rawLine.empty() && rawLine.back() == '\n')
-          rawLine.pop_back();
-        if (!rawLine.empty()) {
-          LOG_INFO("[WINE] " + rawLine);
-        }
-
         if (line.find("Fatal exiting due to Trouble launching Studio") !=
             std::string::npos) {
           std::cerr << "\n[RSJFW] Fatal error detected. Aborting.\n";
@@ -527,7 +558,8 @@ bool Launcher::runWine(const std::string &executablePath,
 }
 
 void Launcher::configureEnvironment(rsjfw::wine::Prefix &pfx, bool isProton) {
-  auto &genCfg = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &genCfg = config->general;
 
   if (!isProton) {
     std::filesystem::path wineBinPath = std::filesystem::path(pfx.bin("wine"));
@@ -538,10 +570,14 @@ void Launcher::configureEnvironment(rsjfw::wine::Prefix &pfx, bool isProton) {
     }
   }
 
-  pfx.appendEnv("WINEESYNC", "1");
+  Performance::instance().configureEnvironment(pfx, isProton);
   pfx.appendEnv("SDL_VIDEODRIVER", "x11");
   pfx.appendEnv("VK_LOADER_LAYERS_ENABLE", "VK_LAYER_RSJFW_RsjfwLayer");
 
+  if (genCfg.dxvk && !activeVersion_.empty()) {
+    ShaderCache::instance().configureEnvironment(pfx, activeVersion_);
+  }
+
   if (genCfg.selectedGpu >= 0) {
     pfx.appendEnv("DRI_PRIME", std::to_string(genCfg.selectedGpu));
   }
@@ -580,8 +616,7 @@ void Launcher::configureEnvironment(rsjfw::wine::Prefix &pfx, bool isProton) {
 
   std::string dllOverrides = "dxdiagn=;winemenubuilder.exe=;mscoree=;mshtml=;"
                              "gameoverlayrenderer=;gameoverlayrenderer64=;";
-  bool useDxvk = Config::instance().getGeneral().dxvk;
-  if (useDxvk) {
+  if (genCfg.dxvk) {
     dllOverrides = "dxgi,d3d11,d3d10core,d3d9=n,b;" + dllOverrides;
   }
 
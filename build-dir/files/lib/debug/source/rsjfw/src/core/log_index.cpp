@@ -0,0 +1,328 @@
+#include "rsjfw/log_index.hpp"
+#include "rsjfw/log_retention.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/task_runner.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rsjfw {
+
+namespace {
+// Publish partial results this often during a large scan
+constexpr uint64_t PUBLISH_BYTES = 8ull << 20;
+// Rows longer than this are cut when drawn
+constexpr uint32_t MAX_ROW_BYTES = 16 * 1024;
+
+bool contains(const char *data, size_t len, const char *needle) {
+  return memmem(data, len, needle, strlen(needle)) != nullptr;
+}
+
+bool readAt(int fd, uint64_t offset, size_t len, char *out) {
+  size_t done = 0;
+  while (done < len) {
+    ssize_t n = ::pread(fd, out + done, len - done, offset + done);
+    if (n <= 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+} // namespace
+
+std::shared_ptr<LogIndex> LogIndex::create() {
+  return std::shared_ptr<LogIndex>(new LogIndex());
+}
+
+LogIndex::~LogIndex() {
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+// Same rules the viewer always used, plus Wine's "err:" channel prefix
+LogIndex::Level LogIndex::classify(const char *data, size_t len) {
+  if (contains(data, len, "[ERROR]") || contains(data, len, "error") ||
+      contains(data, len, "err:"))
+    return LEVEL_ERROR;
+  if (contains(data, len, "[WARN]") || contains(data, len, "warn"))
+    return LEVEL_WARN;
+  return LEVEL_INFO;
+}
+
+void LogIndex::open(const std::string &path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path == path_)
+      return;
+    path_ = path;
+    generation_++;
+    pendingScan_ = true;
+  }
+  schedule();
+}
+
+void LogIndex::refresh() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty())
+      return;
+    pendingScan_ = true;
+  }
+  schedule();
+}
+
+void LogIndex::setFilter(unsigned levelMask) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (levelMask == mask_)
+      return;
+    mask_ = levelMask;
+    pendingFilter_ = true;
+  }
+  schedule();
+}
+
+size_t LogIndex::lineCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return indexedGeneration_ == generation_ ? lines_.size() : 0;
+}
+
+size_t LogIndex::visibleCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (indexedGeneration_ != generation_)
+    return 0;
+  return visibleMask_ == LEVEL_ALL ? lines_.size() : visible_.size();
+}
+
+bool LogIndex::busy() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+void LogIndex::rows(size_t first, size_t last, std::vector<Row> &out) {
+  out.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (indexedGeneration_ != generation_ || fd_ < 0)
+    return;
+
+  bool all = visibleMask_ == LEVEL_ALL;
+  size_t count = all ? lines_.size() : visible_.size();
+  last = std::min(last, count);
+  if (first >= last)
+    return;
+
+  std::vector<size_t> ids;
+  ids.reserve(last - first);
+  for (size_t i = first; i < last; ++i)
+    ids.push_back(all ? i : visible_[i]);
+
+  // Consecutive rows usually sit in one small span of the file
+  const Line &lo = lines_[ids.front()];
+  const Line &hi = lines_[ids.back()];
+  uint64_t spanEnd = hi.offset + hi.length;
+  std::string span;
+  if (spanEnd - lo.offset <= 256 * 1024) {
+    span.resize(spanEnd - lo.offset);
+    if (!readAt(fd_, lo.offset, span.size(), span.data()))
+      span.clear();
+  }
+
+  for (size_t id : ids) {
+    const Line &line = lines_[id];
+    Row row;
+    row.lineNo = id + 1;
+    row.level = line.level;
+    uint32_t len = std::min(line.length, MAX_ROW_BYTES);
+    if (!span.empty()) {
+      row.text.assign(span, line.offset - lo.offset, len);
+    } else {
+      row.text.resize(len);
+      if (!readAt(fd_, line.offset, len, row.text.data()))
+        row.text.clear();
+    }
+    if (len < line.length)
+      row.text += " ...";
+    out.push_back(std::move(row));
+  }
+}
+
+std::string LogIndex::text() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string out;
+  if (indexedGeneration_ != generation_ || fd_ < 0 || lines_.empty())
+    return out;
+  const Line &back = lines_.back();
+  out.resize(back.offset + back.length);
+  if (!readAt(fd_, 0, out.size(), out.data()))
+    out.clear();
+  return out;
+}
+
+void LogIndex::schedule() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+      return;
+    running_ = true;
+  }
+  auto self = shared_from_this();
+  TaskRunner::instance().run([self]() { self->work(); });
+}
+
+void LogIndex::work() {
+  for (;;) {
+    bool doScan, doFilter;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      doScan = pendingScan_;
+      doFilter = pendingFilter_;
+      pendingScan_ = pendingFilter_ = false;
+      if (!doScan && !doFilter) {
+        running_ = false;
+        return;
+      }
+    }
+    if (doFilter)
+      refilter();
+    if (doScan)
+      scan();
+  }
+}
+
+void LogIndex::refilter() {
+  unsigned mask;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mask = mask_;
+  }
+
+  std::vector<uint32_t> visible;
+  if (mask != LEVEL_ALL) {
+    for (size_t i = 0; i < lines_.size(); ++i)
+      if (lines_[i].level & mask)
+        visible.push_back((uint32_t)i);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  visible_ = std::move(visible);
+  visibleMask_ = mask;
+}
+
+void LogIndex::scan() {
+  std::string path;
+  uint64_t generation;
+  bool reset;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path = path_;
+    generation = generation_;
+    reset = indexedGeneration_ != generation_;
+  }
+
+  // Compressed archives are read through a decompressed copy
+  std::string source = LogRetention::readablePath(path).string();
+  int fd = source.empty() ? -1 : ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || ::fstat(fd, &st) != 0) {
+    if (fd >= 0)
+      ::close(fd);
+    LOG_DEBUG("Cannot index log: " + path);
+    return;
+  }
+
+  uint64_t size = (uint64_t)st.st_size;
+  uint64_t from = indexedBytes_;
+  // Rotated or truncated underneath us
+  if (reset || st.st_dev != dev_ || st.st_ino != ino_ || size < from) {
+    reset = true;
+    from = 0;
+  }
+
+  const char *base = nullptr;
+  uint64_t mapOffset = from & ~(uint64_t)(sysconf(_SC_PAGESIZE) - 1);
+  size_t mapLen = size - mapOffset;
+  if (size > from) {
+    void *p = ::mmap(nullptr, mapLen, PROT_READ, MAP_PRIVATE, fd, mapOffset);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      LOG_WARN("Failed to map log: " + path);
+      return;
+    }
+    ::madvise(p, mapLen, MADV_SEQUENTIAL);
+    base = static_cast<const char *>(p) - mapOffset;
+  }
+
+  std::vector<Line> fresh;
+  uint64_t pos = from;
+  bool tail = false;
+  bool first = true;
+
+  auto publish = [&]() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != generation_)
+      return false;
+    if (first) {
+      first = false;
+      if (reset) {
+        lines_.clear();
+        visible_.clear();
+        indexedGeneration_ = generation;
+        dev_ = st.st_dev;
+        ino_ = st.st_ino;
+        if (fd_ >= 0)
+          ::close(fd_);
+        fd_ = fd;
+        fd = -1;
+      } else if (partialTail_ && !lines_.empty()) {
+        // The unterminated line is re-read with whatever was appended
+        if (!visible_.empty() && visible_.back() == lines_.size() - 1)
+          visible_.pop_back();
+        lines_.pop_back();
+      }
+    }
+    for (const Line &line : fresh) {
+      if (visibleMask_ != LEVEL_ALL && (line.level & visibleMask_))
+        visible_.push_back((uint32_t)lines_.size());
+      lines_.push_back(line);
+    }
+    fresh.clear();
+    indexedBytes_ = pos;
+    partialTail_ = tail;
+    return true;
+  };
+
+  uint64_t lastPublish = from;
+  bool live = true;
+  while (pos < size && live) {
+    const char *start = base + pos;
+    const char *nl =
+        static_cast<const char *>(memchr(start, '\n', size - pos));
+    if (!nl) {
+      fresh.push_back({pos, (uint32_t)(size - pos),
+                       classify(start, size - pos)});
+      tail = true;
+      break;
+    }
+    size_t len = nl - start;
+    size_t textLen = (len && start[len - 1] == '\r') ? len - 1 : len;
+    fresh.push_back({pos, (uint32_t)textLen, classify(start, textLen)});
+    pos += len + 1;
+
+    if (pos - lastPublish >= PUBLISH_BYTES) {
+      live = publish();
+      lastPublish = pos;
+    }
+  }
+  if (live && (first || !fresh.empty() || tail != partialTail_))
+    publish();
+
+  if (base)
+    ::munmap(const_cast<char *>(base + mapOffset), mapLen);
+  if (fd >= 0)
+    ::close(fd);
+}
+
+} // namespace rsjfw
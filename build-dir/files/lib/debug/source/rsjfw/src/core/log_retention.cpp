@@ -0,0 +1,457 @@
+#include "rsjfw/log_retention.hpp"
+#include "rsjfw/config.hpp"
+#include "rsjfw/event_log.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/task_runner.hpp"
+#include <algorithm>
+#include <archive.h>
+#include <archive_entry.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace rsjfw {
+
+namespace {
+
+const char *STUDIO_LOG = "studio_latest.events";
+constexpr uint64_t VIEW_CACHE_BYTES = 256ull << 20;
+
+bool writeAll(int fd, const char *data, size_t len) {
+  while (len > 0) {
+    ssize_t n = ::write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+// Holds an exclusive flock while alive; fails if a writer holds the file
+struct ExclusiveLock {
+  int fd = -1;
+  explicit ExclusiveLock(const fs::path &path) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0 && ::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  ~ExclusiveLock() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+  bool held() const { return fd >= 0; }
+};
+
+void copyMtime(const fs::path &from, const fs::path &to) {
+  struct stat st;
+  if (::stat(from.c_str(), &st) != 0)
+    return;
+  struct timespec times[2] = {st.st_atim, st.st_mtim};
+  ::utimensat(AT_FDCWD, to.c_str(), times, 0);
+}
+
+} // namespace
+
+// --- RotatingLogFile ---
+
+RotatingLogFile::~RotatingLogFile() { close(); }
+
+bool RotatingLogFile::open(const fs::path &path, bool append) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fd_ >= 0)
+    ::close(fd_);
+  path_ = path;
+  return openFd(append);
+}
+
+bool RotatingLogFile::openFd(bool append) {
+  fd_ = ::open(path_.c_str(),
+               O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (append ? 0 : O_TRUNC),
+               0644);
+  if (fd_ < 0)
+    return false;
+  ::flock(fd_, LOCK_SH);
+
+  struct stat st;
+  size_ = ::fstat(fd_, &st) == 0 ? st.st_size : 0;
+  if (size_ == 0 && !header_.empty() &&
+      writeAll(fd_, header_.data(), header_.size()))
+    size_ = header_.size();
+  return true;
+}
+
+bool RotatingLogFile::write(const char *data, size_t len) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fd_ < 0)
+    return false;
+  bool ok = writeAll(fd_, data, len);
+  size_ += len;
+
+  uint64_t limit = maxBytes_;
+  if (limit > 0 && size_ >= limit)
+    rotate();
+  return ok;
+}
+
+void RotatingLogFile::rotate() {
+  // Must not log from here: the Logger's writer thread ends up in this path
+  fs::path archived = LogRetention::archive(path_, std::time(nullptr));
+  ::close(fd_);
+  fd_ = -1;
+  if (archived.empty()) {
+    // Could not move it aside; keep appending rather than lose output
+    openFd(true);
+    return;
+  }
+  openFd(false);
+  LogRetention::instance().schedule();
+}
+
+void RotatingLogFile::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+// --- LogRetention ---
+
+LogRetention &LogRetention::instance() {
+  static LogRetention instance;
+  return instance;
+}
+
+fs::path LogRetention::archive(const fs::path &live, std::time_t when) {
+  std::error_code ec;
+  if (!fs::exists(live, ec))
+    return {};
+
+  char stamp[32];
+  struct tm tm;
+  localtime_r(&when, &tm);
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm);
+
+  std::string stem = live.stem().string();
+  if (stem.size() > 7 && stem.compare(stem.size() - 7, 7, "_latest") == 0)
+    stem.resize(stem.size() - 7);
+
+  std::string ext = live.extension().string();
+  fs::path dest = live.parent_path() / (stem + "_" + stamp + ext);
+  for (int i = 1; fs::exists(dest, ec); ++i)
+    dest = live.parent_path() /
+           (stem + "_" + stamp + "_" + std::to_string(i) + ext);
+
+  fs::rename(live, dest, ec);
+  return ec ? fs::path() : dest;
+}
+
+bool LogRetention::isCompressed(const fs::path &path) {
+  return path.extension() == ".zst";
+}
+
+bool LogRetention::isLogFile(const fs::path &path) {
+  fs::path ext = isCompressed(path) ? path.stem().extension() : path.extension();
+  return ext == ".log" || ext == EventLog::EXTENSION;
+}
+
+bool LogRetention::compress(const fs::path &src, const fs::path &dest) {
+  int in = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in < 0)
+    return false;
+  struct stat st;
+  if (::fstat(in, &st) != 0) {
+    ::close(in);
+    return false;
+  }
+
+  fs::path tmp = dest;
+  tmp += ".tmp";
+
+  struct archive *a = archive_write_new();
+  archive_write_add_filter_zstd(a);
+  archive_write_set_format_raw(a);
+  bool ok = archive_write_open_filename(a, tmp.c_str()) == ARCHIVE_OK;
+
+  if (ok) {
+    struct archive_entry *entry = archive_entry_new();
+    archive_entry_set_pathname(entry, src.filename().c_str());
+    archive_entry_set_filetype(entry, AE_IFREG);
+    archive_entry_set_size(entry, st.st_size);
+    ok = archive_write_header(a, entry) == ARCHIVE_OK;
+    archive_entry_free(entry);
+  }
+
+  std::vector<char> buf(256 * 1024);
+  while (ok) {
+    ssize_t n = ::read(in, buf.data(), buf.size());
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      ok = n == 0;
+      break;
+    }
+    ok = archive_write_data(a, buf.data(), n) == n;
+  }
+  if (!ok)
+    LOG_WARN("Failed to compress " + src.string() + ": " +
+             (archive_error_string(a) ? archive_error_string(a) : "read error"));
+
+  ok = archive_write_close(a) == ARCHIVE_OK && ok;
+  archive_write_free(a);
+  ::close(in);
+
+  std::error_code ec;
+  if (ok) {
+    copyMtime(src, tmp);
+    fs::rename(tmp, dest, ec);
+    ok = !ec;
+  }
+  if (!ok)
+    fs::remove(tmp, ec);
+  return ok;
+}
+
+bool LogRetention::decompress(const fs::path &src, const fs::path &dest) {
+  struct archive *a = archive_read_new();
+  archive_read_support_filter_all(a);
+  archive_read_support_format_raw(a);
+  if (archive_read_open_filename(a, src.c_str(), 256 * 1024) != ARCHIVE_OK) {
+    const char *err = archive_error_string(a);
+    LOG_WARN("Cannot open compressed log " + src.string() + ": " +
+             (err ? err : "unknown error"));
+    archive_read_free(a);
+    return false;
+  }
+
+  // The viewer and search may both want the same archive at once
+  fs::path tmp = dest;
+  tmp += ".tmp" + std::to_string(
+                      std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  struct archive_entry *entry;
+  bool ok = out >= 0 && archive_read_next_header(a, &entry) == ARCHIVE_OK;
+  std::vector<char> buf(256 * 1024);
+  while (ok) {
+    auto n = archive_read_data(a, buf.data(), buf.size());
+    if (n == 0)
+      break;
+    ok = n > 0 && writeAll(out, buf.data(), n);
+  }
+  archive_read_close(a);
+  archive_read_free(a);
+  if (out >= 0)
+    ::close(out);
+
+  std::error_code ec;
+  if (ok) {
+    copyMtime(src, tmp);
+    fs::rename(tmp, dest, ec);
+    ok = !ec;
+  }
+  if (!ok)
+    fs::remove(tmp, ec);
+  return ok;
+}
+
+fs::path LogRetention::readablePath(const fs::path &path) {
+  bool compressed = isCompressed(path);
+  bool events = EventLog::isEventLog(path);
+  if (!compressed && !events)
+    return path;
+
+  fs::path viewDir = PathManager::instance().cache() / "log_view";
+  fs::path view = viewDir / (compressed ? path.stem() : path.filename());
+  if (events)
+    view += ".txt";
+  std::error_code ec;
+  fs::create_directories(viewDir, ec);
+
+  // Live event logs are rendered incrementally on every call
+  if (!compressed)
+    return EventLog::render(path, view) ? view : fs::path();
+
+  // The copy carries the archive's mtime, which tells us it is current
+  struct stat src, dst;
+  if (::stat(path.c_str(), &src) != 0)
+    return {};
+  if (::stat(view.c_str(), &dst) == 0 &&
+      dst.st_mtim.tv_sec == src.st_mtim.tv_sec &&
+      dst.st_mtim.tv_nsec == src.st_mtim.tv_nsec)
+    return view;
+
+  if (!events)
+    return decompress(path, view) ? view : fs::path();
+
+  fs::path raw = viewDir / path.stem();
+  raw += ".tmp" + std::to_string(std::hash<std::thread::id>{}(
+                      std::this_thread::get_id()));
+  bool ok = decompress(path, raw) && EventLog::render(raw, view);
+  fs::remove(raw, ec);
+  if (!ok)
+    return {};
+  copyMtime(path, view);
+  return view;
+}
+
+void LogRetention::schedule() {
+  if (queued_.exchange(true))
+    return;
+  TaskRunner::instance().run(
+      [this]() {
+        queued_ = false;
+        run();
+      },
+      TaskPriority::BACKGROUND, "Log retention");
+}
+
+void LogRetention::run() {
+  std::lock_guard<std::mutex> runLock(runMutex_);
+
+  LogsConfig cfg = Config::instance().snapshot()->logs;
+
+  auto &pm = PathManager::instance();
+  fs::path logsDir = pm.logs();
+  fs::path oldDir = logsDir / "old";
+  fs::path current = pm.currentLog();
+  std::error_code ec;
+  if (!fs::exists(logsDir, ec))
+    return;
+  fs::create_directories(oldDir, ec);
+
+  auto isLive = [&](const fs::path &p) {
+    return p == current || p.filename() == STUDIO_LOG;
+  };
+
+  // 1. Closed plain logs go into old/, compressed unless disabled
+  int archived = 0;
+  std::vector<fs::path> plain;
+  for (const fs::path &dir : {logsDir, oldDir}) {
+    for (const auto &entry : fs::directory_iterator(dir, ec)) {
+      const fs::path &p = entry.path();
+      if (entry.is_regular_file(ec) && isLogFile(p) && !isCompressed(p) &&
+          !isLive(p))
+        plain.push_back(entry.path());
+    }
+  }
+  for (const auto &path : plain) {
+    ExclusiveLock lock(path);
+    if (!lock.held())
+      continue; // Another RSJFW process is still writing it
+
+    fs::path dest = oldDir / path.filename();
+    if (cfg.compress) {
+      dest += ".zst";
+      if (!compress(path, dest))
+        continue;
+      fs::remove(path, ec);
+      archived++;
+    } else if (path.parent_path() != oldDir) {
+      fs::rename(path, dest, ec);
+      archived += !ec;
+    }
+  }
+
+  // 2. Age limit, 3. total size cap (oldest first). Live logs count towards
+  // the total but are never removed.
+  struct Candidate {
+    fs::path path;
+    uint64_t size;
+    fs::file_time_type mtime;
+  };
+  std::vector<Candidate> candidates;
+  uint64_t total = 0;
+  for (auto it = fs::recursive_directory_iterator(logsDir, ec);
+       it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    if (ec)
+      break;
+    if (!it->is_regular_file(ec))
+      continue;
+    uint64_t size = it->file_size(ec);
+    total += size;
+    const fs::path &p = it->path();
+    if (isLogFile(p) && !isLive(p))
+      candidates.push_back({p, size, it->last_write_time(ec)});
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) {
+              return a.mtime < b.mtime;
+            });
+
+  auto now = fs::file_time_type::clock::now();
+  uint64_t cap = (uint64_t)std::max(cfg.maxTotalMB, 0) << 20;
+  int removed = 0;
+  uint64_t freed = 0;
+  for (const auto &c : candidates) {
+    bool expired =
+        cfg.maxAgeDays > 0 && now - c.mtime > std::chrono::hours(24) * cfg.maxAgeDays;
+    bool overCap = cap > 0 && total > cap;
+    if (!expired && !overCap)
+      continue;
+    ExclusiveLock lock(c.path);
+    if (!lock.held())
+      continue;
+    if (fs::remove(c.path, ec)) {
+      total -= c.size;
+      freed += c.size;
+      removed++;
+    }
+  }
+
+  // Readable copies: drop those whose source is gone, then keep the most
+  // recently extracted ones within VIEW_CACHE_BYTES. Temporaries of a
+  // concurrent readablePath() are left alone.
+  fs::path viewDir = pm.cache() / "log_view";
+  std::vector<std::pair<time_t, fs::path>> views;
+  uint64_t viewBytes = 0;
+  for (const auto &entry : fs::directory_iterator(viewDir, ec)) {
+    fs::path name = entry.path().filename();
+    if (name.extension() == ".txt")
+      name = name.stem();
+    if (!isLogFile(name))
+      continue;
+    fs::path archive = oldDir / name;
+    archive += ".zst";
+    bool plainEvents = EventLog::isEventLog(name) &&
+                       (fs::exists(logsDir / name, ec) ||
+                        fs::exists(oldDir / name, ec));
+    struct stat st;
+    if ((!plainEvents && !fs::exists(archive, ec)) ||
+        ::stat(entry.path().c_str(), &st) != 0) {
+      fs::remove(entry.path(), ec);
+      continue;
+    }
+    viewBytes += st.st_size;
+    views.push_back({st.st_ctime, entry.path()});
+  }
+  std::sort(views.begin(), views.end());
+  for (const auto &[ctime, path] : views) {
+    if (viewBytes <= VIEW_CACHE_BYTES)
+      break;
+    uint64_t size = fs::file_size(path, ec);
+    if (fs::remove(path, ec))
+      viewBytes -= size;
+  }
+
+  if (archived || removed)
+    LOG_INFO("Log retention: archived " + std::to_string(archived) +
+             ", removed " + std::to_string(removed) + " (" +
+             std::to_string(freed >> 20) + " MB), logs now " +
+             std::to_string(total >> 20) + " MB");
+}
+
+} // namespace rsjfw
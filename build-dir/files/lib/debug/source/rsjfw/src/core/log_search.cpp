@@ -0,0 +1,724 @@
+#include "rsjfw/log_search.hpp"
+#include "rsjfw/event_log.hpp"
+#include "rsjfw/log_retention.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/task_runner.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace rsjfw {
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'R', 'S', 'J', 'F', 'W', 'L', 'S', '1'};
+
+// Blocks end on a line boundary at or after this many bytes
+constexpr uint64_t BLOCK_BYTES = 256 * 1024;
+constexpr uint32_t FINGERPRINT_BYTES = 4096;
+
+inline unsigned char lower(unsigned char c) {
+  return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+inline uint32_t trigram(const unsigned char *p) {
+  return (uint32_t)lower(p[0]) << 16 | (uint32_t)lower(p[1]) << 8 |
+         lower(p[2]);
+}
+
+bool readAt(int fd, uint64_t offset, size_t len, char *out) {
+  size_t done = 0;
+  while (done < len) {
+    ssize_t n = ::pread(fd, out + done, len - done, offset + done);
+    if (n <= 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+
+uint64_t fingerprintOf(const fs::path &path, uint32_t len) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  if (len == 0)
+    return h;
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return 0;
+  std::string buf(len, '\0');
+  bool ok = readAt(fd, 0, len, buf.data());
+  ::close(fd);
+  if (!ok)
+    return 0;
+  for (unsigned char c : buf) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// "[2024-01-02 03:04:05] [INFO] ..." -> "2024-01-02 03:04:05"
+std::string timestampOf(const std::string &line) {
+  if (line.size() < 21 || line[0] != '[' || line[20] != ']' ||
+      !std::isdigit((unsigned char)line[1]))
+    return "";
+  return line.substr(1, 19);
+}
+
+// Distinct trigrams of a block, collected through a reusable bitmap
+class TrigramSet {
+public:
+  TrigramSet() : bits_(1u << 18, 0) {}
+
+  void add(const unsigned char *data, size_t len) {
+    for (size_t i = 0; i + 2 < len; ++i) {
+      uint32_t t = trigram(data + i);
+      uint64_t &word = bits_[t >> 6];
+      uint64_t bit = 1ULL << (t & 63);
+      if (!(word & bit)) {
+        word |= bit;
+        list_.push_back(t);
+      }
+    }
+  }
+
+  // Returns the collected trigrams and clears the set
+  std::vector<uint32_t> take() {
+    for (uint32_t t : list_)
+      bits_[t >> 6] = 0;
+    std::vector<uint32_t> out;
+    out.swap(list_);
+    return out;
+  }
+
+private:
+  std::vector<uint64_t> bits_;
+  std::vector<uint32_t> list_;
+};
+
+template <typename T> void put(std::ofstream &f, T v) {
+  f.write(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template <typename T> bool get(std::ifstream &f, T &v) {
+  return (bool)f.read(reinterpret_cast<char *>(&v), sizeof(v));
+}
+
+void putVarint(std::ofstream &f, uint32_t v) {
+  while (v >= 0x80) {
+    f.put((char)(v | 0x80));
+    v >>= 7;
+  }
+  f.put((char)v);
+}
+
+bool getVarint(std::ifstream &f, uint32_t &v) {
+  v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    int c = f.get();
+    if (c == EOF)
+      return false;
+    v |= (uint32_t)(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+  }
+  return false;
+}
+
+fs::path indexPath() {
+  return PathManager::instance().cache() / "log_search.idx";
+}
+
+} // namespace
+
+LogSearch &LogSearch::instance() {
+  static LogSearch instance;
+  return instance;
+}
+
+void LogSearch::attach() {
+  Logger::instance().setWriteListener(
+      [this](const fs::path &, uint64_t size) {
+        // The session log starts over after a rotation
+        if (size + BLOCK_BYTES < nextLiveSync_)
+          nextLiveSync_ = size + BLOCK_BYTES;
+        if (size < nextLiveSync_)
+          return;
+        nextLiveSync_ = size + BLOCK_BYTES;
+        scheduleSync();
+      });
+}
+
+void LogSearch::scheduleSync() {
+  if (syncQueued_.exchange(true))
+    return;
+  TaskRunner::instance().run(
+      [this]() {
+        syncQueued_ = false;
+        sync();
+      },
+      TaskPriority::BACKGROUND, "Log index sync");
+}
+
+void LogSearch::load() {
+  loaded_ = true;
+  std::ifstream f(indexPath(), std::ios::binary);
+  if (!f.is_open())
+    return;
+
+  char magic[8];
+  if (!f.read(magic, sizeof(magic)) ||
+      memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0)
+    return;
+
+  std::vector<File> files;
+  std::vector<Block> blocks;
+  std::vector<bool> dead;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+
+  uint32_t count;
+  if (!get(f, count))
+    return;
+  for (uint32_t i = 0; i < count; ++i) {
+    File file;
+    uint32_t nameLen;
+    uint8_t alive;
+    if (!get(f, nameLen) || nameLen > 4096)
+      return;
+    file.name.resize(nameLen);
+    if (!f.read(file.name.data(), nameLen) || !get(f, file.dev) ||
+        !get(f, file.ino) || !get(f, file.fingerprint) ||
+        !get(f, file.fingerprintLen) || !get(f, file.indexedBytes) ||
+        !get(f, file.lines) || !get(f, alive))
+      return;
+    file.alive = alive;
+    files.push_back(std::move(file));
+  }
+
+  if (!get(f, count))
+    return;
+  size_t deadCount = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    Block block;
+    uint8_t isDead;
+    if (!get(f, block.file) || !get(f, block.offset) ||
+        !get(f, block.length) || !get(f, block.firstLine) ||
+        !get(f, isDead) || block.file >= files.size())
+      return;
+    blocks.push_back(block);
+    dead.push_back(isDead);
+    deadCount += isDead;
+  }
+
+  if (!get(f, count))
+    return;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t t, n;
+    if (!get(f, t) || !get(f, n) || n > blocks.size())
+      return;
+    auto &list = postings[t];
+    list.reserve(n);
+    uint32_t id = 0;
+    for (uint32_t j = 0; j < n; ++j) {
+      uint32_t delta;
+      if (!getVarint(f, delta))
+        return;
+      id += delta;
+      if (id >= blocks.size())
+        return;
+      list.push_back(id);
+    }
+  }
+
+  files_ = std::move(files);
+  blocks_ = std::move(blocks);
+  deadBlocks_ = std::move(dead);
+  deadCount_ = deadCount;
+  postings_ = std::move(postings);
+  LOG_DEBUG("Loaded log search index: " + std::to_string(files_.size()) +
+            " files, " + std::to_string(blocks_.size()) + " blocks");
+}
+
+bool LogSearch::save() {
+  fs::path path = indexPath();
+  fs::path tmp = path;
+  tmp += ".tmp";
+
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+
+  {
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f.is_open())
+      return false;
+
+    f.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    put<uint32_t>(f, files_.size());
+    for (const auto &file : files_) {
+      put<uint32_t>(f, file.name.size());
+      f.write(file.name.data(), file.name.size());
+      put(f, file.dev);
+      put(f, file.ino);
+      put(f, file.fingerprint);
+      put(f, file.fingerprintLen);
+      put(f, file.indexedBytes);
+      put(f, file.lines);
+      put<uint8_t>(f, file.alive);
+    }
+
+    put<uint32_t>(f, blocks_.size());
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      const auto &b = blocks_[i];
+      put(f, b.file);
+      put(f, b.offset);
+      put(f, b.length);
+      put(f, b.firstLine);
+      put<uint8_t>(f, deadBlocks_[i]);
+    }
+
+    put<uint32_t>(f, postings_.size());
+    for (const auto &[t, list] : postings_) {
+      put(f, t);
+      put<uint32_t>(f, list.size());
+      uint32_t prev = 0;
+      for (uint32_t id : list) {
+        putVarint(f, id - prev);
+        prev = id;
+      }
+    }
+    if (!f)
+      return false;
+  }
+
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    LOG_WARN("Could not save log search index: " + ec.message());
+    fs::remove(tmp, ec);
+    return false;
+  }
+  dirty_ = false;
+  return true;
+}
+
+void LogSearch::resetFile(uint32_t fileId) {
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    if (blocks_[i].file == fileId && !deadBlocks_[i]) {
+      deadBlocks_[i] = true;
+      deadCount_++;
+    }
+  }
+  File &file = files_[fileId];
+  file.indexedBytes = 0;
+  file.lines = 0;
+  file.fingerprint = 0;
+  file.fingerprintLen = 0;
+  dirty_ = true;
+}
+
+// Drops dead blocks and deleted files, renumbering what is left
+void LogSearch::compact() {
+  std::vector<uint32_t> fileMap(files_.size(), UINT32_MAX);
+  std::vector<File> files;
+  for (size_t i = 0; i < files_.size(); ++i) {
+    if (files_[i].alive) {
+      fileMap[i] = files.size();
+      files.push_back(files_[i]);
+    }
+  }
+
+  std::vector<uint32_t> blockMap(blocks_.size(), UINT32_MAX);
+  std::vector<Block> blocks;
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    if (deadBlocks_[i] || fileMap[blocks_[i].file] == UINT32_MAX)
+      continue;
+    blockMap[i] = blocks.size();
+    Block b = blocks_[i];
+    b.file = fileMap[b.file];
+    blocks.push_back(b);
+  }
+
+  for (auto it = postings_.begin(); it != postings_.end();) {
+    auto &list = it->second;
+    size_t out = 0;
+    for (uint32_t id : list)
+      if (blockMap[id] != UINT32_MAX)
+        list[out++] = blockMap[id];
+    list.resize(out);
+    if (list.empty())
+      it = postings_.erase(it);
+    else
+      ++it;
+  }
+
+  files_ = std::move(files);
+  blocks_ = std::move(blocks);
+  deadBlocks_.assign(blocks_.size(), false);
+  deadCount_ = 0;
+  dirty_ = true;
+}
+
+void LogSearch::indexFile(uint32_t fileId, const fs::path &path,
+                          uint64_t size, bool growing) {
+  uint64_t from, lines;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    from = files_[fileId].indexedBytes;
+    lines = files_[fileId].lines;
+  }
+  // A growing log only gets whole blocks; the rest is scanned per query
+  if (size <= from || (growing && size - from < BLOCK_BYTES))
+    return;
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+
+  uint64_t mapOffset = from & ~(uint64_t)(sysconf(_SC_PAGESIZE) - 1);
+  size_t mapLen = size - mapOffset;
+  void *map = ::mmap(nullptr, mapLen, PROT_READ, MAP_PRIVATE, fd, mapOffset);
+  ::close(fd);
+  if (map == MAP_FAILED)
+    return;
+  ::madvise(map, mapLen, MADV_SEQUENTIAL);
+  const unsigned char *base =
+      static_cast<const unsigned char *>(map) - mapOffset;
+
+  TrigramSet set;
+  uint64_t pos = from;
+  while (pos < size) {
+    uint64_t want = std::min(pos + BLOCK_BYTES, size);
+    const void *nl = memchr(base + want - 1, '\n', size - (want - 1));
+    uint64_t end;
+    if (nl) {
+      end = static_cast<const unsigned char *>(nl) - base + 1;
+    } else if (!growing) {
+      // Last block of a finished log: stop at its last complete line
+      const void *last = memrchr(base + pos, '\n', size - pos);
+      if (!last)
+        break;
+      end = static_cast<const unsigned char *>(last) - base + 1;
+    } else {
+      break;
+    }
+    if (growing && end - pos < BLOCK_BYTES)
+      break;
+
+    set.add(base + pos, end - pos);
+    std::vector<uint32_t> trigrams = set.take();
+    uint64_t blockLines = std::count(base + pos, base + end, '\n');
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      File &file = files_[fileId];
+      if (file.indexedBytes != pos)
+        break; // Reset underneath us
+      uint32_t id = blocks_.size();
+      blocks_.push_back({fileId, pos, (uint32_t)(end - pos), lines});
+      deadBlocks_.push_back(false);
+      for (uint32_t t : trigrams)
+        postings_[t].push_back(id);
+      file.indexedBytes = end;
+      file.lines = lines + blockLines;
+      dirty_ = true;
+    }
+    lines += blockLines;
+    pos = end;
+  }
+
+  ::munmap(map, mapLen);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  File &file = files_[fileId];
+  uint32_t fpLen = (uint32_t)std::min<uint64_t>(FINGERPRINT_BYTES,
+                                                file.indexedBytes);
+  if (fpLen != file.fingerprintLen) {
+    file.fingerprintLen = fpLen;
+    file.fingerprint = fingerprintOf(path, fpLen);
+  }
+}
+
+void LogSearch::sync() {
+  std::lock_guard<std::mutex> syncLock(syncMutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!loaded_)
+      load();
+  }
+
+  fs::path logsDir = PathManager::instance().logs();
+  fs::path current = PathManager::instance().currentLog();
+  std::error_code ec;
+  if (!fs::exists(logsDir, ec))
+    return;
+
+  std::vector<bool> seen;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    seen.assign(files_.size(), false);
+  }
+
+  for (auto it = fs::recursive_directory_iterator(
+           logsDir, fs::directory_options::skip_permission_denied, ec);
+       it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    if (ec)
+      break;
+    const fs::path &path = it->path();
+    bool compressed = LogRetention::isCompressed(path);
+    if (!it->is_regular_file(ec) || !LogRetention::isLogFile(path))
+      continue;
+
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+      continue;
+    std::string name = fs::relative(path, logsDir, ec).string();
+    bool growing = path == current || path.stem() == "studio_latest";
+
+    // Event logs are indexed through their rendered text, which grows
+    // along with them
+    fs::path data = path;
+    uint64_t dataSize = st.st_size;
+    if (!compressed && EventLog::isEventLog(path)) {
+      data = LogRetention::readablePath(path);
+      struct stat dataSt;
+      if (data.empty() || ::stat(data.c_str(), &dataSt) != 0)
+        continue;
+      dataSize = dataSt.st_size;
+    }
+
+    uint32_t id = UINT32_MAX;
+    uint64_t fpLen = 0, fp = 0, indexed = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t i = 0; i < files_.size(); ++i) {
+        if (files_[i].alive && files_[i].name == name) {
+          id = i;
+          break;
+        }
+      }
+      if (id == UINT32_MAX) {
+        id = files_.size();
+        File file;
+        file.name = name;
+        files_.push_back(file);
+        seen.push_back(false);
+        dirty_ = true;
+      }
+      seen[id] = true;
+
+      File &file = files_[id];
+      if (file.dev != (uint64_t)st.st_dev || file.ino != (uint64_t)st.st_ino ||
+          (!compressed && dataSize < file.indexedBytes)) {
+        resetFile(id);
+        file.dev = st.st_dev;
+        file.ino = st.st_ino;
+      }
+      fpLen = file.fingerprintLen;
+      fp = file.fingerprint;
+      indexed = file.indexedBytes;
+    }
+
+    // Archives never change; index the decompressed text once and drop
+    // the copy again, searches recreate it on demand
+    if (compressed) {
+      if (indexed > 0)
+        continue;
+      fs::path data = LogRetention::readablePath(path);
+      struct stat dataSt;
+      if (data.empty() || ::stat(data.c_str(), &dataSt) != 0)
+        continue;
+      indexFile(id, data, dataSt.st_size, false);
+      fs::remove(data, ec);
+      continue;
+    }
+
+    // Same inode, rewritten from the start
+    if (fpLen && fingerprintOf(data, fpLen) != fp) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      resetFile(id);
+    }
+
+    indexFile(id, data, dataSize, growing);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < seen.size(); ++i) {
+    if (!seen[i] && files_[i].alive) {
+      resetFile(i);
+      files_[i].alive = false;
+    }
+  }
+  if (deadCount_ > 0 && deadCount_ * 2 > blocks_.size())
+    compact();
+  if (dirty_)
+    save();
+}
+
+LogSearch::Result LogSearch::search(const std::string &query,
+                                    unsigned levelMask, size_t maxHits) {
+  auto started = std::chrono::steady_clock::now();
+  Result result;
+
+  std::string needle;
+  for (unsigned char c : query)
+    needle += (char)lower(c);
+  if (needle.empty())
+    return result;
+
+  sync();
+
+  struct Range {
+    std::string file;
+    uint64_t offset;
+    uint64_t length; // UINT64_MAX: to the end of the file
+    uint64_t firstLine;
+  };
+  std::vector<Range> ranges;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<uint32_t> candidates;
+    if (needle.size() >= 3) {
+      std::vector<const std::vector<uint32_t> *> lists;
+      for (size_t i = 0; i + 2 < needle.size(); ++i) {
+        auto it = postings_.find(
+            trigram(reinterpret_cast<const unsigned char *>(needle.data()) +
+                    i));
+        if (it == postings_.end()) {
+          lists.clear();
+          break;
+        }
+        lists.push_back(&it->second);
+      }
+      if (!lists.empty()) {
+        std::sort(lists.begin(), lists.end(),
+                  [](auto *a, auto *b) { return a->size() < b->size(); });
+        candidates = *lists.front();
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+          std::vector<uint32_t> next;
+          std::set_intersection(candidates.begin(), candidates.end(),
+                                lists[i]->begin(), lists[i]->end(),
+                                std::back_inserter(next));
+          candidates.swap(next);
+        }
+      }
+    } else {
+      for (uint32_t i = 0; i < blocks_.size(); ++i)
+        candidates.push_back(i);
+    }
+
+    for (uint32_t id : candidates) {
+      if (deadBlocks_[id])
+        continue;
+      const Block &b = blocks_[id];
+      ranges.push_back({files_[b.file].name, b.offset, b.length, b.firstLine});
+    }
+    // Whatever is past the index is always scanned
+    for (const auto &file : files_) {
+      if (file.alive)
+        ranges.push_back(
+            {file.name, file.indexedBytes, UINT64_MAX, file.lines});
+    }
+  }
+
+  // Newest logs first (names carry their timestamp), then file order
+  std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) {
+    if (a.file != b.file)
+      return a.file > b.file;
+    return a.offset < b.offset;
+  });
+
+  fs::path logsDir = PathManager::instance().logs();
+  std::string openName;
+  int fd = -1;
+  std::string buf, lowered;
+
+  for (const auto &range : ranges) {
+    if (result.hits.size() >= maxHits) {
+      result.truncated = true;
+      break;
+    }
+    if (range.file != openName) {
+      if (fd >= 0)
+        ::close(fd);
+      openName = range.file;
+      fs::path data = LogRetention::readablePath(logsDir / range.file);
+      fd = data.empty() ? -1 : ::open(data.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0)
+      continue;
+
+    uint64_t length = range.length;
+    if (length == UINT64_MAX) {
+      struct stat st;
+      if (::fstat(fd, &st) != 0 || (uint64_t)st.st_size <= range.offset)
+        continue;
+      length = st.st_size - range.offset;
+    }
+    buf.resize(length);
+    if (!readAt(fd, range.offset, length, buf.data()))
+      continue;
+    result.blocksRead++;
+
+    lowered.resize(buf.size());
+    std::transform(buf.begin(), buf.end(), lowered.begin(),
+                   [](unsigned char c) { return (char)lower(c); });
+
+    size_t cursor = 0;
+    size_t countedTo = 0;
+    uint64_t lineNo = range.firstLine;
+    while (result.hits.size() < maxHits) {
+      const void *m = memmem(lowered.data() + cursor, lowered.size() - cursor,
+                             needle.data(), needle.size());
+      if (!m)
+        break;
+      size_t at = static_cast<const char *>(m) - lowered.data();
+      size_t lineStart = lowered.rfind('\n', at);
+      lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+      size_t lineEnd = lowered.find('\n', at);
+      if (lineEnd == std::string::npos)
+        lineEnd = lowered.size();
+
+      lineNo += std::count(buf.begin() + countedTo, buf.begin() + lineStart,
+                           '\n');
+      countedTo = lineStart;
+      cursor = lineEnd;
+
+      Hit hit;
+      hit.file = range.file;
+      hit.line = lineNo + 1;
+      hit.text = buf.substr(lineStart, lineEnd - lineStart);
+      if (!hit.text.empty() && hit.text.back() == '\r')
+        hit.text.pop_back();
+      hit.level = LogIndex::classify(hit.text.data(), hit.text.size());
+      hit.timestamp = timestampOf(hit.text);
+
+      result.levelCounts[hit.level]++;
+      if (!(hit.level & levelMask))
+        continue;
+      result.fileCounts[hit.file]++;
+      result.hits.push_back(std::move(hit));
+    }
+  }
+  if (fd >= 0)
+    ::close(fd);
+
+  result.millis = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - started)
+                      .count();
+  LOG_DEBUG("Log search for '" + query + "': " +
+            std::to_string(result.hits.size()) + " hits, " +
+            std::to_string(result.blocksRead) + " blocks read");
+  return result;
+}
+
+} // namespace rsjfw
@@ -1,63 +1,245 @@
 #include "rsjfw/logger.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 
 namespace rsjfw {
 
+namespace {
+
+// Batches are written once they reach this size even if more is queued
+constexpr size_t MAX_BATCH = 256 * 1024;
+
+// Set on the writer thread, which must never wait for itself
+thread_local bool onWriter = false;
+
+} // namespace
+
 Logger& Logger::instance() {
     static Logger instance;
     return instance;
 }
 
-void Logger::init(const std::filesystem::path& logPath, bool verbose) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void Logger::configure(bool verbose) {
     verbose_ = verbose;
+    setLevel(verbose ? LogLevel::DEBUG : LogLevel::INFO);
+    if (const char* env = std::getenv("RSJFW_LOG_LEVEL")) {
+        std::string lvl = env;
+        if (lvl == "debug") setLevel(LogLevel::DEBUG);
+        else if (lvl == "info") setLevel(LogLevel::INFO);
+        else if (lvl == "warn") setLevel(LogLevel::WARNING);
+        else if (lvl == "error") setLevel(LogLevel::ERROR);
+    }
+}
+
+void Logger::init(const std::filesystem::path& logPath, bool verbose) {
+    if (running_) return;
 
+    configure(verbose);
     if (logPath.has_parent_path()) {
         std::filesystem::create_directories(logPath.parent_path());
     }
 
-    logFile_.open(logPath, std::ios::out | std::ios::app);
-    if (!logFile_.is_open()) {
+    logPath_ = logPath;
+    if (!file_.open(logPath, true)) {
         std::cerr << "[ERROR] Failed to open log file: " << logPath << std::endl;
-    } else {
-        logFile_ << "\n=== RSJFW Session Started: " << getTimestamp() << " ===\n";
+        return;
+    }
+
+    std::string banner = std::string("\n=== RSJFW Session Started: ") + getTimestamp() + " ===\n";
+    file_.write(banner.data(), banner.size());
+
+    ring_ = std::make_unique<Slot[]>(RING_SIZE);
+    for (size_t i = 0; i < RING_SIZE; ++i) {
+        ring_[i].seq.store(i, std::memory_order_relaxed);
     }
+
+    running_ = true;
+    writer_ = std::jthread([this](std::stop_token stop) { writerLoop(stop); });
 }
 
 Logger::~Logger() {
-    if (logFile_.is_open()) {
-        logFile_.close();
+    // Late log calls fall back to the console; the writer drains the rest
+    running_ = false;
+    if (writer_.joinable()) {
+        writer_.request_stop();
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wakeCv_.notify_one();
+        }
+        writer_.join();
     }
+    file_.close();
 }
 
-void Logger::log(LogLevel level, const std::string& message) {
+void Logger::setWriteListener(WriteListener listener) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::string timestamp = getTimestamp();
-    std::string levelStr = getLevelString(level);
-    std::string formattedMsg = "[" + timestamp + "] [" + levelStr + "] " + message;
+    listener_ = std::move(listener);
+}
 
-    if (logFile_.is_open()) {
-        logFile_ << formattedMsg << std::endl;
+// Vyukov's bounded queue: a slot is free for position p when seq == p and
+// holds data for the reader when seq == p + 1.
+bool Logger::tryPush(LogLevel level, std::string& text) {
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &ring_[pos & (RING_SIZE - 1)];
+        uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // Full
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
     }
+    slot->level = level;
+    slot->text = std::move(text);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
 
-    if (verbose_ || level == LogLevel::WARNING || level == LogLevel::ERROR) {
-        if (level == LogLevel::ERROR) {
-            std::cerr << formattedMsg << std::endl;
-        } else {
-            std::cout << formattedMsg << std::endl;
+bool Logger::tryPop(LogLevel& level, std::string& text) {
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot = &ring_[pos & (RING_SIZE - 1)];
+    if (slot->seq.load(std::memory_order_acquire) != pos + 1) return false;
+
+    level = slot->level;
+    text = std::move(slot->text);
+    slot->seq.store(pos + RING_SIZE, std::memory_order_release);
+    tail_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void Logger::log(LogLevel level, const std::string& message) {
+    if (!enabled(level)) return;
+
+    const char* levelStr = getLevelString(level);
+    std::string record;
+    record.reserve(message.size() + 32);
+    record += '[';
+    record += getTimestamp();
+    record += "] [";
+    record += levelStr;
+    record += "] ";
+    record += message;
+
+    if (!running_) {
+        // Before init (or without a log file) there is only the console
+        echo(level, record);
+        return;
+    }
+
+    while (!tryPush(level, record)) {
+        if (onWriter) {
+            // Logged from the write listener with the ring full: nobody else
+            // would drain it, so the writer writes the line itself
+            echo(level, record);
+            record += '\n';
+            file_.write(record.data(), record.size());
+            return;
+        }
+        // Ring full: let the writer catch up rather than drop the line
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wakeCv_.notify_one();
         }
+        std::this_thread::yield();
+    }
+    pushed_.fetch_add(1);
+
+    if (writerIdle_.load()) {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wakeCv_.notify_one();
+    }
+}
+
+void Logger::flush() {
+    if (!running_) return;
+    uint64_t target = pushed_.load();
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    wakeCv_.notify_one();
+    flushedCv_.wait_for(lock, std::chrono::seconds(2), [&] { return written_.load() >= target; });
+}
+
+void Logger::echo(LogLevel level, const std::string& line) {
+    if (!verbose_ && level != LogLevel::WARNING && level != LogLevel::ERROR) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (level == LogLevel::ERROR) {
+        std::cerr << line << '\n';
+    } else {
+        std::cout << line << '\n';
     }
 }
 
-std::string Logger::getTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
+void Logger::writerLoop(std::stop_token stop) {
+    onWriter = true;
+    std::string batch;
+    batch.reserve(MAX_BATCH);
+    LogLevel level;
+    std::string text;
+
+    for (;;) {
+        uint64_t count = 0;
+        while (batch.size() < MAX_BATCH && tryPop(level, text)) {
+            batch += text;
+            batch += '\n';
+            echo(level, text);
+            count++;
+        }
+
+        if (count > 0) {
+            if (!file_.write(batch.data(), batch.size())) {
+                std::cerr << "[ERROR] Failed to write log file: " << std::strerror(errno) << std::endl;
+            }
+            batch.clear();
+
+            WriteListener listener;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                listener = listener_;
+            }
+            if (listener) listener(logPath_, file_.size());
+
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                written_.fetch_add(count);
+            }
+            flushedCv_.notify_all();
+            continue;
+        }
+
+        // Ring is drained; only now is it safe to stop
+        if (stop.stop_requested()) break;
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        writerIdle_ = true;
+        wakeCv_.wait_for(lock, std::chrono::milliseconds(100), [&] {
+            return head_.load() != tail_.load(std::memory_order_relaxed) || stop.stop_requested();
+        });
+        writerIdle_ = false;
+    }
+}
+
+// Formatting the date is only done when the second changes
+const char* Logger::getTimestamp() {
+    thread_local time_t cachedSecond = -1;
+    thread_local char cached[32];
+
+    time_t now = std::time(nullptr);
+    if (now != cachedSecond) {
+        struct tm tm;
+        localtime_r(&now, &tm);
+        std::strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", &tm);
+        cachedSecond = now;
+    }
+    return cached;
 }
 
-std::string Logger::getLevelString(LogLevel level) {
+const char* Logger::getLevelString(LogLevel level) {
     switch (level) {
         case LogLevel::DEBUG:   return "DEBUG";
         case LogLevel::INFO:    return "INFO";
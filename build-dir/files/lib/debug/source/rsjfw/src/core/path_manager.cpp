@@ -14,18 +14,32 @@ PathManager& PathManager::instance() {
     return instance;
 }
 
-void PathManager::init(const std::string& rootOverride) {
+void PathManager::resolve(const std::string& rootOverride) {
     rootDir_ = resolveRoot(rootOverride);
-    
+
     versionsDir_ = rootDir_ / "versions";
     prefixDir_ = rootDir_ / "prefix";
     logsDir_ = rootDir_ / "logs";
     downloadsDir_ = rootDir_ / "downloads";
     wineDir_ = rootDir_ / "wine";
     dxvkDir_ = rootDir_ / "dxvk";
+    cacheDir_ = rootDir_ / "cache";
+    trashDir_ = rootDir_ / "trash";
     inboxDir_ = rootDir_ / "inbox";
     lockFilePath_ = rootDir_ / "rsjfw.lock";
 
+    // Generate path for current session log
+    auto now = std::chrono::system_clock::now();
+    auto in_time_t = std::chrono::system_clock::to_time_t(now);
+    std::stringstream ss;
+    ss << "rsjfw_" << std::put_time(std::localtime(&in_time_t), "%Y%m%d_%H%M%S") << ".log";
+    currentLogPath_ = logsDir_ / ss.str();
+}
+
+void PathManager::init(const std::string& rootOverride) {
+    // A fast-path start that fell through keeps its session log
+    if (rootDir_.empty() || !rootOverride.empty()) resolve(rootOverride);
+
     std::filesystem::create_directories(rootDir_);
     std::filesystem::create_directories(versionsDir_);
     std::filesystem::create_directories(prefixDir_);
@@ -80,13 +94,6 @@ void PathManager::init(const std::string& rootOverride) {
             // Ignore if rename fails (permissions etc)
         }
     }
-
-    // Generate path for current session log
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << "rsjfw_" << std::put_time(std::localtime(&in_time_t), "%Y%m%d_%H%M%S") << ".log";
-    currentLogPath_ = logsDir_ / ss.str();
 }
 
 std::filesystem::path PathManager::resolveRoot(const std::string& override) {
@@ -121,6 +128,15 @@ std::filesystem::path PathManager::layerLib() const {
     return userPath;
 }
 
+std::filesystem::path PathManager::helperExe() const {
+    // Same places as the layer: package install, then the user data dir
+    for (const std::filesystem::path& candidate :
+         {std::filesystem::path("/usr/lib/rsjfw/rsjfw-helper.exe"), rootDir_ / "lib" / "rsjfw-helper.exe"}) {
+        if (std::filesystem::exists(candidate)) return candidate;
+    }
+    return {};
+}
+
 std::filesystem::path PathManager::rsjfwExe() const {
     try {
         return std::filesystem::canonical("/proc/self/exe");
@@ -0,0 +1,388 @@
+#include "rsjfw/performance.hpp"
+#include "rsjfw/config.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/process.hpp"
+#include "rsjfw/wine.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <sched.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+#ifndef SYS_futex_waitv
+#define SYS_futex_waitv 449
+#endif
+
+namespace rsjfw {
+
+namespace {
+
+// linux/ioprio.h is not shipped by every libc
+constexpr int IOPRIO_CLASS_BE = 2;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+constexpr int IOPRIO_WHO_PROCESS = 1;
+
+bool hasFutexWaitv() {
+  // With no waiters the syscall fails with EINVAL if it exists at all
+  long rc = syscall(SYS_futex_waitv, nullptr, 0, 0, nullptr, 0);
+  return rc == -1 && errno != ENOSYS;
+}
+
+std::string findLibrary(const std::string &name) {
+  const char *dirs[] = {"/usr/lib/x86_64-linux-gnu", "/usr/lib64", "/usr/lib",
+                        "/usr/local/lib", "/app/lib"};
+  for (const char *dir : dirs) {
+    fs::path p = fs::path(dir) / name;
+    if (::access(p.c_str(), R_OK) == 0)
+      return p.string();
+  }
+  return "";
+}
+
+// The unix side of ntdll carries the environment switches the build
+// understands; Proton builds may only mention them in the proton script
+std::vector<fs::path> syncProbeFiles(const fs::path &root) {
+  std::vector<fs::path> files;
+  const char *candidates[] = {"files/lib/wine/x86_64-unix/ntdll.so",
+                              "files/lib64/wine/x86_64-unix/ntdll.so",
+                              "lib/wine/x86_64-unix/ntdll.so",
+                              "lib64/wine/x86_64-unix/ntdll.so",
+                              "dist/lib/wine/x86_64-unix/ntdll.so",
+                              "proton"};
+  std::error_code ec;
+  for (const char *c : candidates) {
+    if (fs::is_regular_file(root / c, ec))
+      files.push_back(root / c);
+  }
+  return files;
+}
+
+std::string probeKey(const std::vector<fs::path> &files) {
+  std::string key;
+  std::error_code ec;
+  for (const auto &f : files) {
+    auto t = fs::last_write_time(f, ec).time_since_epoch().count();
+    key += f.string() + ":" + std::to_string(fs::file_size(f, ec)) + ":" +
+           std::to_string(t) + ";";
+  }
+  return key;
+}
+
+} // namespace
+
+Performance &Performance::instance() {
+  static Performance instance;
+  return instance;
+}
+
+const Performance::Capabilities &Performance::capabilities() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (caps_)
+    return *caps_;
+
+  Capabilities caps;
+  caps.ntsync = ::access("/dev/ntsync", R_OK | W_OK) == 0;
+  caps.fsync = hasFutexWaitv();
+  caps.gamemodeLib = findLibrary("libgamemodeauto.so.0");
+  caps.cpuCount = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+
+  struct utsname u;
+  if (uname(&u) == 0)
+    caps.kernel = u.release;
+
+  LOG_INFO("Performance capabilities: ntsync=" +
+           std::string(caps.ntsync ? "yes" : "no") +
+           " fsync=" + (caps.fsync ? "yes" : "no") +
+           " gamemode=" + (caps.gamemodeLib.empty() ? "no" : "yes") +
+           " cpus=" + std::to_string(caps.cpuCount) + " kernel=" + caps.kernel);
+
+  caps_ = caps;
+  return *caps_;
+}
+
+std::optional<std::vector<int>>
+Performance::parseCpuList(const std::string &spec) {
+  std::vector<int> cpus;
+  std::stringstream ss(spec);
+  std::string part;
+  while (std::getline(ss, part, ',')) {
+    part.erase(std::remove(part.begin(), part.end(), ' '), part.end());
+    if (part.empty())
+      continue;
+    try {
+      size_t dash = part.find('-');
+      if (dash == std::string::npos) {
+        cpus.push_back(std::stoi(part));
+      } else {
+        int lo = std::stoi(part.substr(0, dash));
+        int hi = std::stoi(part.substr(dash + 1));
+        if (lo > hi || lo < 0)
+          return std::nullopt;
+        for (int c = lo; c <= hi; ++c)
+          cpus.push_back(c);
+      }
+    } catch (...) {
+      return std::nullopt;
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+Performance::SyncSupport
+Performance::wineSyncSupport(const std::string &wineRoot,
+                             const std::string &prefixDir) {
+  SyncSupport support;
+  auto files = syncProbeFiles(wineRoot);
+  if (wineRoot.empty() || files.empty()) {
+    // System Wine or an unknown layout: unsupported switches are ignored by
+    // Wine, so let the kernel decide
+    support.ntsync = support.fsync = support.esync = true;
+    return support;
+  }
+
+  std::string key = probeKey(files);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = syncCache_.find(key);
+    if (it != syncCache_.end())
+      return it->second;
+  }
+
+  fs::path record =
+      prefixDir.empty() ? fs::path() : fs::path(prefixDir) / ".rsjfw_sync.json";
+  nlohmann::json j;
+  if (!record.empty()) {
+    std::ifstream f(record);
+    if (f.is_open()) {
+      try {
+        f >> j;
+      } catch (...) {
+        j = nlohmann::json::object();
+      }
+    }
+  }
+
+  if (j.is_object() && j.value("probe", "") == key) {
+    support.ntsync = j.value("ntsync", false);
+    support.fsync = j.value("fsync", false);
+    support.esync = j.value("esync", false);
+  } else {
+    for (const auto &file : files) {
+      std::ifstream in(file, std::ios::binary);
+      std::string data((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+      if (data.find("/dev/ntsync") != std::string::npos ||
+          data.find("WINENTSYNC") != std::string::npos ||
+          data.find("PROTON_USE_NTSYNC") != std::string::npos)
+        support.ntsync = true;
+      if (data.find("WINEFSYNC") != std::string::npos)
+        support.fsync = true;
+      if (data.find("WINEESYNC") != std::string::npos)
+        support.esync = true;
+    }
+
+    if (!record.empty()) {
+      j = nlohmann::json::object();
+      j["probe"] = key;
+      j["wine_root"] = wineRoot;
+      j["ntsync"] = support.ntsync;
+      j["fsync"] = support.fsync;
+      j["esync"] = support.esync;
+      std::ofstream out(record, std::ios::trunc);
+      if (out.is_open())
+        out << j.dump(4);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  syncCache_[key] = support;
+  return support;
+}
+
+std::string Performance::selectSync(const std::string &wineRoot,
+                                    const std::string &prefixDir,
+                                    std::string *reason) {
+  std::string mode = Config::instance().snapshot()->performance.syncMode;
+  const auto &caps = capabilities();
+  SyncSupport build = wineSyncSupport(wineRoot, prefixDir);
+
+  auto flags = [](bool n, bool f, bool e) {
+    std::string s;
+    if (n)
+      s += "ntsync,";
+    if (f)
+      s += "fsync,";
+    if (e)
+      s += "esync,";
+    if (!s.empty())
+      s.pop_back();
+    return s.empty() ? std::string("none") : s;
+  };
+  std::string detail = "kernel: " + flags(caps.ntsync, caps.fsync, true) +
+                       "; build: " +
+                       flags(build.ntsync, build.fsync, build.esync);
+
+  std::string chosen;
+  if (mode == "auto" || mode.empty()) {
+    if (caps.ntsync && build.ntsync)
+      chosen = "ntsync";
+    else if (caps.fsync && build.fsync)
+      chosen = "fsync";
+    else if (build.esync)
+      chosen = "esync";
+    else
+      chosen = "none";
+    detail = "auto; " + detail;
+  } else {
+    chosen = mode;
+    bool supported = (mode == "ntsync" && caps.ntsync && build.ntsync) ||
+                     (mode == "fsync" && caps.fsync && build.fsync) ||
+                     (mode == "esync" && build.esync) || mode == "none";
+    if (!supported)
+      LOG_WARN("Sync primitive " + mode +
+               " forced but not supported here (" + detail + ")");
+    detail = "forced; " + detail;
+  }
+
+  if (reason)
+    *reason = detail;
+  return chosen;
+}
+
+void Performance::configureEnvironment(wine::Prefix &pfx, bool isProton) {
+  auto config = Config::instance().snapshot();
+  const auto &perf = config->performance;
+  const auto &caps = capabilities();
+
+  std::string reason;
+  std::string sync = selectSync(pfx.root(), pfx.dir(), &reason);
+
+  // Explicitly switch off the primitives that were not chosen, since Proton
+  // enables fsync on its own
+  bool ntsync = sync == "ntsync";
+  bool fsync = sync == "fsync";
+  bool esync = sync != "none";
+  pfx.appendEnv("WINENTSYNC", ntsync ? "1" : "0");
+  pfx.appendEnv("WINEFSYNC", fsync ? "1" : "0");
+  pfx.appendEnv("WINEESYNC", esync ? "1" : "0");
+  if (isProton) {
+    if (ntsync)
+      pfx.appendEnv("PROTON_USE_NTSYNC", "1");
+    if (!fsync)
+      pfx.appendEnv("PROTON_NO_FSYNC", "1");
+    if (!esync)
+      pfx.appendEnv("PROTON_NO_ESYNC", "1");
+  }
+
+  // Recorded in the session log so runs can be compared per primitive
+  LOG_INFO("Sync primitive: " + sync + " (" + reason + ") for prefix " +
+           pfx.dir());
+
+  if (perf.gamemode) {
+    if (caps.gamemodeLib.empty()) {
+      LOG_WARN("Gamemode enabled but libgamemodeauto.so.0 was not found");
+    } else {
+      // Same mechanism as gamemoderun: the preloaded client registers the
+      // game with the daemon (or the portal inside Flatpak)
+      std::string preload = pfx.getEnv("LD_PRELOAD");
+      pfx.appendEnv("LD_PRELOAD", preload.empty()
+                                      ? "libgamemodeauto.so.0"
+                                      : "libgamemodeauto.so.0:" + preload);
+    }
+  }
+
+  std::vector<int> cpus;
+  if (!perf.studioCpus.empty()) {
+    auto parsed = parseCpuList(perf.studioCpus);
+    if (!parsed) {
+      LOG_WARN("Ignoring invalid CPU list: " + perf.studioCpus);
+    } else {
+      cpus = *parsed;
+    }
+  }
+
+  // Keep Studio off the wineserver's core so they stop contending
+  if (perf.wineserverCpu >= 0 && perf.wineserverCpu < caps.cpuCount) {
+    if (cpus.empty()) {
+      for (int c = 0; c < caps.cpuCount; ++c)
+        cpus.push_back(c);
+    }
+    std::vector<int> rest;
+    for (int c : cpus)
+      if (c != perf.wineserverCpu)
+        rest.push_back(c);
+    if (!rest.empty())
+      cpus = rest;
+  }
+
+  cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                            [&](int c) { return c >= caps.cpuCount; }),
+             cpus.end());
+  pfx.setCpuAffinity(cpus);
+}
+
+void Performance::pinWineserver(const std::string &prefixDir,
+                                std::stop_token stop, int timeoutMs) {
+  int cpu = Config::instance().snapshot()->performance.wineserverCpu;
+  if (cpu < 0 || cpu >= capabilities().cpuCount)
+    return;
+
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (stop.stop_requested())
+      return;
+    for (const auto &proc : Process::findByName("wineserver")) {
+      std::error_code ec;
+      if (proc.winePrefix.empty() ||
+          !fs::equivalent(proc.winePrefix, prefixDir, ec))
+        continue;
+
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      if (sched_setaffinity(proc.pid, sizeof(set), &set) == 0) {
+        LOG_INFO("Pinned wineserver (pid " + std::to_string(proc.pid) +
+                 ") to CPU " + std::to_string(cpu));
+      } else {
+        LOG_WARN("Failed to pin wineserver: " + std::string(strerror(errno)));
+      }
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  }
+  LOG_WARN("wineserver did not appear, not pinned");
+}
+
+void Performance::enterBackgroundPriority() {
+  if (Config::instance().snapshot()->performance.lowPriorityBackground)
+    setBackgroundPriority(true);
+}
+
+void Performance::setBackgroundPriority(bool low) {
+  pid_t tid = (pid_t)syscall(SYS_gettid);
+  if (setpriority(PRIO_PROCESS, tid, low ? 10 : 0) == -1)
+    LOG_DEBUG("Could not change thread priority: " +
+              std::string(strerror(errno)));
+  // Best effort at level 4 is what threads start with
+  syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid,
+          low ? IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT
+              : (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 4);
+}
+
+} // namespace rsjfw
@@ -1,4 +1,5 @@
 #include "rsjfw/registry.hpp"
+#include "rsjfw/wine_helper.hpp"
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
@@ -7,10 +8,15 @@
 
 namespace rsjfw {
 
-Registry::Registry(rsjfw::wine::Prefix &pfx) : pfx_(pfx) {}
+Registry::Registry(rsjfw::wine::Prefix &pfx)
+    : pfx_(pfx), helper_(std::make_unique<wine::HelperSession>(pfx)) {}
+
+Registry::~Registry() = default;
 
 bool Registry::add(const std::string &key, const std::string &valueName,
                    const std::string &value) {
+  if (helper_->regWrite(key, valueName, "REG_SZ", value))
+    return true;
   return pfx_.registryAdd(key, valueName, value, "REG_SZ");
 }
 
@@ -18,6 +24,8 @@ bool Registry::add(const std::string &key, const std::string &valueName,
                    unsigned int value) {
   std::stringstream ss;
   ss << value;
+  if (helper_->regWrite(key, valueName, "REG_DWORD", ss.str()))
+    return true;
   return pfx_.registryAdd(key, valueName, ss.str(), "REG_DWORD");
 }
 
@@ -28,10 +36,28 @@ bool Registry::addBinary(const std::string &key, const std::string &valueName,
   for (auto byte : data) {
     ss << std::setw(2) << static_cast<int>(byte);
   }
+  if (helper_->regWrite(key, valueName, "REG_BINARY", ss.str()))
+    return true;
   return pfx_.registryAdd(key, valueName, ss.str(), "REG_BINARY");
 }
 
+bool Registry::apply(const std::vector<wine::Prefix::RegistryEntry> &entries) {
+  if (helper_->available()) {
+    bool ok = true;
+    for (const auto &entry : entries)
+      ok &= helper_->regWrite(entry.key, entry.valueName, entry.type,
+                              entry.value);
+    if (ok)
+      return true;
+  }
+  // Writes are idempotent, so a partial helper run is simply redone
+  return pfx_.registryApply(entries);
+}
+
 bool Registry::exists(const std::string &key, const std::string &valueName) {
+  if (auto found = helper_->regExists(key, valueName))
+    return *found;
+
   std::vector<std::string> args = {"query", key, "/v", valueName};
   bool found = false;
 
@@ -43,6 +69,14 @@ bool Registry::exists(const std::string &key, const std::string &valueName) {
 
 std::string Registry::readString(const std::string &key,
                                  const std::string &valueName) {
+  auto value = helper_->regRead(key, valueName);
+  if (value)
+    return value->type == "REG_SZ" || value->type == "REG_EXPAND_SZ"
+               ? value->data
+               : "";
+  if (!helper_->failed())
+    return ""; // Not there
+
   std::vector<std::string> args = {"query", key, "/v", valueName};
   std::string result = "";
 
@@ -69,6 +103,25 @@ std::string Registry::readString(const std::string &key,
 
 std::vector<unsigned char> Registry::readBinary(const std::string &key,
                                                 const std::string &valueName) {
+  std::string hexStr = "";
+  if (auto value = helper_->regRead(key, valueName)) {
+    if (value->type == "REG_BINARY")
+      hexStr = value->data;
+  } else if (helper_->failed()) {
+    hexStr = queryBinary(key, valueName);
+  }
+  if (hexStr.empty())
+    return {};
+
+  std::vector<unsigned char> data;
+  for (size_t i = 0; i + 1 < hexStr.length(); i += 2)
+    data.push_back(
+        (unsigned char)strtol(hexStr.substr(i, 2).c_str(), NULL, 16));
+  return data;
+}
+
+std::string Registry::queryBinary(const std::string &key,
+                                  const std::string &valueName) {
   std::vector<std::string> args = {"query", key, "/v", valueName};
   std::string result = "";
 
@@ -91,23 +144,7 @@ std::vector<unsigned char> Registry::readBinary(const std::string &key,
       }
     }
   }
-
-  if (hexStr.empty())
-    return {};
-
-  std::vector<unsigned char> data;
-  for (size_t i = 0; i < hexStr.length(); i += 2) {
-    if (i + 1 < hexStr.length()) {
-      std::string byteString = hexStr.substr(i, 2);
-      try {
-        unsigned char byte =
-            (unsigned char)strtol(byteString.c_str(), NULL, 16);
-        data.push_back(byte);
-      } catch (...) {
-      }
-    }
-  }
-  return data;
+  return hexStr;
 }
 
 } // namespace rsjfw
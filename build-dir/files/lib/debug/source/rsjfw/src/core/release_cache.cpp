@@ -0,0 +1,316 @@
+#include "rsjfw/release_cache.hpp"
+#include "rsjfw/http.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+namespace rsjfw {
+
+namespace {
+
+// Within this long of the last check the cached list is used as is
+constexpr auto FRESH_FOR = std::chrono::minutes(10);
+constexpr int PER_PAGE = 50;
+
+// The URL tagged rel="next" in a Link header, or empty
+std::string nextLink(const std::string &link) {
+  size_t pos = 0;
+  while (pos < link.size()) {
+    size_t end = link.find(',', pos);
+    if (end == std::string::npos)
+      end = link.size();
+    std::string part = link.substr(pos, end - pos);
+    size_t open = part.find('<');
+    size_t close = part.find('>');
+    if (open != std::string::npos && close != std::string::npos &&
+        close > open && part.find("rel=\"next\"") != std::string::npos)
+      return part.substr(open + 1, close - open - 1);
+    pos = end + 1;
+  }
+  return {};
+}
+
+std::vector<Downloader::GitHubRelease> parseReleases(const std::string &body) {
+  std::vector<Downloader::GitHubRelease> releases;
+  auto j = nlohmann::json::parse(body);
+  if (!j.is_array())
+    return releases;
+  for (const auto &rel : j) {
+    Downloader::GitHubRelease release;
+    release.tag = rel.value("tag_name", "");
+    release.isNative = false;
+    if (release.tag.empty())
+      continue;
+    if (rel.contains("assets") && rel["assets"].is_array()) {
+      for (const auto &asset : rel["assets"]) {
+        Downloader::GitHubAsset ga;
+        ga.name = asset.value("name", "");
+        ga.url = asset.value("browser_download_url", "");
+        ga.size = asset.value("size", (size_t)0);
+        release.assets.push_back(ga);
+      }
+    }
+    releases.push_back(release);
+  }
+  return releases;
+}
+
+nlohmann::json toJson(const Downloader::GitHubRelease &release) {
+  nlohmann::json assets = nlohmann::json::array();
+  for (const auto &a : release.assets)
+    assets.push_back({{"name", a.name}, {"url", a.url}, {"size", a.size}});
+  return {{"tag", release.tag}, {"assets", assets}};
+}
+
+Downloader::GitHubRelease fromJson(const nlohmann::json &j) {
+  Downloader::GitHubRelease release;
+  release.tag = j.value("tag", "");
+  release.isNative = false;
+  for (const auto &a : j.value("assets", nlohmann::json::array())) {
+    Downloader::GitHubAsset ga;
+    ga.name = a.value("name", "");
+    ga.url = a.value("url", "");
+    ga.size = a.value("size", (size_t)0);
+    release.assets.push_back(ga);
+  }
+  return release;
+}
+
+bool hasTag(const std::vector<Downloader::GitHubRelease> &releases,
+            const std::string &tag) {
+  return std::any_of(releases.begin(), releases.end(),
+                     [&](const auto &r) { return r.tag == tag; });
+}
+
+} // namespace
+
+ReleaseCache &ReleaseCache::instance() {
+  static ReleaseCache instance;
+  return instance;
+}
+
+fs::path ReleaseCache::pathFor(const std::string &repo) {
+  // '@' cannot appear in GitHub owner or repo names
+  std::string name = repo;
+  std::replace(name.begin(), name.end(), '/', '@');
+  return PathManager::instance().cache() / "releases" / (name + ".json");
+}
+
+std::shared_ptr<ReleaseCache::Entry>
+ReleaseCache::entry(const std::string &repo) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto &e = entries_[repo];
+  if (!e)
+    e = std::make_shared<Entry>();
+  return e;
+}
+
+void ReleaseCache::load(const std::string &repo, Entry &e) {
+  e.loaded = true;
+  try {
+    std::ifstream ifs(pathFor(repo));
+    if (!ifs.is_open())
+      return;
+    auto j = nlohmann::json::parse(ifs);
+    for (const auto &p : j.value("pages", nlohmann::json::array())) {
+      Page page;
+      page.url = p.value("url", "");
+      page.etag = p.value("etag", "");
+      for (const auto &r : p.value("releases", nlohmann::json::array()))
+        page.releases.push_back(fromJson(r));
+      e.pages.push_back(std::move(page));
+    }
+    e.next = j.value("next", "");
+    e.checked = std::chrono::system_clock::time_point(
+        std::chrono::seconds(j.value("checked", (int64_t)0)));
+  } catch (const std::exception &ex) {
+    LOG_WARN("Ignoring release cache for " + repo + ": " + ex.what());
+    e.pages.clear();
+    e.next.clear();
+  }
+}
+
+void ReleaseCache::save(const std::string &repo, const Entry &e) {
+  nlohmann::json pages = nlohmann::json::array();
+  for (const auto &page : e.pages) {
+    nlohmann::json releases = nlohmann::json::array();
+    for (const auto &r : page.releases)
+      releases.push_back(toJson(r));
+    pages.push_back(
+        {{"url", page.url}, {"etag", page.etag}, {"releases", releases}});
+  }
+  nlohmann::json j = {
+      {"pages", pages},
+      {"next", e.next},
+      {"checked", std::chrono::duration_cast<std::chrono::seconds>(
+                      e.checked.time_since_epoch())
+                      .count()}};
+
+  fs::path path = pathFor(repo);
+  fs::path tmp = path;
+  tmp += ".tmp";
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  {
+    std::ofstream ofs(tmp, std::ios::trunc);
+    ofs << j.dump();
+    if (!ofs) {
+      LOG_WARN("Failed to write release cache " + tmp.string());
+      return;
+    }
+  }
+  fs::rename(tmp, path, ec);
+  if (ec)
+    fs::remove(tmp, ec);
+}
+
+ReleaseCache::PageResult ReleaseCache::fetchPage(const std::string &url,
+                                                 Page &page,
+                                                 std::string &next) {
+  std::vector<std::string> headers = {"Accept: application/vnd.github+json",
+                                      "X-GitHub-Api-Version: 2022-11-28"};
+  if (const char *token = std::getenv("GITHUB_TOKEN"); token && *token)
+    headers.push_back(std::string("Authorization: Bearer ") + token);
+  if (!page.etag.empty())
+    headers.push_back("If-None-Match: " + page.etag);
+
+  HTTP::Response res;
+  try {
+    res = HTTP::request(url, headers);
+  } catch (const std::exception &e) {
+    LOG_WARN("GitHub request failed: " + std::string(e.what()));
+    return PageResult::FAILED;
+  }
+
+  if (res.status == 304)
+    return PageResult::NOT_MODIFIED;
+  if (res.status == 403 || res.status == 429) {
+    auto remaining = res.headers.find("x-ratelimit-remaining");
+    if (remaining != res.headers.end() && remaining->second == "0") {
+      LOG_WARN("GitHub rate limit reached (resets at " +
+               res.headers["x-ratelimit-reset"] +
+               "); set GITHUB_TOKEN for a higher limit");
+      return PageResult::FAILED;
+    }
+  }
+  if (res.status != 200) {
+    LOG_WARN("GitHub returned HTTP " + std::to_string(res.status) + " for " +
+             url);
+    return PageResult::FAILED;
+  }
+
+  std::vector<Release> releases;
+  try {
+    releases = parseReleases(res.body);
+  } catch (const std::exception &e) {
+    LOG_WARN("Unexpected GitHub response for " + url + ": " + e.what());
+    return PageResult::FAILED;
+  }
+  page.releases = std::move(releases);
+  page.url = url;
+  page.etag = res.headers["etag"];
+  next = nextLink(res.headers["link"]);
+  return PageResult::UPDATED;
+}
+
+bool ReleaseCache::revalidate(const std::string &repo, Entry &e) {
+  auto now = std::chrono::system_clock::now();
+  if (!e.pages.empty() && now - e.checked < FRESH_FOR)
+    return true;
+
+  Page first = e.pages.empty() ? Page{} : e.pages.front();
+  if (first.url.empty())
+    first.url = "https://api.github.com/repos/" + repo +
+                "/releases?per_page=" + std::to_string(PER_PAGE);
+
+  std::string next;
+  switch (fetchPage(first.url, first, next)) {
+  case PageResult::FAILED:
+    return false;
+  case PageResult::NOT_MODIFIED:
+    break;
+  case PageResult::UPDATED:
+    // Everything after the first page may have shifted; refetched on demand
+    LOG_DEBUG("Release list for " + repo + " changed");
+    e.pages = {std::move(first)};
+    e.next = next;
+    break;
+  }
+  e.checked = now;
+  save(repo, e);
+  return true;
+}
+
+std::vector<ReleaseCache::Release> ReleaseCache::flatten(const Entry &e) {
+  std::vector<Release> releases;
+  for (const auto &page : e.pages)
+    for (const auto &r : page.releases)
+      if (!hasTag(releases, r.tag))
+        releases.push_back(r);
+  return releases;
+}
+
+std::vector<ReleaseCache::Release>
+ReleaseCache::cached(const std::string &repo) {
+  auto e = entry(repo);
+  std::lock_guard<std::mutex> lock(e->mutex);
+  if (!e->loaded)
+    load(repo, *e);
+  return flatten(*e);
+}
+
+std::vector<ReleaseCache::Release>
+ReleaseCache::fetch(const std::string &repo, const std::string &wantTag) {
+  auto e = entry(repo);
+  std::lock_guard<std::mutex> lock(e->mutex);
+  if (!e->loaded)
+    load(repo, *e);
+  if (!revalidate(repo, *e) && e->pages.empty())
+    return {};
+
+  auto releases = flatten(*e);
+  while (!wantTag.empty() && !hasTag(releases, wantTag) && !e->next.empty()) {
+    Page page;
+    std::string next;
+    if (fetchPage(e->next, page, next) != PageResult::UPDATED)
+      break;
+    e->pages.push_back(std::move(page));
+    e->next = next;
+    save(repo, *e);
+    releases = flatten(*e);
+  }
+  return releases;
+}
+
+bool ReleaseCache::fetchMore(const std::string &repo) {
+  auto e = entry(repo);
+  std::lock_guard<std::mutex> lock(e->mutex);
+  if (!e->loaded)
+    load(repo, *e);
+  if (e->next.empty())
+    return false;
+
+  Page page;
+  std::string next;
+  if (fetchPage(e->next, page, next) != PageResult::UPDATED)
+    return true; // Still there, try again later
+  e->pages.push_back(std::move(page));
+  e->next = next;
+  save(repo, *e);
+  return !e->next.empty();
+}
+
+bool ReleaseCache::hasMore(const std::string &repo) {
+  auto e = entry(repo);
+  std::lock_guard<std::mutex> lock(e->mutex);
+  if (!e->loaded)
+    load(repo, *e);
+  return !e->next.empty();
+}
+
+} // namespace rsjfw
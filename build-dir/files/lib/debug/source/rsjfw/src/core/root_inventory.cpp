@@ -0,0 +1,267 @@
+#include "rsjfw/root_inventory.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/performance.hpp"
+#include "rsjfw/storage.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace rsjfw {
+
+namespace {
+
+constexpr const char *META_FILE = "rsjfw_meta.json";
+constexpr const char *SIZE_FILE = "rsjfw_size.json";
+// An install touches a root many times; rescan once it has gone quiet
+constexpr int SETTLE_MS = 1000;
+constexpr int POLL_MS = 500;
+
+constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                IN_MOVED_TO | IN_CLOSE_WRITE |
+                                IN_DELETE_SELF | IN_ONLYDIR;
+
+// Identifies the version of a root a stored size belongs to: the directory
+// is replaced on reinstall, and rsjfw_meta.json is written when an install
+// finishes, so a size taken mid-extraction never matches later.
+std::string stampOf(const fs::path &root) {
+  struct statx sx;
+  if (statx(AT_FDCWD, root.c_str(), 0, STATX_INO, &sx) != 0)
+    return {};
+  std::string stamp = std::to_string(sx.stx_dev_major) + ":" +
+                      std::to_string(sx.stx_dev_minor) + ":" +
+                      std::to_string(sx.stx_ino);
+  if (statx(AT_FDCWD, (root / META_FILE).c_str(), 0, STATX_MTIME, &sx) == 0)
+    stamp += ":" + std::to_string(sx.stx_mtime.tv_sec) + "." +
+             std::to_string(sx.stx_mtime.tv_nsec);
+  return stamp;
+}
+
+bool readStoredSize(const fs::path &root, const std::string &stamp,
+                    size_t &bytes) {
+  try {
+    std::ifstream ifs(root / SIZE_FILE);
+    if (!ifs.is_open())
+      return false;
+    auto j = nlohmann::json::parse(ifs);
+    if (j.value("stamp", "") != stamp)
+      return false;
+    bytes = j.value("bytes", (size_t)0);
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+void writeStoredSize(const fs::path &root, const std::string &stamp,
+                     size_t bytes) {
+  fs::path path = root / SIZE_FILE;
+  fs::path tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream ofs(tmp, std::ios::trunc);
+    if (!ofs.is_open())
+      return;
+    ofs << nlohmann::json{{"stamp", stamp}, {"bytes", bytes}}.dump(2);
+    if (!ofs)
+      return;
+  }
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec)
+    fs::remove(tmp, ec);
+}
+
+std::vector<Downloader::InstalledRoot> listRoots(const fs::path &dir,
+                                                 bool wine) {
+  std::vector<Downloader::InstalledRoot> roots;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(dir, ec)) {
+    if (!entry.is_directory(ec))
+      continue;
+    const fs::path &path = entry.path();
+    if (wine) {
+      if (!fs::exists(path / "bin/wine", ec) &&
+          !fs::exists(path / "files/bin/wine", ec))
+        continue;
+    } else {
+      if (!fs::exists(path / "x64", ec) && !fs::exists(path / "x86", ec))
+        continue;
+    }
+
+    Downloader::InstalledRoot ir;
+    ir.name = path.filename().string();
+    ir.path = path.string();
+    ir.isProton = wine && fs::exists(path / "proton", ec);
+
+    // Try to read metadata
+    try {
+      std::ifstream ifs(path / META_FILE);
+      if (ifs.is_open()) {
+        auto meta = nlohmann::json::parse(ifs);
+        ir.repo = meta.value("repo", "");
+        ir.version = meta.value("tag", "");
+        ir.asset = meta.value("asset", "");
+      }
+    } catch (...) {
+    }
+    roots.push_back(std::move(ir));
+  }
+  std::sort(roots.begin(), roots.end(),
+            [](const auto &a, const auto &b) { return a.name < b.name; });
+  return roots;
+}
+
+} // namespace
+
+RootInventory &RootInventory::instance() {
+  static RootInventory instance;
+  return instance;
+}
+
+RootInventory::RootInventory()
+    : current_(std::make_shared<const RootInventorySnapshot>()) {}
+
+RootInventory::~RootInventory() { stop(); }
+
+void RootInventory::start(std::function<void()> onChange) {
+  std::lock_guard<std::mutex> lock(startMutex_);
+  if (worker_.joinable())
+    return;
+  onChange_ = std::move(onChange);
+  inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd_ < 0)
+    LOG_WARN("inotify unavailable, installed builds will not refresh: " +
+             std::string(strerror(errno)));
+  worker_ = std::jthread([this](std::stop_token stop) { loop(stop); });
+}
+
+void RootInventory::stop() {
+  // Joined without the lock, publish() takes it
+  std::jthread worker;
+  {
+    std::lock_guard<std::mutex> lock(startMutex_);
+    worker = std::move(worker_);
+  }
+  if (worker.joinable()) {
+    worker.request_stop();
+    worker.join();
+  }
+  std::lock_guard<std::mutex> lock(startMutex_);
+  if (inotifyFd_ >= 0) {
+    ::close(inotifyFd_);
+    inotifyFd_ = -1;
+  }
+}
+
+void RootInventory::watch(const fs::path &dir) {
+  if (inotifyFd_ >= 0)
+    inotify_add_watch(inotifyFd_, dir.c_str(), WATCH_MASK);
+}
+
+void RootInventory::publish(RootInventorySnapshot next) {
+  current_.store(std::make_shared<const RootInventorySnapshot>(
+                     std::move(next)),
+                 std::memory_order_release);
+  std::function<void()> onChange;
+  {
+    std::lock_guard<std::mutex> lock(startMutex_);
+    onChange = onChange_;
+  }
+  if (onChange)
+    onChange();
+}
+
+void RootInventory::scan(std::stop_token stop) {
+  scanning_ = true;
+  auto &pm = PathManager::instance();
+  watch(pm.wine());
+  watch(pm.dxvk());
+
+  RootInventorySnapshot next;
+  next.ready = true;
+  next.wine = listRoots(pm.wine(), true);
+  next.dxvk = listRoots(pm.dxvk(), false);
+
+  // Roots that have not changed keep their stored size, so the listing can
+  // go out before anything is walked
+  struct Unsized {
+    std::vector<Downloader::InstalledRoot> *list;
+    size_t index;
+    std::string stamp;
+  };
+  std::vector<Unsized> unsized;
+  for (auto *list : {&next.wine, &next.dxvk}) {
+    for (size_t i = 0; i < list->size(); ++i) {
+      auto &root = (*list)[i];
+      watch(root.path);
+      std::string stamp = stampOf(root.path);
+      root.sizeKnown = readStoredSize(root.path, stamp, root.sizeBytes);
+      if (!root.sizeKnown && !stamp.empty())
+        unsized.push_back({list, i, std::move(stamp)});
+    }
+  }
+  publish(next);
+
+  for (const auto &item : unsized) {
+    auto &root = (*item.list)[item.index];
+    uint64_t bytes = Storage::treeSize(root.path, stop);
+    if (stop.stop_requested())
+      break;
+    root.sizeBytes = bytes;
+    root.sizeKnown = true;
+    writeStoredSize(root.path, item.stamp, bytes);
+    LOG_DEBUG("Sized " + root.path + ": " + std::to_string(bytes) + " bytes");
+    publish(next);
+  }
+  scanning_ = false;
+}
+
+void RootInventory::loop(std::stop_token stop) {
+  Performance::enterBackgroundPriority();
+
+  // Whether anything in the queue is more than our own rsjfw_size.json
+  auto drain = [this]() {
+    alignas(struct inotify_event) char buf[4096];
+    bool relevant = false;
+    for (;;) {
+      ssize_t n = ::read(inotifyFd_, buf, sizeof(buf));
+      if (n <= 0)
+        return relevant;
+      for (ssize_t off = 0; off < n;) {
+        auto *ev = reinterpret_cast<struct inotify_event *>(buf + off);
+        off += sizeof(struct inotify_event) + ev->len;
+        if (ev->mask & IN_IGNORED)
+          continue;
+        if (ev->len > 0 &&
+            std::strncmp(ev->name, SIZE_FILE, std::strlen(SIZE_FILE)) == 0)
+          continue;
+        relevant = true;
+      }
+    }
+  };
+
+  while (!stop.stop_requested()) {
+    if (dirty_.exchange(false))
+      scan(stop);
+
+    // A negative fd is ignored by poll(), which then just sleeps
+    struct pollfd pfd = {inotifyFd_, POLLIN, 0};
+    if (::poll(&pfd, 1, POLL_MS) <= 0 || !drain())
+      continue;
+    while (!stop.stop_requested() && ::poll(&pfd, 1, SETTLE_MS) > 0)
+      drain();
+    dirty_ = true;
+  }
+}
+
+} // namespace rsjfw
@@ -0,0 +1,545 @@
+#include "rsjfw/shader_cache.hpp"
+#include "rsjfw/config.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/wine.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <fcntl.h>
+#include <sys/utsname.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace rsjfw {
+
+namespace {
+
+std::string readTrimmed(const fs::path &path) {
+  std::ifstream f(path);
+  std::string s;
+  if (f.is_open())
+    std::getline(f, s);
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+    s.pop_back();
+  return s;
+}
+
+std::string sanitize(std::string s) {
+  for (auto &c : s) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-' &&
+        c != '_')
+      c = '_';
+  }
+  return s;
+}
+
+json readJson(const fs::path &path) {
+  std::ifstream f(path);
+  if (!f.is_open())
+    return json::object();
+  try {
+    json j;
+    f >> j;
+    return j;
+  } catch (...) {
+    return json::object();
+  }
+}
+
+void writeJson(const fs::path &path, const json &j) {
+  fs::path tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream f(tmp, std::ios::trunc);
+    if (!f.is_open())
+      return;
+    f << j.dump(4);
+  }
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+}
+
+// stats.json and the .warmed marker describe a cache, they are not part of it
+bool isBookkeeping(const fs::path &path) {
+  std::string name = path.filename().string();
+  return name == "stats.json" || name == ".warmed";
+}
+
+bool hasCacheFiles(const fs::path &dir) {
+  std::error_code ec;
+  for (auto it = fs::recursive_directory_iterator(dir, ec);
+       it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    if (ec)
+      break;
+    if (it->is_regular_file(ec) && !isBookkeeping(it->path()))
+      return true;
+  }
+  return false;
+}
+
+std::string shellQuote(const std::string &s) {
+  std::string out = "'";
+  for (char c : s) {
+    if (c == '\'')
+      out += "'\\''";
+    else
+      out += c;
+  }
+  return out + "'";
+}
+
+std::vector<fs::path> fozFiles(const fs::path &dir) {
+  std::vector<fs::path> files;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(dir, ec)) {
+    if (entry.path().extension() == ".foz" && entry.is_regular_file(ec))
+      files.push_back(entry.path());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// Hints the kernel to read the file in the background
+void readAhead(const fs::path &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  ::close(fd);
+}
+
+} // namespace
+
+ShaderCache &ShaderCache::instance() {
+  static ShaderCache instance;
+  return instance;
+}
+
+fs::path ShaderCache::base() const {
+  return PathManager::instance().cache() / "shaders";
+}
+
+std::string ShaderCache::gpuKey() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!gpuKey_.empty())
+    return gpuKey_;
+
+  std::vector<fs::path> cards;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator("/sys/class/drm", ec)) {
+    std::string name = entry.path().filename().string();
+    if (name.rfind("card", 0) == 0 && name.find('-') == std::string::npos &&
+        fs::exists(entry.path() / "device" / "vendor"))
+      cards.push_back(entry.path());
+  }
+  std::sort(cards.begin(), cards.end());
+
+  std::string key = "unknown";
+  if (!cards.empty()) {
+    int selected = Config::instance().snapshot()->general.selectedGpu;
+    const fs::path &card =
+        (selected >= 0 && selected < (int)cards.size()) ? cards[selected]
+                                                         : cards[0];
+    fs::path dev = card / "device";
+
+    std::string vendor = readTrimmed(dev / "vendor");
+    std::string device = readTrimmed(dev / "device");
+    if (vendor.rfind("0x", 0) == 0)
+      vendor = vendor.substr(2);
+    if (device.rfind("0x", 0) == 0)
+      device = device.substr(2);
+
+    std::string driver = "unknown";
+    fs::path driverLink = fs::read_symlink(dev / "driver", ec);
+    if (!ec)
+      driver = driverLink.filename().string();
+
+    // Out-of-tree drivers (nvidia) report their own version; in-tree ones
+    // change with the kernel.
+    std::string version = readTrimmed(fs::path("/sys/module") / driver / "version");
+    if (version.empty()) {
+      struct utsname u;
+      if (uname(&u) == 0)
+        version = u.release;
+    }
+
+    key = vendor + "-" + device + "-" + driver + "-" + version;
+  }
+
+  gpuKey_ = sanitize(key);
+  return gpuKey_;
+}
+
+fs::path ShaderCache::dirFor(const std::string &versionGUID) {
+  return base() / sanitize(versionGUID) / gpuKey();
+}
+
+void ShaderCache::configureEnvironment(wine::Prefix &pfx,
+                                       const std::string &versionGUID) {
+  if (versionGUID.empty())
+    return;
+
+  fs::path dir = dirFor(versionGUID);
+  fs::path driverDir = dir / "driver";
+  std::error_code ec;
+  fs::create_directories(driverDir, ec);
+  if (ec) {
+    LOG_WARN("Could not create shader cache dir " + dir.string() + ": " +
+             ec.message());
+    return;
+  }
+
+  pfx.appendEnv("DXVK_STATE_CACHE_PATH", dir.string());
+  pfx.appendEnv("DXVK_SHADER_CACHE_PATH", dir.string());
+  pfx.appendEnv("VKD3D_SHADER_CACHE_PATH", dir.string());
+
+  // Driver-level pipeline caches, kept next to the DXVK ones so they are
+  // pruned together and never evicted by the driver's own size limits
+  pfx.appendEnv("MESA_SHADER_CACHE_DIR", driverDir.string());
+  pfx.appendEnv("__GL_SHADER_DISK_CACHE", "1");
+  pfx.appendEnv("__GL_SHADER_DISK_CACHE_PATH", driverDir.string());
+  pfx.appendEnv("__GL_SHADER_DISK_CACHE_SKIP_CLEANUP", "1");
+
+  // Record pipelines with the Fossilize layer so later installs and driver
+  // updates can be warmed up by replaying them
+  if (Config::instance().snapshot()->general.shaderWarmup && warmupSupport().recorder) {
+    fs::path fozDir = dir / "fossilize";
+    fs::create_directories(fozDir, ec);
+    std::string layers = pfx.getEnv("VK_LOADER_LAYERS_ENABLE");
+    pfx.appendEnv("VK_LOADER_LAYERS_ENABLE",
+                  layers.empty() ? "VK_LAYER_fossilize"
+                                 : layers + ",VK_LAYER_fossilize");
+    pfx.appendEnv("FOSSILIZE_DUMP_PATH", (fozDir / "studio").string());
+  }
+
+  json s = readJson(dir / "stats.json");
+  s["sessions"] = s.value("sessions", 0) + 1;
+  writeJson(dir / "stats.json", s);
+
+  LOG_INFO("Shader cache: " + dir.string());
+}
+
+void ShaderCache::prewarm(const std::string &versionGUID) {
+  if (versionGUID.empty())
+    return;
+
+  fs::path target = dirFor(versionGUID);
+  std::string key = gpuKey();
+  std::error_code ec;
+
+  if (!fs::exists(target, ec) || !hasCacheFiles(target)) {
+    // Newest cache built for this GPU by another Studio version
+    fs::path source;
+    fs::file_time_type newest{};
+    for (const auto &entry : fs::directory_iterator(base(), ec)) {
+      fs::path candidate = entry.path() / key;
+      if (entry.path().filename() == sanitize(versionGUID) ||
+          !fs::is_directory(candidate, ec) || !hasCacheFiles(candidate))
+        continue;
+      auto t = fs::last_write_time(candidate, ec);
+      if (source.empty() || t > newest) {
+        source = candidate;
+        newest = t;
+      }
+    }
+
+    if (!source.empty()) {
+      LOG_INFO("Seeding shader cache for " + versionGUID + " from " +
+               source.string());
+      size_t seeded = 0;
+      for (auto it = fs::recursive_directory_iterator(source, ec);
+           it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec)
+          break;
+        if (!it->is_regular_file(ec) || isBookkeeping(it->path()))
+          continue;
+
+        fs::path dest = target / fs::relative(it->path(), source, ec);
+        fs::create_directories(dest.parent_path(), ec);
+        fs::path tmp = dest;
+        tmp += ".seed";
+        if (!fs::copy_file(it->path(), tmp,
+                           fs::copy_options::overwrite_existing, ec))
+          continue;
+        // link() refuses to replace a cache DXVK opened in the meantime
+        if (::link(tmp.c_str(), dest.c_str()) == 0)
+          seeded++;
+        fs::remove(tmp, ec);
+      }
+      LOG_INFO("Seeded " + std::to_string(seeded) + " shader cache files.");
+    }
+  }
+
+  prune(Config::instance().snapshot()->general.dxvkSource.installedRoot);
+}
+
+void ShaderCache::prune(const std::string &dxvkRoot) {
+  std::error_code ec;
+  if (!fs::exists(base(), ec))
+    return;
+
+  fs::path versionsDir = PathManager::instance().versions();
+  for (const auto &entry : fs::directory_iterator(base(), ec)) {
+    if (!entry.is_directory(ec))
+      continue;
+    std::string version = entry.path().filename().string();
+    if (!fs::exists(versionsDir / version, ec)) {
+      LOG_INFO("Pruning shader cache for removed version " + version);
+      fs::remove_all(entry.path(), ec);
+    }
+  }
+
+  // DXVK state caches are tied to the DXVK build; driver caches are not
+  fs::path statePath = base() / "state.json";
+  json state = readJson(statePath);
+  std::string previous = state.value("dxvk_root", "");
+  if (!dxvkRoot.empty() && !previous.empty() && previous != dxvkRoot) {
+    LOG_INFO("DXVK changed (" + previous + " -> " + dxvkRoot +
+             "), dropping DXVK state caches");
+    for (auto it = fs::recursive_directory_iterator(base(), ec);
+         it != fs::recursive_directory_iterator(); it.increment(ec)) {
+      if (ec)
+        break;
+      if (it->path().extension() == ".dxvk-cache")
+        fs::remove(it->path(), ec);
+    }
+  }
+  if (!dxvkRoot.empty()) {
+    state["dxvk_root"] = dxvkRoot;
+    writeJson(statePath, state);
+  }
+}
+
+ShaderCache::WarmupSupport ShaderCache::warmupSupport() {
+  WarmupSupport support;
+  std::error_code ec;
+
+  const char *pathEnv = getenv("PATH");
+  std::string pathStr = pathEnv ? pathEnv : "/usr/bin:/bin";
+  size_t start = 0;
+  while (start <= pathStr.size()) {
+    size_t end = pathStr.find(':', start);
+    if (end == std::string::npos)
+      end = pathStr.size();
+    fs::path candidate = fs::path(pathStr.substr(start, end - start)) /
+                         "fossilize-replay";
+    if (::access(candidate.c_str(), X_OK) == 0) {
+      support.replayer = candidate.string();
+      break;
+    }
+    start = end + 1;
+  }
+
+  std::vector<fs::path> layerDirs = {"/usr/share/vulkan/explicit_layer.d",
+                                     "/usr/local/share/vulkan/explicit_layer.d",
+                                     "/etc/vulkan/explicit_layer.d"};
+  if (const char *home = getenv("HOME"))
+    layerDirs.push_back(fs::path(home) / ".local/share/vulkan/explicit_layer.d");
+
+  for (const auto &dir : layerDirs) {
+    for (const auto &entry : fs::directory_iterator(dir, ec)) {
+      std::string name = entry.path().filename().string();
+      std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+      if (name.find("fossilize") != std::string::npos) {
+        support.recorder = true;
+        break;
+      }
+    }
+    if (support.recorder)
+      break;
+  }
+
+  return support;
+}
+
+bool ShaderCache::needsWarmup(const std::string &versionGUID) {
+  std::error_code ec;
+  return !fs::exists(dirFor(versionGUID) / ".warmed", ec);
+}
+
+bool ShaderCache::warmup(
+    const std::string &versionGUID, const fs::path &versionDir,
+    std::function<void(float, const std::string &)> progress) {
+  auto report = [&](float p, const std::string &msg) {
+    if (progress)
+      progress(p, msg);
+  };
+
+  report(0.0f, "Seeding shader cache...");
+  prewarm(versionGUID);
+
+  fs::path target = dirFor(versionGUID);
+  fs::path driverDir = target / "driver";
+  fs::path fozDir = target / "fossilize";
+  std::error_code ec;
+  fs::create_directories(driverDir, ec);
+  fs::create_directories(fozDir, ec);
+
+  // Recordings are driver independent, so after a driver update the newest
+  // ones from the same GPU vendor are replayed into the new driver cache
+  std::vector<fs::path> recordings = fozFiles(fozDir);
+  if (recordings.empty()) {
+    std::string key = gpuKey();
+    std::string vendor = key.substr(0, key.find('-'));
+    fs::path newest;
+    fs::file_time_type newestTime{};
+    for (const auto &versionEntry : fs::directory_iterator(base(), ec)) {
+      for (const auto &gpuEntry :
+           fs::directory_iterator(versionEntry.path(), ec)) {
+        fs::path candidate = gpuEntry.path() / "fossilize";
+        if (candidate == fozDir ||
+            gpuEntry.path().filename().string().rfind(vendor + "-", 0) != 0 ||
+            fozFiles(candidate).empty())
+          continue;
+        auto t = fs::last_write_time(candidate, ec);
+        if (newest.empty() || t > newestTime) {
+          newest = candidate;
+          newestTime = t;
+        }
+      }
+    }
+    for (const auto &file : fozFiles(newest)) {
+      fs::copy_file(file, fozDir / file.filename(),
+                    fs::copy_options::skip_existing, ec);
+    }
+    recordings = fozFiles(fozDir);
+  }
+
+  WarmupSupport support = warmupSupport();
+  if (recordings.empty()) {
+    LOG_INFO("Shader warm-up: no recorded pipelines yet for " + versionGUID);
+  } else if (support.replayer.empty()) {
+    LOG_WARN("Shader warm-up: fossilize-replay not found, skipping replay");
+  } else {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    std::string env = "MESA_SHADER_CACHE_DIR=" + shellQuote(driverDir.string()) +
+                      " __GL_SHADER_DISK_CACHE=1 __GL_SHADER_DISK_CACHE_PATH=" +
+                      shellQuote(driverDir.string()) +
+                      " __GL_SHADER_DISK_CACHE_SKIP_CLEANUP=1";
+    int gpu = Config::instance().snapshot()->general.selectedGpu;
+    if (gpu >= 0)
+      env += " DRI_PRIME=" + std::to_string(gpu);
+
+    for (size_t i = 0; i < recordings.size(); ++i) {
+      report(0.1f + 0.7f * (float)i / (float)recordings.size(),
+             "Replaying pipelines (" + std::to_string(i + 1) + "/" +
+                 std::to_string(recordings.size()) + ")...");
+
+      std::string cmd = env + " " + shellQuote(support.replayer) +
+                        " --num-threads " + std::to_string(threads) + " " +
+                        shellQuote(recordings[i].string()) + " 2>&1";
+      FILE *pipe = popen(cmd.c_str(), "r");
+      if (!pipe)
+        continue;
+      char buf[512];
+      while (fgets(buf, sizeof(buf), pipe)) {
+        std::string line = buf;
+        if (!line.empty() && line.back() == '\n')
+          line.pop_back();
+        LOG_DEBUG("[fossilize] " + line);
+      }
+      int rc = pclose(pipe);
+      if (rc != 0)
+        LOG_WARN("fossilize-replay exited with " + std::to_string(rc) +
+                 " for " + recordings[i].filename().string());
+    }
+  }
+
+  report(0.8f, "Preloading Studio files...");
+  for (auto it = fs::recursive_directory_iterator(versionDir, ec);
+       it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    if (ec)
+      break;
+    std::string ext = it->path().extension().string();
+    bool inShaders = it->path().string().find("/shaders/") != std::string::npos;
+    if (it->is_regular_file(ec) && (inShaders || ext == ".exe" || ext == ".dll"))
+      readAhead(it->path());
+  }
+  for (auto it = fs::recursive_directory_iterator(target, ec);
+       it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    if (ec)
+      break;
+    if (it->path().extension() == ".dxvk-cache")
+      readAhead(it->path());
+  }
+
+  std::ofstream(target / ".warmed") << gpuKey() << "\n";
+  report(1.0f, "Done");
+  LOG_INFO("Shader warm-up finished for " + versionGUID);
+  return true;
+}
+
+void ShaderCache::observe(const std::string &versionGUID,
+                          const std::string &line) {
+  // DXVK: "info:  Read 1234 valid state cache entries"
+  size_t pos = line.find("valid state cache entries");
+  if (pos == std::string::npos || versionGUID.empty())
+    return;
+
+  size_t start = line.rfind("Read ", pos);
+  if (start == std::string::npos)
+    return;
+
+  int64_t entries = 0;
+  try {
+    entries = std::stoll(line.substr(start + 5, pos - start - 5));
+  } catch (...) {
+    return;
+  }
+
+  fs::path statsPath = dirFor(versionGUID) / "stats.json";
+  json s = readJson(statsPath);
+  s["loaded_entries"] = entries;
+  writeJson(statsPath, s);
+}
+
+ShaderCache::Stats ShaderCache::stats() {
+  Stats result;
+  std::error_code ec;
+  if (!fs::exists(base(), ec))
+    return result;
+
+  for (const auto &versionDir : fs::directory_iterator(base(), ec)) {
+    if (!versionDir.is_directory(ec))
+      continue;
+    for (const auto &gpuDir : fs::directory_iterator(versionDir.path(), ec)) {
+      if (!gpuDir.is_directory(ec))
+        continue;
+
+      VersionStats vs;
+      vs.version = versionDir.path().filename().string();
+      vs.gpuKey = gpuDir.path().filename().string();
+      for (auto it = fs::recursive_directory_iterator(gpuDir.path(), ec);
+           it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec)
+          break;
+        if (it->is_regular_file(ec)) {
+          vs.sizeBytes += it->file_size(ec);
+          vs.files++;
+        }
+      }
+
+      json s = readJson(gpuDir.path() / "stats.json");
+      vs.loadedEntries = s.value("loaded_entries", (int64_t)-1);
+      vs.sessions = s.value("sessions", 0);
+
+      result.totalBytes += vs.sizeBytes;
+      result.versions.push_back(vs);
+    }
+  }
+  return result;
+}
+
+void ShaderCache::clear() {
+  std::error_code ec;
+  fs::remove_all(base(), ec);
+  if (ec)
+    LOG_ERROR("Failed to clear shader cache: " + ec.message());
+}
+
+} // namespace rsjfw
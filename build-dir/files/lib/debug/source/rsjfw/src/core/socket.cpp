@@ -1,8 +1,14 @@
 #include "rsjfw/socket.hpp"
 #include "rsjfw/logger.hpp"
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 namespace rsjfw {
@@ -19,7 +25,9 @@ SingleInstance::~SingleInstance() {
   }
 }
 
-bool SingleInstance::isPrimary() {
+bool SingleInstance::isPrimary(std::chrono::milliseconds wait) {
+  if (lockFd_ != -1)
+    return true;
   lockFd_ = open(lockPath_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
   if (lockFd_ == -1) {
     LOG_ERROR("Failed to open lock file: " + lockPath_ + " (" +
@@ -27,8 +35,13 @@ bool SingleInstance::isPrimary() {
     return false;
   }
 
-  if (flock(lockFd_, LOCK_EX | LOCK_NB) == -1) {
+  auto deadline = std::chrono::steady_clock::now() + wait;
+  while (flock(lockFd_, LOCK_EX | LOCK_NB) == -1) {
     if (errno == EWOULDBLOCK) {
+      if (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        continue;
+      }
       // Another instance holds the lock
       close(lockFd_);
       lockFd_ = -1;
@@ -43,4 +56,199 @@ bool SingleInstance::isPrimary() {
   return true;
 }
 
+namespace {
+
+constexpr size_t MAX_REQUEST_BYTES = 64 * 1024;
+// A client that stalls mid-request must not hold up the next one
+constexpr int IO_TIMEOUT_SECONDS = 5;
+
+bool makeAddress(const std::string &path, sockaddr_un &addr) {
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    return false;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+void setTimeouts(int fd) {
+  timeval tv = {IO_TIMEOUT_SECONDS, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+bool sendAll(int fd, const std::string &data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::send(fd, data.data() + done, data.size() - done,
+                       MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+
+// Reads until the peer shuts down its write side
+bool readAll(int fd, std::string &data) {
+  char buf[4096];
+  for (;;) {
+    ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      return false;
+    if (n == 0)
+      return true;
+    data.append(buf, n);
+    if (data.size() > MAX_REQUEST_BYTES)
+      return false;
+  }
+}
+
+} // namespace
+
+CommandServer::CommandServer(const std::filesystem::path &socketPath)
+    : socketPath_(socketPath.string()) {}
+
+CommandServer::~CommandServer() {
+  if (thread_.joinable()) {
+    thread_.request_stop();
+    uint64_t one = 1;
+    (void)!::write(stopFd_, &one, sizeof(one));
+    thread_.join();
+  }
+  if (listenFd_ != -1) {
+    close(listenFd_);
+    unlink(socketPath_.c_str());
+  }
+  if (stopFd_ != -1)
+    close(stopFd_);
+}
+
+bool CommandServer::listen(Handler handler) {
+  sockaddr_un addr;
+  if (!makeAddress(socketPath_, addr)) {
+    LOG_ERROR("Socket path too long: " + socketPath_);
+    return false;
+  }
+
+  listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  stopFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (listenFd_ == -1 || stopFd_ == -1) {
+    LOG_ERROR("Failed to create command socket: " +
+              std::string(strerror(errno)));
+    return false;
+  }
+
+  // Left over from a primary that crashed; we hold the lock now
+  unlink(socketPath_.c_str());
+  mode_t oldMask = umask(0077);
+  int rc = bind(listenFd_, (sockaddr *)&addr, sizeof(addr));
+  umask(oldMask);
+  if (rc == -1 || ::listen(listenFd_, 8) == -1) {
+    LOG_ERROR("Failed to listen on " + socketPath_ + ": " +
+              std::string(strerror(errno)));
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+
+  handler_ = std::move(handler);
+  thread_ = std::jthread([this](std::stop_token stop) { serve(stop); });
+  return true;
+}
+
+void CommandServer::serve(std::stop_token stop) {
+  while (!stop.stop_requested()) {
+    pollfd fds[2] = {{listenFd_, POLLIN, 0}, {stopFd_, POLLIN, 0}};
+    if (poll(fds, 2, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      LOG_ERROR("Command socket poll failed: " + std::string(strerror(errno)));
+      return;
+    }
+    if (fds[1].revents)
+      return;
+    if (!(fds[0].revents & POLLIN))
+      continue;
+
+    int client = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client == -1)
+      continue;
+    handle(client);
+    close(client);
+  }
+}
+
+void CommandServer::handle(int client) {
+  ucred cred;
+  socklen_t len = sizeof(cred);
+  if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1 ||
+      cred.uid != geteuid()) {
+    LOG_WARN("Refused command from another user");
+    return;
+  }
+
+  setTimeouts(client);
+  std::string data;
+  if (!readAll(client, data) || data.empty()) {
+    sendAll(client, "ERR bad request\n");
+    return;
+  }
+
+  std::vector<std::string> request;
+  size_t pos = 0;
+  while (pos < data.size()) {
+    size_t end = data.find('\0', pos);
+    if (end == std::string::npos)
+      end = data.size();
+    request.push_back(data.substr(pos, end - pos));
+    pos = end + 1;
+  }
+
+  LOG_INFO("Command from pid " + std::to_string(cred.pid) + ": " +
+           request[0]);
+  std::string reply;
+  try {
+    reply = handler_(request);
+  } catch (const std::exception &e) {
+    reply = "ERR " + std::string(e.what());
+  }
+  sendAll(client, reply + "\n");
+}
+
+std::optional<std::string>
+CommandServer::send(const std::filesystem::path &socketPath,
+                    const std::vector<std::string> &request) {
+  sockaddr_un addr;
+  if (request.empty() || !makeAddress(socketPath.string(), addr))
+    return std::nullopt;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1)
+    return std::nullopt;
+  setTimeouts(fd);
+
+  std::string data;
+  for (const auto &field : request) {
+    data += field;
+    data += '\0';
+  }
+
+  bool sent = connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0 &&
+              sendAll(fd, data) && shutdown(fd, SHUT_WR) == 0;
+  std::string reply;
+  if (sent && !readAll(fd, reply))
+    reply.clear();
+  close(fd);
+  if (!sent)
+    return std::nullopt;
+  if (!reply.empty() && reply.back() == '\n')
+    reply.pop_back();
+  return reply;
+}
+
 } // namespace rsjfw
@@ -0,0 +1,154 @@
+#include "rsjfw/standby.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/process.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <malloc.h>
+#include <optional>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace rsjfw {
+
+namespace {
+
+// Without pidfds (Linux < 5.3) or while /proc is in flux, rescan this often
+constexpr int RESCAN_MS = 5000;
+
+// Studio processes in the prefix, not the wineserver and services that
+// outlive it; nullopt if /proc changed under the scan
+std::optional<std::vector<int>>
+studioPids(const std::filesystem::path &prefixDir) {
+  std::vector<int> pids;
+  try {
+    for (const auto &proc : Process::findStudioInPrefix(prefixDir.string())) {
+      // Wine names Windows processes after their exe, cut to 15 characters
+      std::string comm;
+      std::ifstream("/proc/" + std::to_string(proc.pid) + "/comm") >> comm;
+      if (comm.rfind("RobloxStudio", 0) == 0 ||
+          proc.exe.find("RobloxStudio") != std::string::npos)
+        pids.push_back(proc.pid);
+    }
+  } catch (const std::exception &e) {
+    LOG_DEBUG("Studio scan failed: " + std::string(e.what()));
+    return std::nullopt;
+  }
+  return pids;
+}
+
+int pidfdOpen(int pid) {
+#ifdef SYS_pidfd_open
+  return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+} // namespace
+
+Standby &Standby::instance() {
+  static Standby instance;
+  return instance;
+}
+
+Standby::Standby() {
+  eventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (eventFd_ == -1)
+    LOG_ERROR("Standby: eventfd failed, show requests are polled");
+}
+
+Standby::~Standby() {
+  if (eventFd_ != -1)
+    close(eventFd_);
+}
+
+void Standby::requestShow() {
+  showRequested_ = true;
+  notify();
+}
+
+bool Standby::handOff() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!waiting_)
+    return false;
+  handOff_ = true;
+  notify();
+  return true;
+}
+
+void Standby::notify() {
+  if (eventFd_ != -1) {
+    uint64_t one = 1;
+    (void)!write(eventFd_, &one, sizeof(one));
+  }
+}
+
+Standby::Wake Standby::wait(const std::filesystem::path &prefixDir) {
+  // The GUI's allocations are gone; without this glibc keeps the pages
+  malloc_trim(0);
+  LOG_INFO("Standing by until Studio exits");
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    waiting_ = true;
+    handOff_ = false;
+  }
+  // A hand-off wins over anything else, as its sender is waiting for the
+  // lock
+  auto leave = [this](Wake wake) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    waiting_ = false;
+    return handOff_ ? Wake::HAND_OFF : wake;
+  };
+
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (handOff_) {
+        LOG_INFO("Handing off to a new instance");
+        waiting_ = false;
+        return Wake::HAND_OFF;
+      }
+    }
+    if (takeShowRequest()) {
+      LOG_INFO("Leaving standby");
+      return leave(Wake::SHOW);
+    }
+
+    auto pids = studioPids(prefixDir);
+    if (pids && pids->empty()) {
+      LOG_INFO("Studio exited, leaving standby");
+      return leave(Wake::NO_STUDIO);
+    }
+
+    std::vector<pollfd> fds;
+    if (eventFd_ != -1)
+      fds.push_back({eventFd_, POLLIN, 0});
+    size_t firstPidfd = fds.size();
+    for (int pid : pids.value_or(std::vector<int>{})) {
+      int fd = pidfdOpen(pid);
+      if (fd != -1)
+        fds.push_back({fd, POLLIN, 0});
+    }
+
+    // Any Studio exiting ends the poll; the rescan decides whether others
+    // are left. Without a pidfd, fall back to rescanning on a timer.
+    bool watching = fds.size() > firstPidfd && eventFd_ != -1;
+    int rc = poll(fds.data(), fds.size(), watching ? -1 : RESCAN_MS);
+    if (rc == -1 && errno != EINTR)
+      LOG_WARN("Standby poll failed: " + std::string(strerror(errno)));
+
+    if (eventFd_ != -1) {
+      uint64_t count;
+      (void)!read(eventFd_, &count, sizeof(count));
+    }
+    for (size_t i = firstPidfd; i < fds.size(); ++i)
+      close(fds[i].fd);
+  }
+}
+
+} // namespace rsjfw
@@ -0,0 +1,375 @@
+#include "rsjfw/storage.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/task_runner.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace rsjfw {
+
+namespace {
+
+constexpr size_t MAX_WALKERS = 4;
+
+size_t walkerCount() {
+  return std::clamp<size_t>(std::thread::hardware_concurrency(), 1,
+                            MAX_WALKERS);
+}
+
+bool isDots(const char *name) {
+  return name[0] == '.' &&
+         (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+// Runs `visit` on `count` threads, the caller's included, over a shared
+// stack seeded with `first`. `visit` may push more work; the walk ends once
+// the stack is empty and nobody is still visiting.
+template <typename T, typename Visit>
+void parallelWalk(T first, Visit visit) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<T> pending{std::move(first)};
+  size_t busy = 0;
+
+  auto push = [&](T item) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.push_back(std::move(item));
+    }
+    cv.notify_one();
+  };
+
+  auto walker = [&]() {
+    for (;;) {
+      T item;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return !pending.empty() || busy == 0; });
+        if (pending.empty())
+          return;
+        item = std::move(pending.back());
+        pending.pop_back();
+        busy++;
+      }
+      visit(std::move(item), push);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy--;
+      }
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::jthread> helpers;
+  for (size_t i = 1; i < walkerCount(); ++i)
+    helpers.emplace_back(walker);
+  walker();
+}
+
+// A directory being deleted. It is removed once its own entries and all
+// of its subdirectories are gone.
+struct DeleteNode {
+  std::string path;
+  DeleteNode *parent = nullptr;
+  std::atomic<size_t> pending{1}; // Subdirectories, plus the node itself
+};
+
+std::string uniqueName(const fs::path &path) {
+  static std::atomic<uint64_t> counter{0};
+  auto ns = std::chrono::system_clock::now().time_since_epoch().count();
+  return path.filename().string() + "." + std::to_string(ns) + "." +
+         std::to_string(counter++);
+}
+
+} // namespace
+
+Storage &Storage::instance() {
+  static Storage instance;
+  return instance;
+}
+
+Storage::Storage() : usage_(std::make_shared<const StorageUsage>()) {}
+
+uint64_t Storage::treeSize(const fs::path &root, std::stop_token stop) {
+  std::atomic<uint64_t> total{0};
+  parallelWalk(root.string(), [&](std::string dir, auto &push) {
+    if (stop.stop_requested())
+      return;
+    int fd = ::open(dir.c_str(),
+                    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+      return;
+    DIR *d = fdopendir(fd);
+    if (!d) {
+      ::close(fd);
+      return;
+    }
+    uint64_t bytes = 0;
+    while (struct dirent *e = readdir(d)) {
+      if (isDots(e->d_name))
+        continue;
+      // d_type spares a statx for everything but files
+      unsigned char type = e->d_type;
+      if (type == DT_REG || type == DT_UNKNOWN) {
+        struct statx sx;
+        if (statx(fd, e->d_name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+                  STATX_TYPE | STATX_SIZE, &sx) != 0)
+          continue;
+        if (S_ISREG(sx.stx_mode)) {
+          bytes += sx.stx_size;
+          continue;
+        }
+        type = S_ISDIR(sx.stx_mode) ? DT_DIR : DT_UNKNOWN;
+      }
+      if (type == DT_DIR)
+        push(dir + "/" + e->d_name);
+    }
+    closedir(d);
+    total += bytes;
+  });
+  return total;
+}
+
+bool Storage::discard(const fs::path &path, bool recreate) {
+  std::error_code ec;
+  if (!fs::exists(fs::symlink_status(path, ec)))
+    return false;
+
+  fs::path trash = PathManager::instance().trash();
+  fs::create_directories(trash, ec);
+  fs::path target = trash / uniqueName(path);
+  fs::rename(path, target, ec);
+  if (ec == std::errc::cross_device_link) {
+    // A data directory symlinked to another disk; a hidden sibling is the
+    // closest place rename() can reach
+    target = path.parent_path() / ("." + uniqueName(path) + ".rsjfw-trash");
+    fs::rename(path, target, ec);
+    if (!ec) {
+      // Recorded in trash/, so sweep() finds it if this run does not
+      // finish the job
+      fs::path record = trash / (uniqueName(path) + ".rsjfw-trash");
+      std::error_code linkEc;
+      fs::create_symlink(fs::absolute(target, linkEc), record, linkEc);
+      if (linkEc)
+        LOG_WARN("Cannot record " + target.string() + " in trash: " +
+                 linkEc.message());
+      else
+        target = record;
+    }
+  }
+  if (ec) {
+    LOG_WARN("Cannot move " + path.string() + " to trash: " + ec.message());
+    return false;
+  }
+  LOG_INFO("Discarded " + path.string());
+
+  if (recreate)
+    fs::create_directories(path, ec);
+  enqueue(std::move(target));
+  return true;
+}
+
+void Storage::sweep() {
+  std::error_code ec;
+  for (const auto &entry :
+       fs::directory_iterator(PathManager::instance().trash(), ec))
+    enqueue(entry.path());
+}
+
+void Storage::enqueue(fs::path path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  queue_.push_back(std::move(path));
+  active_++;
+  if (draining_)
+    return;
+  draining_ = true;
+  TaskRunner::instance().run(
+      [this](std::stop_token stop) { drain(stop); },
+      TaskPriority::BACKGROUND, "Reclaim space");
+}
+
+void Storage::drain(std::stop_token stop) {
+  for (;;) {
+    fs::path next;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Anything left over is swept on the next start
+      if (queue_.empty() || stop.stop_requested()) {
+        draining_ = false;
+        return;
+      }
+      next = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    auto started = std::chrono::steady_clock::now();
+    uint64_t bytesBefore = removedBytes_;
+    // A record of a tree trashed next to itself on another disk; it goes
+    // once the tree is gone
+    std::error_code ec;
+    bool record =
+        next.extension() == ".rsjfw-trash" && fs::is_symlink(next, ec);
+    fs::path victim = record ? fs::read_symlink(next, ec) : next;
+    removeTree(victim, stop);
+    if (record && !fs::exists(fs::symlink_status(victim, ec)))
+      ::unlink(next.c_str());
+    active_--;
+    LOG_DEBUG("Reclaimed " +
+              std::to_string((removedBytes_ - bytesBefore) >> 20) +
+              " MB from " + next.filename().string() + " in " +
+              std::to_string(std::chrono::duration_cast<
+                                 std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - started)
+                                 .count()) +
+              " ms");
+  }
+}
+
+void Storage::removeTree(const fs::path &path, std::stop_token stop) {
+  // Not a directory (or a symlink to one): a single unlink
+  struct statx sx;
+  if (statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW,
+            STATX_TYPE | STATX_BLOCKS, &sx) != 0)
+    return;
+  if (!S_ISDIR(sx.stx_mode)) {
+    if (::unlink(path.c_str()) == 0) {
+      removedFiles_++;
+      removedBytes_ += sx.stx_blocks * 512;
+    }
+    return;
+  }
+
+  // Drops one reference; whoever drops the last removes the directory and
+  // passes that on to its parent
+  auto release = [](DeleteNode *node) {
+    while (node && --node->pending == 0) {
+      ::rmdir(node->path.c_str());
+      DeleteNode *parent = node->parent;
+      delete node;
+      node = parent;
+    }
+  };
+
+  auto *root = new DeleteNode;
+  root->path = path.string();
+  parallelWalk(root, [&](DeleteNode *node, auto &push) {
+    if (stop.stop_requested()) {
+      release(node);
+      return;
+    }
+    int fd = ::open(node->path.c_str(),
+                    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR *d = fd < 0 ? nullptr : fdopendir(fd);
+    if (!d) {
+      if (fd >= 0)
+        ::close(fd);
+      release(node);
+      return;
+    }
+
+    // Read everything first; unlinking while readdir() runs may skip names
+    std::vector<std::pair<std::string, unsigned char>> entries;
+    while (struct dirent *e = readdir(d))
+      if (!isDots(e->d_name))
+        entries.emplace_back(e->d_name, e->d_type);
+
+    bool madeWritable = false;
+    uint64_t files = 0, bytes = 0;
+    for (auto &[name, type] : entries) {
+      if (type != DT_DIR) {
+        struct statx sx;
+        if (statx(fd, name.c_str(), AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+                  STATX_TYPE | STATX_BLOCKS, &sx) != 0)
+          continue;
+        if (!S_ISDIR(sx.stx_mode)) {
+          int rc = ::unlinkat(fd, name.c_str(), 0);
+          // Read-only directories show up in Wine prefixes
+          if (rc != 0 && errno == EACCES && !madeWritable) {
+            madeWritable = true;
+            ::fchmod(fd, S_IRWXU);
+            rc = ::unlinkat(fd, name.c_str(), 0);
+          }
+          if (rc == 0) {
+            files++;
+            bytes += sx.stx_blocks * 512;
+          }
+          continue;
+        }
+      }
+      if (!madeWritable) {
+        // The subdirectory's own rmdir needs this directory writable too
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && !(st.st_mode & S_IWUSR)) {
+          madeWritable = true;
+          ::fchmod(fd, S_IRWXU);
+        }
+      }
+      auto *child = new DeleteNode;
+      child->path = node->path + "/" + name;
+      child->parent = node;
+      node->pending++;
+      push(child);
+    }
+    closedir(d);
+    removedFiles_ += files;
+    removedBytes_ += bytes;
+    release(node);
+  });
+}
+
+Storage::Progress Storage::progress() const {
+  Progress p;
+  p.files = removedFiles_;
+  p.bytes = removedBytes_;
+  p.pending = active_;
+  return p;
+}
+
+void Storage::refreshUsage() {
+  if (measuring_.exchange(true))
+    return;
+  TaskRunner::instance().run(
+      [this](std::stop_token stop) {
+        auto &pm = PathManager::instance();
+        const std::pair<const char *, fs::path> dirs[] = {
+            {"Studio versions", pm.versions()},
+            {"Wine prefix", pm.prefix()},
+            {"Wine builds", pm.wine()},
+            {"DXVK builds", pm.dxvk()},
+            {"Downloads", pm.downloads()},
+            {"Logs", pm.logs()},
+            {"Cache", pm.cache()},
+            {"Trash", pm.trash()}};
+
+        StorageUsage next;
+        for (const auto &[name, path] : dirs) {
+          StorageUsage::Item item{name, path, treeSize(path, stop)};
+          if (stop.stop_requested()) {
+            measuring_ = false;
+            return;
+          }
+          next.totalBytes += item.bytes;
+          next.items.push_back(std::move(item));
+        }
+        struct statvfs vfs;
+        if (::statvfs(pm.root().c_str(), &vfs) == 0)
+          next.freeBytes = (uint64_t)vfs.f_bavail * vfs.f_frsize;
+        next.ready = true;
+        usage_.store(std::make_shared<const StorageUsage>(std::move(next)),
+                     std::memory_order_release);
+        measuring_ = false;
+      },
+      TaskPriority::BACKGROUND, "Measure storage");
+}
+
+} // namespace rsjfw
@@ -1,29 +1,258 @@
 #include "rsjfw/task_runner.hpp"
+#include "rsjfw/config.hpp"
 #include "rsjfw/logger.hpp"
+#include "rsjfw/performance.hpp"
+#include <algorithm>
+#include <pthread.h>
 
 namespace rsjfw {
 
+namespace {
+thread_local void* currentWorker = nullptr;
+thread_local const std::string* currentTask = nullptr;
+thread_local bool currentReported = false;
+
+constexpr size_t BACKGROUND_WORKERS = 2;
+
+size_t interactiveWorkers() {
+    // Interactive tasks can block for long (the launch waits on Studio), so
+    // keep a few spare even on small machines
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 4, 8);
+}
+
+void setThreadName(const std::string& name) {
+    // Linux limits thread names to 15 characters
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+}
+} // namespace
+
 TaskRunner& TaskRunner::instance() {
     static TaskRunner instance;
     return instance;
 }
 
-void TaskRunner::run(std::function<void()> task) {
+TaskHandle TaskRunner::submit(Task fn, TaskPriority priority, std::string name) {
+    TaskHandle handle;
+    handle.state_ = std::make_shared<TaskHandle::State>();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            LOG_DEBUG("TaskRunner is shut down, dropping task " + name);
+            handle.state_->done = true;
+            handle.state_->rejected = true;
+            return handle;
+        }
+        if (!started_) start();
+    }
+
+    Pool& pool = priority == TaskPriority::BACKGROUND ? background_ : interactive_;
+    Worker* target = nullptr;
+    for (auto& worker : pool.workers) {
+        if (worker.get() == currentWorker) target = worker.get();
+    }
+    if (!target) target = pool.workers[pool.next++ % pool.workers.size()].get();
+
+    {
+        std::lock_guard<std::mutex> lock(target->mutex);
+        target->jobs.push_back({std::move(fn), handle.state_, std::move(name)});
+        pool.queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+    }
+    pool.cv.notify_one();
+    return handle;
+}
+
+// Called with mutex_ held
+void TaskRunner::start() {
+    started_ = true;
+    for (Pool* pool : {&interactive_, &background_}) {
+        size_t count = pool == &background_ ? BACKGROUND_WORKERS : interactiveWorkers();
+        for (size_t i = 0; i < count; ++i)
+            pool->workers.push_back(std::make_unique<Worker>());
+        // Workers only start once the deques they steal from all exist
+        for (size_t i = 0; i < count; ++i) {
+            pool->workers[i]->thread = std::jthread([this, pool, i](std::stop_token stop) {
+                workerLoop(stop, *pool, i);
+            });
+        }
+    }
+    LOG_DEBUG("TaskRunner started " + std::to_string(interactive_.workers.size()) +
+              " interactive and " + std::to_string(background_.workers.size()) +
+              " background workers");
+}
+
+bool TaskRunner::take(Pool& pool, size_t index, Job& job) {
+    // Newest local task first, it is most likely still in cache
+    {
+        Worker& self = *pool.workers[index];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (!self.jobs.empty()) {
+            job = std::move(self.jobs.back());
+            self.jobs.pop_back();
+            pool.queued--;
+            return true;
+        }
+    }
+    // Then the oldest task of a sibling
+    for (size_t n = 1; n < pool.workers.size(); ++n) {
+        Worker& victim = *pool.workers[(index + n) % pool.workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            pool.queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskRunner::workerLoop(std::stop_token stop, Pool& pool, size_t index) {
+    Worker& self = *pool.workers[index];
+    currentWorker = &self;
+    bool background = pool.priority == TaskPriority::BACKGROUND;
+    std::string threadName = (background ? "rsjfw-bg-" : "rsjfw-task-") + std::to_string(index);
+    setThreadName(threadName);
+
+    while (!stop.stop_requested()) {
+        Job job;
+        if (!take(pool, index, job)) {
+            std::unique_lock<std::mutex> lock(pool.mutex);
+            pool.cv.wait(lock, stop, [&pool]() { return pool.queued.load() > 0; });
+            continue;
+        }
+        if (background) {
+            // Per task, so changing the setting applies without a restart
+            bool low = Config::instance().snapshot()->performance.lowPriorityBackground;
+            if (low != self.lowPriority) {
+                Performance::setBackgroundPriority(low);
+                self.lowPriority = low;
+            }
+        }
+        if (!job.name.empty()) setThreadName(job.name);
+        execute(self, job);
+        if (!job.name.empty()) setThreadName(threadName);
+    }
+}
+
+void TaskRunner::execute(Worker& worker, Job& job) {
+    if (!job.state->stop.stop_requested()) {
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.current = job.state;
+        }
+        const std::string* outerTask = currentTask;
+        bool outerReported = currentReported;
+        currentTask = &job.name;
+        currentReported = false;
+        try {
+            job.fn(job.state->stop.get_token());
+        } catch (const std::exception& e) {
+            LOG_ERROR("Task " + (job.name.empty() ? std::string("(unnamed)") : job.name) +
+                      " failed: " + e.what());
+        } catch (...) {
+            LOG_ERROR("Task " + (job.name.empty() ? std::string("(unnamed)") : job.name) +
+                      " failed");
+        }
+        if (currentReported) {
+            FinishSink sink;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                sink = finishSink_;
+            }
+            if (sink) sink(job.name);
+        }
+        currentTask = outerTask;
+        currentReported = outerReported;
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.current = nullptr;
+        }
+    }
+    job.state->done = true;
+}
+
+bool TaskRunner::onWorker() {
+    return currentWorker != nullptr;
+}
+
+bool TaskRunner::runLocal() {
+    Worker* self = static_cast<Worker*>(currentWorker);
+    if (!self) return false;
+
+    for (Pool* pool : {&interactive_, &background_}) {
+        for (auto& worker : pool->workers) {
+            if (worker.get() != self) continue;
+            Job job;
+            {
+                std::lock_guard<std::mutex> lock(self->mutex);
+                if (self->jobs.empty()) return false;
+                job = std::move(self->jobs.back());
+                self->jobs.pop_back();
+                pool->queued--;
+            }
+            // The waiting task stays current, for shutdown's cancel
+            auto outer = self->current;
+            execute(*self, job);
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->current = outer;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskRunner::progress(float progress, const std::string& status) {
+    if (!currentTask || currentTask->empty()) return;
+    currentReported = true;
+    auto& runner = instance();
+    ProgressSink sink;
+    {
+        std::lock_guard<std::mutex> lock(runner.mutex_);
+        sink = runner.sink_;
+    }
+    if (sink) sink(*currentTask, progress, status);
+}
+
+void TaskRunner::setProgressSink(ProgressSink sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_ = std::move(sink);
+}
+
+void TaskRunner::setFinishSink(FinishSink sink) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Prune finished threads if any (optional, but good for long-running apps)
-    // For now, just append to the list of jthreads. 
-    // std::jthread automatically joins on destruction if not joined.
-    threads_.emplace_back(std::move(task));
+    finishSink_ = std::move(sink);
 }
 
 void TaskRunner::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+        if (!started_) return;
+    }
     LOG_INFO("Shutting down TaskRunner, waiting for background threads...");
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // jthreads will automatically request stop and join on destruction
-    // but explicit clearing ensures we join NOW.
-    threads_.clear();
+
+    for (Pool* pool : {&interactive_, &background_}) {
+        for (auto& worker : pool->workers) {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            for (auto& job : worker->jobs) job.state->done = true;
+            pool->queued -= worker->jobs.size();
+            worker->jobs.clear();
+            if (worker->current) worker->current->stop.request_stop();
+            worker->thread.request_stop();
+        }
+    }
+
+    // Joins NOW; running tasks finish (or notice their stop_token) first
+    for (Pool* pool : {&interactive_, &background_}) {
+        for (auto& worker : pool->workers) {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+    }
     LOG_INFO("TaskRunner shutdown complete.");
 }
 
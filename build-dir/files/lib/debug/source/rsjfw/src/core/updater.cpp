@@ -0,0 +1,140 @@
+#include "rsjfw/updater.hpp"
+#include "rsjfw/config.hpp"
+#include "rsjfw/downloader.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/performance.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace rsjfw {
+
+namespace {
+
+// Never poll more often than this, whatever the config says
+constexpr auto MIN_INTERVAL = std::chrono::minutes(5);
+
+// Sleeps for `duration`; false if woken by `stop`
+bool sleepFor(std::stop_token stop, std::chrono::seconds duration) {
+  std::mutex mutex;
+  std::condition_variable_any cv;
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait_for(lock, stop, duration, []() { return false; });
+  return !stop.stop_requested();
+}
+
+} // namespace
+
+Updater &Updater::instance() {
+  static Updater instance;
+  return instance;
+}
+
+Updater::~Updater() { stop(); }
+
+void Updater::start(std::chrono::seconds delay) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (worker_.joinable())
+    return;
+  worker_ = std::jthread(
+      [this, delay](std::stop_token stop) { loop(stop, delay); });
+}
+
+void Updater::stop() {
+  std::jthread worker;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    worker = std::move(worker_);
+  }
+  if (worker.joinable()) {
+    worker.request_stop();
+    worker.join();
+  }
+}
+
+std::string Updater::staged() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return staged_;
+}
+
+bool Updater::metered() {
+  // NMMetered: 1 is yes, 3 is a guess at yes
+  FILE *pipe =
+      popen("gdbus call --system --dest org.freedesktop.NetworkManager "
+            "--object-path /org/freedesktop/NetworkManager --method "
+            "org.freedesktop.DBus.Properties.Get "
+            "org.freedesktop.NetworkManager Metered 2>/dev/null",
+            "r");
+  if (!pipe)
+    return false;
+  char buf[128] = {0};
+  bool gotReply = fgets(buf, sizeof(buf), pipe) != nullptr;
+  pclose(pipe);
+  if (!gotReply)
+    return false;
+
+  // The reply looks like "(<uint32 4>,)"
+  unsigned value = 0;
+  const char *num = std::strstr(buf, "uint32 ");
+  if (!num || std::sscanf(num, "uint32 %u", &value) != 1)
+    return false;
+  return value == 1 || value == 3;
+}
+
+void Updater::loop(std::stop_token stop, std::chrono::seconds delay) {
+  Performance::enterBackgroundPriority();
+  if (!sleepFor(stop, delay))
+    return;
+
+  while (!stop.stop_requested()) {
+    check(stop);
+    auto minutes = std::chrono::minutes(std::max(
+        Config::instance().snapshot()->versions.prefetchIntervalMinutes, 0));
+    if (!sleepFor(stop, std::max<std::chrono::seconds>(minutes, MIN_INTERVAL)))
+      return;
+  }
+}
+
+void Updater::check(std::stop_token stop) {
+  auto config = Config::instance().snapshot();
+  // With an override there is nothing newer to fetch
+  if (!config->versions.prefetch || !config->general.robloxVersion.empty())
+    return;
+  if (metered()) {
+    LOG_DEBUG("Metered connection, not checking for Studio updates");
+    return;
+  }
+
+  Downloader downloader(PathManager::instance().root().string());
+  std::string latest;
+  try {
+    latest = downloader.getLatestVersionGUID();
+  } catch (const std::exception &e) {
+    LOG_DEBUG("Update check failed: " + std::string(e.what()));
+    return;
+  }
+  if (latest.empty() || downloader.isVersionInstalled(latest))
+    return;
+
+  LOG_INFO("Prefetching Studio " + latest);
+  downloader.setTransferLimit(
+      (uint64_t)std::max(config->versions.prefetchLimitKBps, 0) << 10);
+  downloader.setStopToken(stop);
+  installing_ = true;
+  bool ok = downloader.installVersion(latest);
+  installing_ = false;
+
+  if (ok) {
+    LOG_INFO("Studio " + latest + " is staged for the next launch");
+    std::lock_guard<std::mutex> lock(mutex_);
+    staged_ = latest;
+  } else if (stop.stop_requested()) {
+    LOG_INFO("Prefetch of " + latest + " paused, it resumes next time");
+  } else {
+    LOG_WARN("Prefetch of " + latest + " failed, retrying later");
+  }
+}
+
+} // namespace rsjfw
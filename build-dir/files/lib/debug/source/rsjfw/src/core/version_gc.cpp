@@ -0,0 +1,154 @@
+#include "rsjfw/version_gc.hpp"
+#include "rsjfw/config.hpp"
+#include "rsjfw/downloader.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include "rsjfw/storage.hpp"
+#include "rsjfw/task_runner.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace rsjfw {
+
+namespace {
+
+// Partial downloads and extractions younger than this may still be in
+// progress
+constexpr auto STALE_AFTER = std::chrono::hours(1);
+
+bool isStale(const fs::path &path) {
+  std::error_code ec;
+  auto mtime = fs::last_write_time(path, ec);
+  return !ec && fs::file_time_type::clock::now() - mtime > STALE_AFTER;
+}
+
+// Versions named on the command line of a running process. Wine keeps the
+// Windows path of the executable there, which contains the GUID either way.
+std::set<std::string> runningVersions(const std::vector<std::string> &guids) {
+  std::set<std::string> running;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator("/proc", ec)) {
+    const std::string pid = entry.path().filename().string();
+    if (pid.empty() || !std::all_of(pid.begin(), pid.end(), ::isdigit))
+      continue;
+    std::ifstream in(entry.path() / "cmdline", std::ios::binary);
+    std::string cmdline((std::istreambuf_iterator<char>(in)),
+                        std::istreambuf_iterator<char>());
+    for (const auto &guid : guids)
+      if (cmdline.find(guid) != std::string::npos)
+        running.insert(guid);
+  }
+  return running;
+}
+
+} // namespace
+
+VersionGC &VersionGC::instance() {
+  static VersionGC instance;
+  return instance;
+}
+
+void VersionGC::schedule(const std::string &launched) {
+  if (queued_.exchange(true))
+    return;
+  TaskRunner::instance().run(
+      [this, launched](std::stop_token stop) {
+        queued_ = false;
+        run(launched, stop);
+      },
+      TaskPriority::BACKGROUND, "Version cleanup");
+}
+
+uint64_t VersionGC::run(const std::string &launched, std::stop_token stop) {
+  std::lock_guard<std::mutex> runLock(runMutex_);
+  busy_ = true;
+
+  auto config = Config::instance().snapshot();
+  const auto &cfg = config->versions;
+  auto &pm = PathManager::instance();
+  Downloader downloader(pm.root().string());
+  std::vector<std::string> installed = downloader.getInstalledVersions();
+
+  // Old versions only go once the newest one is known to start
+  std::vector<fs::path> victims;
+  if (cfg.autoClean && !installed.empty() &&
+      (launched.empty() || launched == installed.front())) {
+    std::set<std::string> keep(cfg.pinned.begin(), cfg.pinned.end());
+    if (!config->general.robloxVersion.empty())
+      keep.insert(config->general.robloxVersion);
+    size_t keepCount = (size_t)std::max(cfg.keep, 1);
+    for (size_t i = 0; i < installed.size() && i < keepCount; ++i)
+      keep.insert(installed[i]);
+
+    std::vector<std::string> candidates;
+    for (const auto &version : installed)
+      if (!keep.count(version))
+        candidates.push_back(version);
+    auto inUse = runningVersions(candidates);
+    for (const auto &version : candidates) {
+      if (inUse.count(version)) {
+        LOG_INFO("Keeping " + version + ", it is still running");
+        continue;
+      }
+      victims.push_back(pm.versions() / version);
+    }
+  }
+
+  // Installs that died before writing AppSettings.xml. The latest
+  // version's staging directory is kept so its install can resume.
+  const std::string resumable =
+      ".staging-" + downloader.getCachedLatestVersionGUID();
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(pm.versions(), ec)) {
+    const std::string name = entry.path().filename().string();
+    if (!entry.is_directory(ec) || name == launched || name == resumable)
+      continue;
+    if (!fs::exists(entry.path() / "AppSettings.xml", ec) &&
+        isStale(entry.path()))
+      victims.push_back(entry.path());
+  }
+
+  // Downloads nobody finished; completed packages are removed on extraction
+  for (const auto &entry : fs::directory_iterator(pm.downloads(), ec)) {
+    if (entry.path().extension() == ".part" && isStale(entry.path()))
+      victims.push_back(entry.path());
+  }
+
+  uint64_t reclaimed = 0;
+  size_t removed = 0;
+  for (size_t i = 0; i < victims.size() && !stop.stop_requested(); ++i) {
+    const auto &path = victims[i];
+    TaskRunner::progress((float)i / (float)victims.size(),
+                         "Removing " + path.filename().string());
+    std::error_code sizeEc;
+    uint64_t bytes = fs::is_directory(fs::symlink_status(path, sizeEc))
+                         ? Storage::treeSize(path, stop)
+                         : fs::file_size(path, sizeEc);
+    if (Storage::instance().discard(path)) {
+      reclaimed += sizeEc ? 0 : bytes;
+      removed++;
+    }
+  }
+
+  if (removed > 0) {
+    LOG_INFO("Version cleanup removed " + std::to_string(removed) +
+             " item(s), reclaiming " + std::to_string(reclaimed >> 20) +
+             " MB");
+  }
+  if (removed < victims.size() && !stop.stop_requested())
+    LOG_WARN("Version cleanup could not remove " +
+             std::to_string(victims.size() - removed) + " item(s)");
+  lastReclaimed_ = reclaimed;
+  busy_ = false;
+  return reclaimed;
+}
+
+} // namespace rsjfw
@@ -1,13 +1,20 @@
 #include "rsjfw/wine.hpp"
 #include "rsjfw/logger.hpp"
 #include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <string_view>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
 
 extern char **environ;
@@ -73,10 +80,12 @@ std::string Prefix::bin(const std::string &prog) const {
 
 void Prefix::setEnv(const std::map<std::string, std::string> &env) {
   env_ = env;
+  envCache_.reset();
 }
 
 void Prefix::appendEnv(const std::string &key, const std::string &value) {
   env_[key] = value;
+  envCache_.reset();
 }
 
 std::string Prefix::getEnv(const std::string &key) const {
@@ -87,97 +96,135 @@ std::string Prefix::getEnv(const std::string &key) const {
   return val ? std::string(val) : "";
 }
 
-std::vector<std::string> Prefix::buildEnv() const {
-  std::vector<std::string> finalEnv;
-  std::map<std::string, std::string> currentMap;
-
-  for (char **s = environ; *s; s++) {
-    std::string str(*s);
-    size_t pos = str.find('=');
-    if (pos != std::string::npos) {
-      std::string key = str.substr(0, pos);
-      std::string val = str.substr(pos + 1);
-      currentMap[key] = val;
-    }
-  }
+const Prefix::EnvBlock &Prefix::envBlock() const {
+  if (envCache_)
+    return *envCache_;
 
-  for (const auto &[key, val] : env_) {
-    currentMap[key] = val;
-  }
+  auto overridden = [&](std::string_view entry) {
+    std::string_view key = entry.substr(0, entry.find('='));
+    return (!dir_.empty() && key == "WINEPREFIX") ||
+           env_.find(std::string(key)) != env_.end();
+  };
 
-  if (!dir_.empty()) {
-    currentMap["WINEPREFIX"] = dir_;
-  }
+  auto block = std::make_shared<EnvBlock>();
+  for (char **e = environ; *e; ++e)
+    if (!overridden(*e))
+      block->strings.emplace_back(*e);
+  for (const auto &[key, val] : env_)
+    block->strings.push_back(key + "=" + val);
+  if (!dir_.empty())
+    block->strings.push_back("WINEPREFIX=" + dir_);
+
+  // Pointers are taken only once the strings stop moving
+  block->envp.reserve(block->strings.size() + 1);
+  for (auto &str : block->strings)
+    block->envp.push_back(str.data());
+  block->envp.push_back(nullptr);
+
+  envCache_ = std::move(block);
+  return *envCache_;
+}
 
-  for (const auto &[key, val] : currentMap) {
-    finalEnv.push_back(key + "=" + val);
+namespace {
+
+// Children inherit the affinity of the thread that spawns them, so the
+// spawning thread takes on the mask for the duration of the call
+class ScopedAffinity {
+public:
+  explicit ScopedAffinity(const std::vector<int> &cpus) {
+    if (cpus.empty() || pthread_getaffinity_np(pthread_self(), sizeof(saved_),
+                                               &saved_) != 0)
+      return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+      CPU_SET(cpu, &set);
+    active_ = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+  }
+  ~ScopedAffinity() {
+    if (active_)
+      pthread_setaffinity_np(pthread_self(), sizeof(saved_), &saved_);
   }
 
-  return finalEnv;
-}
+private:
+  cpu_set_t saved_;
+  bool active_ = false;
+};
 
-bool Prefix::runCommand(const std::string &exe,
-                        const std::vector<std::string> &args,
-                        std::function<void(const std::string &)> onOutput,
-                        const std::string &cwd, bool wait) {
-  std::vector<std::string> finalArgs;
-  finalArgs.push_back(exe);
-  finalArgs.insert(finalArgs.end(), args.begin(), args.end());
+} // namespace
 
+int Prefix::spawn(const std::string &exe, const std::vector<std::string> &args,
+                  const posix_spawn_file_actions_t *actions,
+                  pid_t &pid) const {
   std::vector<char *> argv;
-  for (const auto &s : finalArgs)
+  argv.push_back(const_cast<char *>(exe.c_str()));
+  for (const auto &s : args)
     argv.push_back(const_cast<char *>(s.c_str()));
   argv.push_back(nullptr);
 
-  int pipefd[2];
-  if (wait && onOutput) {
-    if (pipe(pipefd) == -1)
-      return false;
+  // Workers may run with signals blocked or ignored; the child starts clean
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t none, defaults;
+  sigemptyset(&none);
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGPIPE);
+  posix_spawnattr_setsigmask(&attr, &none);
+  posix_spawnattr_setsigdefault(&attr, &defaults);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK |
+                                      POSIX_SPAWN_SETSIGDEF);
+
+  int err;
+  {
+    ScopedAffinity affinity(cpuAffinity_);
+    err = posix_spawnp(&pid, exe.c_str(), actions, &attr, argv.data(),
+                       envBlock().envp.data());
   }
+  posix_spawnattr_destroy(&attr);
+  if (err != 0)
+    LOG_ERROR("Failed to exec " + exe + ": " + strerror(err));
+  return err;
+}
 
-  pid_t pid = fork();
-  if (pid == -1)
+bool Prefix::runCommand(const std::string &exe,
+                        const std::vector<std::string> &args,
+                        std::function<void(const std::string &)> onOutput,
+                        const std::string &cwd, bool wait) {
+  // Close-on-exec, so children spawned meanwhile by other threads do not
+  // hold the write end open
+  int pipefd[2] = {-1, -1};
+  bool capture = wait && onOutput;
+  if (capture && pipe2(pipefd, O_CLOEXEC) == -1)
     return false;
 
-  if (pid == 0) {
-    if (wait && onOutput) {
-      close(pipefd[0]);
-      dup2(pipefd[1], STDOUT_FILENO);
-      dup2(pipefd[1], STDERR_FILENO);
-      close(pipefd[1]);
-    } else if (!wait) {
-      // Redirect to /dev/null for detached processes to avoid hanging term
-      int devNull = open("/dev/null", O_RDWR);
-      if (devNull != -1) {
-        dup2(devNull, STDOUT_FILENO);
-        dup2(devNull, STDERR_FILENO);
-        close(devNull);
-      }
-    }
-
-    if (!cwd.empty()) {
-      if (chdir(cwd.c_str()) != 0) {
-        perror("chdir");
-      }
-    }
-
-    for (const auto &[key, val] : env_) {
-      setenv(key.c_str(), val.c_str(), 1);
-    }
-
-    if (!dir_.empty()) {
-      setenv("WINEPREFIX", dir_.c_str(), 1);
-    }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (capture) {
+    posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDERR_FILENO);
+  } else if (!wait) {
+    // Redirect to /dev/null for detached processes to avoid hanging term
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+  }
+  if (!cwd.empty())
+    posix_spawn_file_actions_addchdir_np(&actions, cwd.c_str());
 
-    execvp(exe.c_str(), argv.data());
+  pid_t pid = -1;
+  int err = spawn(exe, args, &actions, pid);
+  posix_spawn_file_actions_destroy(&actions);
+  if (capture)
+    close(pipefd[1]);
 
-    std::cerr << "Failed to exec: " << exe << "\n";
-    _exit(127);
+  if (err != 0) {
+    if (capture)
+      close(pipefd[0]);
+    return false;
   }
 
   if (wait) {
-    if (onOutput) {
-      close(pipefd[1]);
+    if (capture) {
       FILE *stream = fdopen(pipefd[0], "r");
       if (stream) {
         char buffer[1024];
@@ -185,12 +232,16 @@ bool Prefix::runCommand(const std::string &exe,
           onOutput(std::string(buffer));
         }
         fclose(stream);
+      } else {
+        close(pipefd[0]);
       }
-      close(pipefd[0]);
     }
 
     int status;
-    waitpid(pid, &status, 0);
+    while (waitpid(pid, &status, 0) == -1) {
+      if (errno != EINTR)
+        return false;
+    }
 
     if (WIFEXITED(status)) {
       int code = WEXITSTATUS(status);
@@ -206,13 +257,18 @@ bool Prefix::runCommand(const std::string &exe,
     return false;
   }
 
-  return true; // Successfully forked in detached mode
+  // Nobody else waits for it; a long-lived RSJFW would collect zombies
+  std::thread([pid]() {
+    int status;
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+    }
+  }).detach();
+  return true; // Successfully spawned in detached mode
 }
 
-bool Prefix::wine(const std::string &target,
-                  const std::vector<std::string> &args,
-                  std::function<void(const std::string &)> onOutput,
-                  const std::string &cwd, bool wait) {
+std::string Prefix::wineCommand(const std::string &target,
+                                const std::vector<std::string> &args,
+                                std::vector<std::string> &finalArgs) const {
   std::string wineBin = "wine64"; // Default to 64-bit
   bool protonMode = isProton();
 
@@ -222,16 +278,25 @@ bool Prefix::wine(const std::string &target,
     wineBin = bin("wine64");
   }
 
-  std::cerr << "[RSJFW-DEBUG] isProton: " << (protonMode ? "true" : "false")
-            << "\n";
-  std::cerr << "[RSJFW-DEBUG] Resolved wineBin: " << wineBin << "\n";
-
-  std::vector<std::string> finalArgs;
+  finalArgs.clear();
   if (protonMode) {
     finalArgs.push_back("run");
   }
   finalArgs.push_back(target);
   finalArgs.insert(finalArgs.end(), args.begin(), args.end());
+  return wineBin;
+}
+
+bool Prefix::wine(const std::string &target,
+                  const std::vector<std::string> &args,
+                  std::function<void(const std::string &)> onOutput,
+                  const std::string &cwd, bool wait) {
+  std::vector<std::string> finalArgs;
+  std::string wineBin = wineCommand(target, args, finalArgs);
+
+  std::cerr << "[RSJFW-DEBUG] isProton: " << (isProton() ? "true" : "false")
+            << "\n";
+  std::cerr << "[RSJFW-DEBUG] Resolved wineBin: " << wineBin << "\n";
 
   std::string fullCmd = wineBin;
   for (const auto &a : finalArgs)
@@ -241,6 +306,44 @@ bool Prefix::wine(const std::string &target,
   return runCommand(wineBin, finalArgs, onOutput, cwd, wait);
 }
 
+pid_t Prefix::winePiped(const std::string &target,
+                        const std::vector<std::string> &args, int &toChild,
+                        int &fromChild) {
+  std::vector<std::string> finalArgs;
+  std::string wineBin = wineCommand(target, args, finalArgs);
+
+  int in[2], out[2];
+  if (pipe2(in, O_CLOEXEC) == -1)
+    return -1;
+  if (pipe2(out, O_CLOEXEC) == -1) {
+    close(in[0]);
+    close(in[1]);
+    return -1;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+  // Wine's own chatter would only get in the way
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+
+  pid_t pid = -1;
+  int err = spawn(wineBin, finalArgs, &actions, pid);
+  posix_spawn_file_actions_destroy(&actions);
+  close(in[0]);
+  close(out[1]);
+  if (err != 0) {
+    close(in[1]);
+    close(out[0]);
+    return -1;
+  }
+  toChild = in[1];
+  fromChild = out[0];
+  return pid;
+}
+
 bool Prefix::registryAdd(const std::string &key, const std::string &valueName,
                          const std::string &value, const std::string &type) {
   std::vector<std::string> args = {"reg", "add", key, "/f"};
@@ -0,0 +1,281 @@
+#include "rsjfw/wine_helper.hpp"
+#include "rsjfw/logger.hpp"
+#include "rsjfw/path_manager.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace rsjfw {
+namespace wine {
+
+namespace {
+
+// The first reply waits for Wine itself, which may be booting the prefix
+constexpr int START_TIMEOUT_MS = 60000;
+constexpr int REQUEST_TIMEOUT_MS = 10000;
+constexpr const char *PROTOCOL = "rsjfw-helper 1";
+
+std::string escape(const std::string &field) {
+  std::string out;
+  out.reserve(field.size());
+  for (char c : field) {
+    switch (c) {
+    case '\t': out += "\\t"; break;
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\\': out += "\\\\"; break;
+    default: out += c; break;
+    }
+  }
+  return out;
+}
+
+std::string unescape(const std::string &field) {
+  std::string out;
+  out.reserve(field.size());
+  for (size_t i = 0; i < field.size(); ++i) {
+    if (field[i] != '\\' || i + 1 == field.size()) {
+      out += field[i];
+      continue;
+    }
+    char c = field[++i];
+    out += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+  }
+  return out;
+}
+
+// write() that reports a dead reader as EPIPE instead of dying of SIGPIPE
+bool writeAll(int fd, const std::string &data) {
+  sigset_t pipeSet, old;
+  sigemptyset(&pipeSet);
+  sigaddset(&pipeSet, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &pipeSet, &old);
+
+  bool ok = true;
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0) {
+      if (errno == EPIPE) {
+        // Consume the signal we caused before unblocking
+        struct timespec zero = {0, 0};
+        sigtimedwait(&pipeSet, nullptr, &zero);
+      }
+      ok = false;
+      break;
+    }
+    done += n;
+  }
+  pthread_sigmask(SIG_SETMASK, &old, nullptr);
+  return ok;
+}
+
+} // namespace
+
+HelperSession::HelperSession(Prefix &pfx) : pfx_(pfx) {}
+
+HelperSession::~HelperSession() { stop(); }
+
+bool HelperSession::available() {
+  if (failed_)
+    return false;
+  return started_ || start();
+}
+
+bool HelperSession::start() {
+  started_ = true;
+  std::filesystem::path exe = PathManager::instance().helperExe();
+  if (exe.empty()) {
+    failed_ = true; // Not installed; the Wine tools do the work
+    return false;
+  }
+
+  auto began = std::chrono::steady_clock::now();
+  pid_ = pfx_.winePiped(exe.string(), {}, toHelper_, fromHelper_);
+  if (pid_ < 0) {
+    fail("could not be started");
+    return false;
+  }
+
+  bool ok = false;
+  auto reply = call({"PING"}, ok);
+  if (!reply || !ok || reply->empty() || (*reply)[0] != PROTOCOL) {
+    fail("did not answer as " + std::string(PROTOCOL));
+    return false;
+  }
+  LOG_DEBUG("Wine helper ready in " +
+            std::to_string(std::chrono::duration_cast<
+                               std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - began)
+                               .count()) +
+            " ms");
+  return true;
+}
+
+void HelperSession::stop() {
+  if (toHelper_ >= 0) {
+    writeAll(toHelper_, "QUIT\n");
+    ::close(toHelper_);
+    toHelper_ = -1;
+  }
+  if (fromHelper_ >= 0) {
+    ::close(fromHelper_);
+    fromHelper_ = -1;
+  }
+  if (pid_ > 0) {
+    // The helper exits on QUIT or EOF; the wine launcher follows
+    int status;
+    for (int i = 0; i < 50; ++i) {
+      if (::waitpid(pid_, &status, WNOHANG) != 0) {
+        pid_ = -1;
+        return;
+      }
+      ::usleep(100 * 1000);
+    }
+    ::kill(pid_, SIGKILL);
+    ::waitpid(pid_, &status, 0);
+    pid_ = -1;
+  }
+}
+
+void HelperSession::fail(const std::string &why) {
+  LOG_WARN("Wine helper " + why + ", falling back to Wine tools");
+  failed_ = true;
+  stop();
+}
+
+bool HelperSession::readLine(std::string &line, int timeoutMs) {
+  line.clear();
+
+  for (;;) {
+    size_t nl = pending_.find('\n');
+    if (nl != std::string::npos) {
+      line = pending_.substr(0, nl);
+      pending_.erase(0, nl + 1);
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      return true;
+    }
+
+    struct pollfd pfd = {fromHelper_, POLLIN, 0};
+    int rc = ::poll(&pfd, 1, timeoutMs);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    if (rc <= 0)
+      return false; // Timed out
+    char buf[4096];
+    ssize_t n = ::read(fromHelper_, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false; // Helper gone
+    pending_.append(buf, n);
+  }
+}
+
+std::optional<std::vector<std::string>>
+HelperSession::call(const std::vector<std::string> &request, bool &ok) {
+  if (toHelper_ < 0 || fromHelper_ < 0)
+    return std::nullopt;
+
+  std::string line;
+  for (size_t i = 0; i < request.size(); ++i) {
+    if (i > 0)
+      line += '\t';
+    line += escape(request[i]);
+  }
+  line += '\n';
+  if (!writeAll(toHelper_, line)) {
+    fail("stopped reading requests");
+    return std::nullopt;
+  }
+
+  std::string replyLine;
+  int timeout = request[0] == "PING" ? START_TIMEOUT_MS : REQUEST_TIMEOUT_MS;
+  if (!readLine(replyLine, timeout)) {
+    fail("did not answer " + request[0]);
+    return std::nullopt;
+  }
+
+  std::vector<std::string> fields;
+  size_t pos = 0;
+  for (;;) {
+    size_t tab = replyLine.find('\t', pos);
+    fields.push_back(unescape(replyLine.substr(pos, tab - pos)));
+    if (tab == std::string::npos)
+      break;
+    pos = tab + 1;
+  }
+  ok = fields[0] == "OK";
+  if (!ok && fields[0] != "ERR") {
+    fail("sent garbage");
+    return std::nullopt;
+  }
+  fields.erase(fields.begin());
+  return fields;
+}
+
+std::optional<bool> HelperSession::regExists(const std::string &key,
+                                             const std::string &valueName) {
+  if (!available())
+    return std::nullopt;
+  bool ok = false;
+  auto reply = call({"REG_EXISTS", key, valueName}, ok);
+  if (!reply || !ok || reply->empty())
+    return std::nullopt;
+  return (*reply)[0] == "1";
+}
+
+std::optional<HelperSession::RegValue>
+HelperSession::regRead(const std::string &key, const std::string &valueName) {
+  if (!available())
+    return std::nullopt;
+  bool ok = false;
+  auto reply = call({"REG_READ", key, valueName}, ok);
+  if (!reply || !ok || reply->size() < 2)
+    return std::nullopt;
+  return RegValue{(*reply)[0], (*reply)[1]};
+}
+
+bool HelperSession::regWrite(const std::string &key,
+                             const std::string &valueName,
+                             const std::string &type,
+                             const std::string &value) {
+  if (!available())
+    return false;
+  bool ok = false;
+  auto reply = call({"REG_WRITE", key, valueName, type, value}, ok);
+  if (reply && !ok)
+    LOG_WARN("Wine helper could not write " + key + "\\" + valueName + ": " +
+             (reply->empty() ? std::string("?") : (*reply)[0]));
+  return reply && ok;
+}
+
+std::optional<bool> HelperSession::fileExists(const std::string &path) {
+  if (!available())
+    return std::nullopt;
+  bool ok = false;
+  auto reply = call({"FILE_EXISTS", path}, ok);
+  if (!reply || !ok || reply->empty())
+    return std::nullopt;
+  return (*reply)[0] == "1";
+}
+
+std::optional<std::string> HelperSession::env(const std::string &name) {
+  if (!available())
+    return std::nullopt;
+  bool ok = false;
+  auto reply = call({"ENV", name}, ok);
+  if (!reply || !ok || reply->empty())
+    return std::nullopt;
+  return (*reply)[0];
+}
+
+} // namespace wine
+} // namespace rsjfw
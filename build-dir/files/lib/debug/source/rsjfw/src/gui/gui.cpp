@@ -11,9 +11,11 @@
 #include "rsjfw/pages/SettingsPage.hpp"
 #include "rsjfw/pages/TroubleshootingPage.hpp"
 #include "rsjfw/path_manager.hpp"
+#include "rsjfw/standby.hpp"
 #include "rsjfw/task_runner.hpp"
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <filesystem>
@@ -27,6 +29,15 @@
 
 namespace rsjfw {
 
+namespace {
+// Upper bound on redraw rate while something is animating
+constexpr double FRAME_INTERVAL = 1.0 / 60.0;
+// How long an idle window may sleep before redrawing anyway
+constexpr double IDLE_TIMEOUT = 0.5;
+// Frames drawn after input so hover/active states settle
+constexpr int SETTLE_FRAMES = 2;
+} // namespace
+
 static bool configDirty = false;
 
 static void glfw_error_callback(int error, const char *description) {
@@ -75,6 +86,18 @@ bool loadTextureFromFile(const char *filename, GLuint *out_texture,
 
 bool GUI::init(int width, int height, const std::string &title,
                bool resizable) {
+  shouldClose_ = false;
+  closedByUser_ = false;
+
+  // Named tasks report progress into the task list
+  TaskRunner::instance().setProgressSink(
+      [this](const std::string &name, float progress,
+             const std::string &status) {
+        setTaskProgress(name, progress, status);
+      });
+  TaskRunner::instance().setFinishSink(
+      [this](const std::string &name) { finishTask(name); });
+
   glfwSetErrorCallback(glfw_error_callback);
   if (!glfwInit()) {
     LOG_ERROR("Failed to initialize GLFW");
@@ -191,7 +214,10 @@ bool GUI::init(int width, int height, const std::string &title,
   }
 
   window_ = window;
-  initialized_ = true;
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+    initialized_ = true;
+  }
 
   pages_.push(
       std::make_shared<HomePage>(this, logoTexture_, logoWidth_, logoHeight_));
@@ -224,8 +250,46 @@ void GUI::run(const std::function<void()> &renderCallback) {
   }
   */
 
+  double lastFrame = glfwGetTime();
+  int settleFrames = SETTLE_FRAMES;
+  nextFrameDelay_ = 0.0;
+
   while (!glfwWindowShouldClose(window) && !shouldClose_) {
-    glfwPollEvents();
+    double delay = nextFrameDelay_;
+    if (settleFrames > 0) {
+      settleFrames--;
+      delay = 0.0;
+    }
+    delay = std::max(delay, FRAME_INTERVAL);
+
+    double sinceLast = glfwGetTime() - lastFrame;
+    if (delay <= FRAME_INTERVAL) {
+      // Animating: hold the frame cap, then take whatever input is queued
+      if (sinceLast < FRAME_INTERVAL)
+        std::this_thread::sleep_for(
+            std::chrono::duration<double>(FRAME_INTERVAL - sinceLast));
+      glfwPollEvents();
+    } else if (sinceLast < delay) {
+      double timeout = delay - sinceLast;
+      double before = glfwGetTime();
+      glfwWaitEventsTimeout(timeout);
+      // Woken early means input or wake(); draw a few frames so it settles
+      if (glfwGetTime() - before < timeout - 0.001)
+        settleFrames = SETTLE_FRAMES;
+    } else {
+      glfwPollEvents();
+    }
+    if (shouldClose_)
+      break;
+
+    // A later `rsjfw config` asked for this window
+    if (Standby::instance().takeShowRequest()) {
+      glfwShowWindow(window);
+      glfwFocusWindow(window);
+    }
+
+    lastFrame = glfwGetTime();
+    nextFrameDelay_ = IDLE_TIMEOUT;
 
     if (mode_ == MODE_LAUNCHER) {
       int w, h;
@@ -324,8 +388,11 @@ void GUI::run(const std::function<void()> &renderCallback) {
       // Tweened progress (smooth interpolation)
       static float lerpedProgress = 0.0f;
       float targetProgress = progress_ >= 0.0f ? progress_ : 0.5f;
+      // Clamped: the first frame after an idle wait can be half a second
       lerpedProgress += (targetProgress - lerpedProgress) *
-                        ImGui::GetIO().DeltaTime * 8.0f; // Smooth lerp
+                        std::min(ImGui::GetIO().DeltaTime * 8.0f, 1.0f);
+      if (progress_ < 0.0f || std::fabs(targetProgress - lerpedProgress) > 0.001f)
+        requestFrame();
 
       // Bar 1: Main progress (full width, no padding)
       {
@@ -366,8 +433,11 @@ void GUI::run(const std::function<void()> &renderCallback) {
         static float lerpedTaskProgress = 0.0f;
         float taskTarget =
             firstTask.progress >= 0.0f ? firstTask.progress : 0.5f;
-        lerpedTaskProgress +=
-            (taskTarget - lerpedTaskProgress) * ImGui::GetIO().DeltaTime * 8.0f;
+        lerpedTaskProgress += (taskTarget - lerpedTaskProgress) *
+                              std::min(ImGui::GetIO().DeltaTime * 8.0f, 1.0f);
+        if (firstTask.progress < 0.0f ||
+            std::fabs(taskTarget - lerpedTaskProgress) > 0.001f)
+          requestFrame();
 
         ImVec2 barSize = ImVec2(display_w, barHeight);
         ImVec2 screenPos = ImGui::GetWindowPos();
@@ -436,6 +506,10 @@ void GUI::run(const std::function<void()> &renderCallback) {
       const float transitionSpeed = 3.0f; // Slower animation
       float dt = ImGui::GetIO().DeltaTime;
 
+      if (currentMainTab_ != targetMainTab_ ||
+          currentSettingsTab_ != targetSettingsTab_)
+        requestFrame();
+
       // Animate main tab transition
       if (currentMainTab_ != targetMainTab_) {
         mainTabTransition += dt * transitionSpeed;
@@ -550,13 +624,13 @@ void GUI::run(const std::function<void()> &renderCallback) {
         homePage->render();
       } else if (displayTab == 1) {
         // Settings with sidebar
-        const char *settingsItems[] = {"General", "Wine", "DXVK", "FFlags",
-                                       "Environment"};
+        const char *settingsItems[] = {"General", "Wine",        "DXVK",
+                                       "FFlags",  "Environment", "Performance"};
         float sidebarWidth = 120.0f;
 
         // Sidebar
         ImGui::BeginChild("SettingsSidebar", ImVec2(sidebarWidth, 0), true);
-        for (int i = 0; i < 5; i++) {
+        for (int i = 0; i < 6; i++) {
           bool selected = (targetSettingsTab_ == i); // Use member
           if (selected) {
             ImGui::PushStyleColor(ImGuiCol_Button,
@@ -581,7 +655,8 @@ void GUI::run(const std::function<void()> &renderCallback) {
           status_ = "Configuration saved.";
 
           auto &cfg = Config::instance();
-          auto &gen = cfg.getGeneral();
+          auto config = cfg.snapshot();
+          const auto &gen = config->general;
 
           // Only download Wine if source isn't SYSTEM/CUSTOM_PATH AND wineRoot
           // doesn't exist or is empty
@@ -600,25 +675,28 @@ void GUI::run(const std::function<void()> &renderCallback) {
               if (GUI::instance().hasTask(wineTask)) {
                 status_ = "Download already in progress: " + wineTask;
               } else {
-                TaskRunner::instance().run([=]() {
-                  Downloader dl(PathManager::instance().root().string());
-                  auto &configInst = Config::instance();
-                  std::string ver = configInst.getGeneral().wineSource.version;
-                  std::string repo = configInst.getGeneral().wineSource.repo;
-                  std::string asset = configInst.getGeneral().wineSource.asset;
-
-                  GUI::instance().setTaskProgress(wineTask, 0.05f,
-                                                  "Preparing...");
-                  bool res = dl.installWine(
-                      repo, ver, asset,
-                      [&](const std::string &item, float p, size_t, size_t) {
-                        GUI::instance().setTaskProgress(wineTask, p, item);
-                      });
-                  if (res)
-                    GUI::instance().removeTask(wineTask);
-                  else
-                    GUI::instance().setTaskProgress(wineTask, 1.0f, "Error");
-                });
+                // Listed now, so a second Save sees it before it starts
+                GUI::instance().setTaskProgress(wineTask, 0.0f, "Queued...");
+                TaskRunner::instance().run(
+                    [=]() {
+                      Downloader dl(PathManager::instance().root().string());
+                      auto configInst = Config::instance().snapshot();
+                      std::string ver = configInst->general.wineSource.version;
+                      std::string repo = configInst->general.wineSource.repo;
+                      std::string asset = configInst->general.wineSource.asset;
+
+                      TaskRunner::progress(0.05f, "Preparing...");
+                      bool res = dl.installWine(
+                          repo, ver, asset,
+                          [&](const std::string &item, float p, size_t,
+                              size_t) { TaskRunner::progress(p, item); });
+                      if (res)
+                        GUI::instance().removeTask(wineTask);
+                      else
+                        GUI::instance().setTaskProgress(wineTask, 1.0f,
+                                                        "Error");
+                    },
+                    TaskPriority::INTERACTIVE, wineTask);
               }
             }
           }
@@ -658,18 +736,20 @@ void GUI::run(const std::function<void()> &renderCallback) {
                     (isV2FromConfig || isV2FromRoot || isLatest)) {
                   status_ = "FUCK! Can't use DXVK 2.x with VK 1." +
                             std::to_string(minor) + " - switching to v1.10.3";
-                  cfg.getGeneral().dxvkSource.version = "v1.10.3";
-                  cfg.getGeneral().dxvkSource.repo = "doitsujin/dxvk";
-                  cfg.getGeneral().dxvkSource.installedRoot =
-                      ""; // Force re-download
-                  cfg.save();
+                  cfg.update([](ConfigSnapshot &next) {
+                    next.general.dxvkSource.version = "v1.10.3";
+                    next.general.dxvkSource.repo = "doitsujin/dxvk";
+                    next.general.dxvkSource.installedRoot =
+                        ""; // Force re-download
+                  });
                 }
               }
               pclose(vkPipe);
             }
 
             // Now check if download needed (re-read after possible change)
-            auto &genUpdated = cfg.getGeneral();
+            auto updated = cfg.snapshot();
+            const auto &genUpdated = updated->general;
             bool needsDownload =
                 genUpdated.dxvkSource.installedRoot.empty() ||
                 !std::filesystem::exists(genUpdated.dxvkSource.installedRoot) ||
@@ -683,25 +763,27 @@ void GUI::run(const std::function<void()> &renderCallback) {
               if (GUI::instance().hasTask(dxvkTask)) {
                 status_ = "Download already in progress: " + dxvkTask;
               } else {
-                TaskRunner::instance().run([=]() {
-                  Downloader dl(PathManager::instance().root().string());
-                  auto &configInst = Config::instance();
-                  std::string repo = configInst.getGeneral().dxvkSource.repo;
-                  std::string ver = configInst.getGeneral().dxvkSource.version;
-                  std::string asset = configInst.getGeneral().dxvkSource.asset;
-
-                  GUI::instance().setTaskProgress(dxvkTask, 0.05f,
-                                                  "Preparing...");
-                  bool res = dl.installDxvk(
-                      repo, ver, asset,
-                      [&](const std::string &item, float p, size_t, size_t) {
-                        GUI::instance().setTaskProgress(dxvkTask, p, item);
-                      });
-                  if (res)
-                    GUI::instance().removeTask(dxvkTask);
-                  else
-                    GUI::instance().setTaskProgress(dxvkTask, 1.0f, "Error");
-                });
+                GUI::instance().setTaskProgress(dxvkTask, 0.0f, "Queued...");
+                TaskRunner::instance().run(
+                    [=]() {
+                      Downloader dl(PathManager::instance().root().string());
+                      auto configInst = Config::instance().snapshot();
+                      std::string repo = configInst->general.dxvkSource.repo;
+                      std::string ver = configInst->general.dxvkSource.version;
+                      std::string asset = configInst->general.dxvkSource.asset;
+
+                      TaskRunner::progress(0.05f, "Preparing...");
+                      bool res = dl.installDxvk(
+                          repo, ver, asset,
+                          [&](const std::string &item, float p, size_t,
+                              size_t) { TaskRunner::progress(p, item); });
+                      if (res)
+                        GUI::instance().removeTask(dxvkTask);
+                      else
+                        GUI::instance().setTaskProgress(dxvkTask, 1.0f,
+                                                        "Error");
+                    },
+                    TaskPriority::INTERACTIVE, dxvkTask);
               }
             }
           }
@@ -752,6 +834,8 @@ void GUI::run(const std::function<void()> &renderCallback) {
           settingsPage->renderFFlagsTab();
         else if (displaySubTab == 4)
           settingsPage->renderEnvTab();
+        else if (displaySubTab == 5)
+          settingsPage->renderPerformanceTab();
 
         ImGui::PopStyleVar();
 
@@ -767,6 +851,7 @@ void GUI::run(const std::function<void()> &renderCallback) {
 
               if (task.second.progress < 0.0f) {
                 // Indeterminate Pulse
+                requestFrame();
                 float t = (float)ImGui::GetTime();
                 float width = ImGui::GetContentRegionAvail().x;
                 float height = 20.0f;
@@ -866,11 +951,13 @@ void GUI::run(const std::function<void()> &renderCallback) {
                   if (GUI::instance().hasTask(taskName)) {
                     // Do nothing, task is already running
                   } else {
-                    TaskRunner::instance().run([=]() {
-                      action([](float p, std::string s) {
-                        GUI::instance().updateFixProgress(p, s);
-                      });
-                    });
+                    TaskRunner::instance().run(
+                        [=]() {
+                          action([](float p, std::string s) {
+                            GUI::instance().updateFixProgress(p, s);
+                          });
+                        },
+                        TaskPriority::INTERACTIVE, taskName);
                   }
                 }
               }
@@ -998,6 +1085,10 @@ void GUI::run(const std::function<void()> &renderCallback) {
     if (renderCallback)
       renderCallback();
 
+    // Keep the text caret blinking while a field has focus
+    if (ImGui::GetIO().WantTextInput)
+      requestFrame(0.1);
+
     ImGui::End();
     ImGui::PopStyleVar();
 
@@ -1010,6 +1101,7 @@ void GUI::run(const std::function<void()> &renderCallback) {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     glfwSwapBuffers(window);
   }
+  closedByUser_ = !shouldClose_ && glfwWindowShouldClose(window);
 }
 
 void GUI::showHealthWarning(
@@ -1017,6 +1109,7 @@ void GUI::showHealthWarning(
   std::lock_guard<std::mutex> lock(mutex_);
   healthFailures_ = failures;
   showHealthModal_ = true;
+  wake();
 }
 
 void GUI::navigateToTroubleshooting() {
@@ -1053,6 +1146,7 @@ bool GUI::shouldFlash(const std::string &id) {
   if (flashWidgetId_ != id)
     return false;
 
+  requestFrame();
   float dt = ImGui::GetIO().DeltaTime;
   flashTimer_ += dt * 10.0f; // Speed
 
@@ -1074,30 +1168,61 @@ void GUI::showMessage(const std::string &title, const std::string &message) {
   messageTitle_ = title;
   messageText_ = message;
   showMessageModal_ = true;
+  wake();
 }
 
 void GUI::updateFixProgress(float progress, const std::string &status) {
   std::lock_guard<std::mutex> lock(mutex_);
   fixProgress_ = progress;
   fixStatus_ = status;
+  wake();
 }
 
 void GUI::setProgress(float progress, const std::string &status) {
   std::lock_guard<std::mutex> lock(mutex_);
   progress_ = progress;
   status_ = status;
+  wake();
 }
 
 void GUI::setError(const std::string &errorMsg) {
   std::lock_guard<std::mutex> lock(mutex_);
   error_ = errorMsg;
+  wake();
 }
 
-void GUI::close() { shouldClose_ = true; }
+void GUI::close() {
+  shouldClose_ = true;
+  wake();
+}
+
+void GUI::wake() {
+  // glfwPostEmptyEvent is thread-safe, but only valid between init and
+  // terminate
+  std::lock_guard<std::mutex> lock(wakeMutex_);
+  if (initialized_)
+    glfwPostEmptyEvent();
+}
+
+void GUI::requestFrame(double delay) {
+  nextFrameDelay_ = std::min(nextFrameDelay_, std::max(delay, 0.0));
+}
 
 void GUI::shutdown() {
-  if (!initialized_)
-    return;
+  // Cleared first so wake() from a worker stops posting events; the lock
+  // waits out one that is posting right now
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+    if (!initialized_.exchange(false))
+      return;
+  }
+
+  if (logoTexture_) {
+    glDeleteTextures(1, (GLuint *)&logoTexture_);
+    logoTexture_ = 0;
+  }
+  // Pages hold the texture id
+  pages_ = PageStack();
 
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
@@ -1108,7 +1233,6 @@ void GUI::shutdown() {
     window_ = nullptr;
   }
   glfwTerminate();
-  initialized_ = false;
 }
 
 GUI::~GUI() { shutdown(); }
@@ -1129,6 +1253,7 @@ void GUI::setTaskProgress(const std::string &name, float progress,
     tasks_[idx].second = {progress, status};
   else
     tasks_.push_back({name, {progress, status}});
+  wake();
 }
 
 void GUI::removeTask(const std::string &name) {
@@ -1136,11 +1261,22 @@ void GUI::removeTask(const std::string &name) {
   int idx = findTask(tasks_, name);
   if (idx >= 0)
     tasks_.erase(tasks_.begin() + idx);
+  wake();
+}
+
+void GUI::finishTask(const std::string &name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int idx = findTask(tasks_, name);
+  // Failures stay listed until the next attempt
+  if (idx >= 0 && tasks_[idx].second.status != "Error")
+    tasks_.erase(tasks_.begin() + idx);
+  wake();
 }
 
 bool GUI::hasTask(const std::string &name) {
   std::lock_guard<std::mutex> lock(mutex_);
-  return findTask(tasks_, name) >= 0;
+  int idx = findTask(tasks_, name);
+  return idx >= 0 && tasks_[idx].second.status != "Error";
 }
 
 void GUI::setSubProgress(float progress, const std::string &status) {
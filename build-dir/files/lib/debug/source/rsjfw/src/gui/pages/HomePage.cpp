@@ -34,6 +34,9 @@ static bool isStudioRunning() {
 
 static bool studioRunning = false;
 static float lastCheckTime = -10.0f; // Force immediate check
+// The launch button's hover state from the last frame; it is only known
+// once the button is submitted, after its color is chosen
+static bool launchHovered = false;
 
 HomePage::HomePage(GUI *gui, GLuint logoTexture, int logoWidth, int logoHeight)
     : gui_(gui), logoTexture_(logoTexture), logoWidth_(logoWidth),
@@ -69,8 +72,15 @@ void HomePage::render() {
 
   ImGui::SetCursorPosX(startX);
 
+  // The pulse only runs while the launch button is hovered, so an idle
+  // window stays idle; it is subtle, 30 fps is plenty
+  bool pulsing = !studioRunning && launchHovered;
+  if (pulsing)
+    gui_->requestFrame(1.0 / 30.0);
+
   static float pulseTime = 0.0f;
-  pulseTime += ImGui::GetIO().DeltaTime;
+  if (pulsing)
+    pulseTime += ImGui::GetIO().DeltaTime;
   float pulse = (sinf(pulseTime * 2.0f) + 1.0f) * 0.05f;
 
   if (studioRunning) {
@@ -120,6 +130,10 @@ void HomePage::render() {
     if (ImGui::Button("LAUNCH STUDIO", ImVec2(buttonWidth, 40))) {
       ImGui::OpenPopup("Launching Studio");
     }
+    if (ImGui::IsItemHovered() != launchHovered) {
+      launchHovered = !launchHovered;
+      gui_->requestFrame();
+    }
     ImGui::PopStyleColor();
   }
 
@@ -180,7 +194,8 @@ void HomePage::render() {
     ImGui::PopStyleColor();
   }
 
-  auto &cfg = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &cfg = config->general;
 
   std::string wineSourceStr = cfg.wineSource.repo;
   if (cfg.wineSource.repo == "CUSTOM_PATH")
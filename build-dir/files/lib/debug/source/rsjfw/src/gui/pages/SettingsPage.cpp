@@ -4,8 +4,17 @@
 #include "rsjfw/downloader.hpp"
 #include "rsjfw/gui.hpp"
 #include "rsjfw/launcher.hpp"
+#include "rsjfw/log_retention.hpp"
+#include "rsjfw/logger.hpp"
 #include "rsjfw/path_manager.hpp"
+#include "rsjfw/performance.hpp"
+#include "rsjfw/release_cache.hpp"
+#include "rsjfw/root_inventory.hpp"
+#include "rsjfw/shader_cache.hpp"
 #include "rsjfw/task_runner.hpp"
+#include "rsjfw/updater.hpp"
+#include "rsjfw/version_gc.hpp"
+#include <algorithm>
 #include <cstring>
 #include <thread>
 
@@ -53,9 +62,6 @@ static std::string pickDirectory(const std::string &title) {
 SettingsPage::SettingsPage(GUI *gui) : gui_(gui) {}
 
 void SettingsPage::render() {
-  auto &cfg = Config::instance();
-  auto &gen = cfg.getGeneral();
-
   ensureVersions();
 
   if (ImGui::BeginTabBar("ConfigTabs")) {
@@ -79,42 +85,55 @@ void SettingsPage::render() {
       renderEnvTab();
       ImGui::EndTabItem();
     }
+    if (ImGui::BeginTabItem("Performance")) {
+      renderPerformanceTab();
+      ImGui::EndTabItem();
+    }
     ImGui::EndTabBar();
   }
 }
 
 void SettingsPage::renderGeneralTab() {
   auto &cfg = Config::instance();
-  auto &gen = cfg.getGeneral();
+  auto config = cfg.snapshot();
+  GeneralConfig gen = config->general;
   bool changed = false;
 
   ImGui::Spacing();
   const char *renderers[] = {"D3D11", "Vulkan", "OpenGL", "D3D11FL10"};
   static int currentRendererIdx = 0;
-  std::string currentRenderer = cfg.getGeneral().renderer;
+  std::string currentRenderer = gen.renderer;
   for (int i = 0; i < 4; i++)
     if (currentRenderer == renderers[i])
       currentRendererIdx = i;
 
   if (ImGui::Combo("Renderer", &currentRendererIdx, renderers, 4)) {
-    cfg.getGeneral().renderer = renderers[currentRendererIdx];
+    gen.renderer = renderers[currentRendererIdx];
     changed = true;
   }
 
+  if (ImGui::Checkbox("Stay in Background While Studio Runs", &gen.standby))
+    cfg.update([&](ConfigSnapshot &next) {
+      next.general.standby = gen.standby;
+    });
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Closing this window frees its memory for Studio. Run "
+                      "rsjfw again to bring it back.");
+
   ImGui::Separator();
   ImGui::Text("Versioning");
 
   char verBuf[64];
-  strncpy(verBuf, cfg.getGeneral().robloxVersion.c_str(), sizeof(verBuf));
+  strncpy(verBuf, gen.robloxVersion.c_str(), sizeof(verBuf));
   if (ImGui::InputText("Roblox Version Override", verBuf, sizeof(verBuf))) {
-    cfg.getGeneral().robloxVersion = std::string(verBuf);
+    gen.robloxVersion = std::string(verBuf);
     changed = true;
   }
 
   const char *channels[] = {"LIVE", "production", "zcanary", "zintegration",
                             "Custom"};
   static int currentChannelIdx = 0;
-  std::string curChan = cfg.getGeneral().channel;
+  std::string curChan = gen.channel;
   bool customChannel = true;
   for (int i = 0; i < 4; i++)
     if (curChan == channels[i]) {
@@ -127,22 +146,92 @@ void SettingsPage::renderGeneralTab() {
 
   if (ImGui::Combo("Channel", &currentChannelIdx, channels, 5)) {
     if (currentChannelIdx < 4) {
-      cfg.getGeneral().channel = channels[currentChannelIdx];
+      gen.channel = channels[currentChannelIdx];
       changed = true;
     }
   }
 
   if (currentChannelIdx == 4) {
     char chanBuf[64];
-    strncpy(chanBuf, cfg.getGeneral().channel.c_str(), sizeof(chanBuf));
+    strncpy(chanBuf, gen.channel.c_str(), sizeof(chanBuf));
     if (ImGui::InputText("Custom Channel", chanBuf, sizeof(chanBuf))) {
-      cfg.getGeneral().channel = std::string(chanBuf);
+      gen.channel = std::string(chanBuf);
       changed = true;
     }
   }
 
+  ImGui::Spacing();
+  ImGui::Separator();
+  ImGui::Text("Logs");
+  ImGui::Spacing();
+
+  LogsConfig logs = config->logs;
+  bool logsChanged = false;
+  logsChanged |= ImGui::SliderInt("Rotate At (MB)", &logs.rotateMB, 0, 512);
+  logsChanged |= ImGui::SliderInt("Keep For (days)", &logs.maxAgeDays, 0, 365);
+  logsChanged |= ImGui::SliderInt("Total Cap (MB)", &logs.maxTotalMB, 0, 8192);
+  logsChanged |= ImGui::Checkbox("Compress Old Logs", &logs.compress);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Closed logs are moved to logs/old as zstd archives. "
+                      "0 disables a limit.");
+  if (logsChanged) {
+    Logger::instance().setRotateBytes((uint64_t)std::max(logs.rotateMB, 0)
+                                      << 20);
+    cfg.update([&](ConfigSnapshot &next) { next.logs = logs; });
+  }
+  if (ImGui::Button("Clean Up Logs Now"))
+    LogRetention::instance().schedule();
+
+  ImGui::Spacing();
+  ImGui::Separator();
+  ImGui::Text("Studio Versions");
+  ImGui::Spacing();
+
+  VersionsConfig versions = config->versions;
+  bool versionsChanged = false;
+  versionsChanged |= ImGui::SliderInt("Keep Versions", &versions.keep, 1, 10);
+  versionsChanged |=
+      ImGui::Checkbox("Remove Old Versions After Launch", &versions.autoClean);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Once the newest version has started, older ones beyond "
+                      "the limit are deleted. Pinned versions and the version "
+                      "override are kept.");
+  versionsChanged |=
+      ImGui::Checkbox("Download Updates in Background", &versions.prefetch);
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("New Studio versions are fetched while RSJFW or Studio "
+                      "runs, so the next launch starts at once. Paused on "
+                      "metered connections.");
+  if (versions.prefetch)
+    versionsChanged |= ImGui::SliderInt(
+        "Download Limit (KB/s)", &versions.prefetchLimitKBps, 0, 65536);
+  if (versionsChanged)
+    cfg.update([&](ConfigSnapshot &next) {
+      next.versions.keep = versions.keep;
+      next.versions.autoClean = versions.autoClean;
+      next.versions.prefetch = versions.prefetch;
+      next.versions.prefetchLimitKBps = versions.prefetchLimitKBps;
+    });
+  if (Updater::instance().installing()) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("Downloading update...");
+  }
+  ImGui::BeginDisabled(VersionGC::instance().running());
+  if (ImGui::Button("Clean Up Versions Now"))
+    VersionGC::instance().schedule();
+  ImGui::EndDisabled();
+  if (uint64_t reclaimed = VersionGC::instance().lastReclaimed()) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("Reclaimed %llu MB",
+                        (unsigned long long)(reclaimed >> 20));
+  }
+
   if (changed) {
-    cfg.save();
+    cfg.update([&](ConfigSnapshot &next) {
+      next.general.renderer = gen.renderer;
+      next.general.robloxVersion = gen.robloxVersion;
+      next.general.channel = gen.channel;
+    });
     Diagnostics::instance().runChecks();
   }
 }
@@ -173,7 +262,7 @@ static bool gpusDetected = false;
 
 void SettingsPage::renderDxvkTab() {
   auto &cfg = Config::instance();
-  auto &gen = cfg.getGeneral();
+  GeneralConfig gen = cfg.snapshot()->general;
   bool changed = false;
 
   ImGui::Spacing();
@@ -232,11 +321,14 @@ void SettingsPage::renderDxvkTab() {
     std::string activeRepo = (gen.dxvkSource.repo == "CUSTOM")
                                  ? gen.dxvkCustomUrl
                                  : gen.dxvkSource.repo;
+    bool loadOlder = false;
     if (activeRepo.find('/') != std::string::npos &&
         activeRepo.find("://") == std::string::npos) {
-      if (fetching_.count(activeRepo)) {
-        ImGui::TextDisabled("Fetching versions...");
-      } else if (releaseCache_.count(activeRepo)) {
+      std::lock_guard<std::mutex> releaseLock(releaseMutex_);
+      if (!releaseCache_.count(activeRepo)) {
+        if (fetching_.count(activeRepo))
+          ImGui::TextDisabled("Fetching versions...");
+      } else {
         auto &releases = releaseCache_[activeRepo];
         std::vector<const char *> verItems;
         int currentVerIdx = -1;
@@ -252,6 +344,10 @@ void SettingsPage::renderDxvkTab() {
           gen.dxvkSource.installedRoot = ""; // Clear on version change
           changed = true;
         }
+        if (moreReleases_.count(activeRepo) && !fetching_.count(activeRepo)) {
+          ImGui::SameLine();
+          loadOlder = ImGui::SmallButton("Older...##dxvk");
+        }
 
         // Asset Dropdown (Optional)
         if (currentVerIdx != -1) {
@@ -272,6 +368,26 @@ void SettingsPage::renderDxvkTab() {
         }
       }
     }
+    if (loadOlder)
+      loadOlderVersions(activeRepo);
+
+    ImGui::Spacing();
+    bool warmup = gen.shaderWarmup;
+    if (ImGui::Checkbox("Shader Warm-up After Updates", &warmup)) {
+      gen.shaderWarmup = warmup;
+      changed = true;
+    }
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Records pipelines with the Fossilize layer and "
+                        "replays them into the driver cache after each "
+                        "Studio install, before the first launch.");
+    static auto warmupSupport = ShaderCache::instance().warmupSupport();
+    ImGui::TextDisabled("Recorder (VK_LAYER_fossilize): %s",
+                        warmupSupport.recorder ? "found" : "not found");
+    ImGui::TextDisabled("Replayer (fossilize-replay): %s",
+                        warmupSupport.replayer.empty()
+                            ? "not found"
+                            : warmupSupport.replayer.c_str());
 
     ImGui::Spacing();
     ImGui::Text("Installed DXVK Versions");
@@ -309,14 +425,22 @@ void SettingsPage::renderDxvkTab() {
   }
 
   if (changed) {
-    cfg.save();
+    cfg.update([&](ConfigSnapshot &next) {
+      next.general.dxvk = gen.dxvk;
+      next.general.dxvkSource = gen.dxvkSource;
+      next.general.dxvkCustomUrl = gen.dxvkCustomUrl;
+      next.general.shaderWarmup = gen.shaderWarmup;
+      next.general.selectedGpu = gen.selectedGpu;
+    });
     Diagnostics::instance().runChecks();
   }
 }
 
 void SettingsPage::renderWineTab() {
   auto &cfg = Config::instance();
-  auto &gen = cfg.getGeneral();
+  auto config = cfg.snapshot();
+  GeneralConfig gen = config->general;
+  WineConfig wine = config->wine;
   bool changed = false;
 
   ImGui::Spacing();
@@ -372,11 +496,14 @@ void SettingsPage::renderWineTab() {
   std::string activeRepo = (gen.wineSource.repo == "CUSTOM")
                                ? gen.wineCustomUrl
                                : gen.wineSource.repo;
+  bool loadOlder = false;
   if (activeRepo.find('/') != std::string::npos &&
       activeRepo.find("://") == std::string::npos && activeRepo != "SYSTEM") {
-    if (fetching_.count(activeRepo)) {
-      ImGui::TextDisabled("Fetching versions...");
-    } else if (releaseCache_.count(activeRepo)) {
+    std::lock_guard<std::mutex> releaseLock(releaseMutex_);
+    if (!releaseCache_.count(activeRepo)) {
+      if (fetching_.count(activeRepo))
+        ImGui::TextDisabled("Fetching versions...");
+    } else {
       auto &releases = releaseCache_[activeRepo];
 
       // Version Dropdown
@@ -394,6 +521,10 @@ void SettingsPage::renderWineTab() {
         gen.wineSource.installedRoot = ""; // Clear on version change
         changed = true;
       }
+      if (moreReleases_.count(activeRepo) && !fetching_.count(activeRepo)) {
+        ImGui::SameLine();
+        loadOlder = ImGui::SmallButton("Older...##wine");
+      }
 
       // Asset Dropdown (Conditional)
       if (currentVerIdx != -1) {
@@ -414,20 +545,22 @@ void SettingsPage::renderWineTab() {
       }
     }
   }
+  if (loadOlder)
+    loadOlderVersions(activeRepo);
 
   ImGui::Spacing();
   ImGui::Separator();
   ImGui::Text("Wine Options");
 
-  bool desktopMode = cfg.getWine().desktopMode;
+  bool desktopMode = wine.desktopMode;
   if (ImGui::Checkbox("Desktop Mode", &desktopMode)) {
-    cfg.getWine().desktopMode = desktopMode;
+    wine.desktopMode = desktopMode;
     changed = true;
   }
   ImGui::SameLine();
-  bool multiDesktop = cfg.getWine().multipleDesktops;
+  bool multiDesktop = wine.multipleDesktops;
   if (ImGui::Checkbox("Multi-Desktop", &multiDesktop)) {
-    cfg.getWine().multipleDesktops = multiDesktop;
+    wine.multipleDesktops = multiDesktop;
     changed = true;
   }
 
@@ -436,18 +569,28 @@ void SettingsPage::renderWineTab() {
   renderInstalledRoots(true);
 
   if (changed) {
-    cfg.save();
+    cfg.update([&](ConfigSnapshot &next) {
+      next.general.wineSource = gen.wineSource;
+      next.general.wineCustomUrl = gen.wineCustomUrl;
+      next.wine = wine;
+    });
     Diagnostics::instance().runChecks();
   }
 }
 
 void SettingsPage::renderInstalledRoots(bool wine) {
   auto &cfg = Config::instance();
-  auto &gen = cfg.getGeneral();
+  GeneralConfig gen = cfg.snapshot()->general;
   bool changed = false;
-  Downloader dl(PathManager::instance().root().string());
-  auto roots = wine ? dl.getInstalledWineRoots() : dl.getInstalledDxvkRoots();
+  auto &inventory = RootInventory::instance();
+  inventory.start([]() { GUI::instance().wake(); });
+  auto installed = inventory.snapshot();
+  const auto &roots = wine ? installed->wine : installed->dxvk;
 
+  if (!installed->ready) {
+    ImGui::TextDisabled("Looking for installed versions...");
+    return;
+  }
   if (roots.empty()) {
     ImGui::TextDisabled("No installed versions found.");
     return;
@@ -456,8 +599,12 @@ void SettingsPage::renderInstalledRoots(bool wine) {
   if (ImGui::BeginChild(wine ? "WineRoots" : "DxvkRoots", ImVec2(0, 150),
                         true)) {
     for (const auto &root : roots) {
-      float sizeMB = root.sizeBytes / (1024.0f * 1024.0f);
-      ImGui::Text("%s (%.1f MB)", root.name.c_str(), sizeMB);
+      if (root.sizeKnown) {
+        float sizeMB = root.sizeBytes / (1024.0f * 1024.0f);
+        ImGui::Text("%s (%.1f MB)", root.name.c_str(), sizeMB);
+      } else {
+        ImGui::Text("%s (measuring...)", root.name.c_str());
+      }
       if (root.isProton) {
         ImGui::SameLine();
         ImGui::TextColored(ImVec4(0.4f, 0.7f, 1.0f, 1.0f), "[Proton]");
@@ -486,6 +633,7 @@ void SettingsPage::renderInstalledRoots(bool wine) {
       }
       ImGui::SameLine(ImGui::GetContentRegionAvail().x - 50);
       if (ImGui::Button(("Delete##" + root.path).c_str())) {
+        Downloader dl(PathManager::instance().root().string());
         dl.deleteRoot(root.path);
       }
     }
@@ -493,13 +641,19 @@ void SettingsPage::renderInstalledRoots(bool wine) {
   ImGui::EndChild();
 
   if (changed) {
-    cfg.save();
+    cfg.update([&](ConfigSnapshot &next) {
+      if (wine)
+        next.general.wineSource = gen.wineSource;
+      else
+        next.general.dxvkSource = gen.dxvkSource;
+    });
     Diagnostics::instance().runChecks();
   }
 }
 
 void SettingsPage::renderFFlagsTab() {
   auto &cfg = Config::instance();
+  auto flags = cfg.snapshot()->fflags;
   bool changed = false;
 
   ImGui::Spacing();
@@ -513,9 +667,9 @@ void SettingsPage::renderFFlagsTab() {
 
   // FPS Limit
   int currentFps = 60;
-  if (cfg.getFFlags().contains("DFIntTaskSchedulerTargetFps")) {
+  if (flags.contains("DFIntTaskSchedulerTargetFps")) {
     try {
-      currentFps = cfg.getFFlags()["DFIntTaskSchedulerTargetFps"].get<int>();
+      currentFps = flags["DFIntTaskSchedulerTargetFps"].get<int>();
     } catch (...) {
     }
   }
@@ -526,31 +680,31 @@ void SettingsPage::renderFFlagsTab() {
   if (ImGui::SliderInt("FPS Limit", &sliderFps, 30, 241,
                        (sliderFps > 240 ? "Unlock" : "%d"))) {
     if (sliderFps > 240)
-      cfg.getFFlags()["DFIntTaskSchedulerTargetFps"] = 9999;
+      flags["DFIntTaskSchedulerTargetFps"] = 9999;
     else
-      cfg.getFFlags()["DFIntTaskSchedulerTargetFps"] = sliderFps;
+      flags["DFIntTaskSchedulerTargetFps"] = sliderFps;
     changed = true;
   }
 
   // DPI Scaling
   bool disableDpi = false;
-  if (cfg.getFFlags().contains("DFFlagDisableDPIScale")) {
+  if (flags.contains("DFFlagDisableDPIScale")) {
     try {
-      disableDpi = cfg.getFFlags()["DFFlagDisableDPIScale"].get<bool>();
+      disableDpi = flags["DFFlagDisableDPIScale"].get<bool>();
     } catch (...) {
     }
   }
   if (ImGui::Checkbox("Disable DPI Scaling", &disableDpi)) {
-    cfg.getFFlags()["DFFlagDisableDPIScale"] = disableDpi;
+    flags["DFFlagDisableDPIScale"] = disableDpi;
     changed = true;
   }
 
   // Lighting Technology
   bool future = false;
-  if (cfg.getFFlags().contains("FFlagDebugForceFutureIsBrightPhase3")) {
+  if (flags.contains("FFlagDebugForceFutureIsBrightPhase3")) {
     try {
       future =
-          cfg.getFFlags()["FFlagDebugForceFutureIsBrightPhase3"].get<bool>();
+          flags["FFlagDebugForceFutureIsBrightPhase3"].get<bool>();
     } catch (...) {
     }
   }
@@ -559,9 +713,9 @@ void SettingsPage::renderFFlagsTab() {
   const char *lightModes[] = {"Default (ShadowMap)", "Future"};
   if (ImGui::Combo("Lighting Technology", &lightMode, lightModes, 2)) {
     if (lightMode == 1)
-      cfg.getFFlags()["FFlagDebugForceFutureIsBrightPhase3"] = true;
+      flags["FFlagDebugForceFutureIsBrightPhase3"] = true;
     else
-      cfg.getFFlags().erase("FFlagDebugForceFutureIsBrightPhase3");
+      flags.erase("FFlagDebugForceFutureIsBrightPhase3");
     changed = true;
   }
 
@@ -613,7 +767,7 @@ void SettingsPage::renderFFlagsTab() {
         else
           val = sVal;
 
-        cfg.getFFlags()[newFlagName] = val;
+        flags[newFlagName] = val;
         changed = true;
         newFlagName[0] = '\0';
         newFlagValue[0] = '\0';
@@ -639,7 +793,6 @@ void SettingsPage::renderFFlagsTab() {
       ImGui::TableHeadersRow();
 
       std::string toRemove = "";
-      auto &flags = cfg.getFFlags();
       for (auto &[key, val] : flags) {
         ImGui::TableNextRow();
         ImGui::TableSetColumnIndex(0);
@@ -689,12 +842,12 @@ void SettingsPage::renderFFlagsTab() {
   }
 
   if (changed)
-    cfg.save();
+    cfg.update([&](ConfigSnapshot &next) { next.fflags = flags; });
 }
 
 void SettingsPage::renderEnvTab() {
   auto &cfg = Config::instance();
-  auto &env = cfg.getGeneral().customEnv;
+  auto env = cfg.snapshot()->general.customEnv;
   bool changed = false;
 
   ImGui::Spacing();
@@ -898,13 +1051,117 @@ void SettingsPage::renderEnvTab() {
   }
 
   if (changed)
-    cfg.save();
+    cfg.update([&](ConfigSnapshot &next) { next.general.customEnv = env; });
+}
+
+void SettingsPage::renderPerformanceTab() {
+  auto &cfg = Config::instance();
+  auto config = cfg.snapshot();
+  PerformanceConfig perf = config->performance;
+  const auto &caps = Performance::instance().capabilities();
+  bool changed = false;
+
+  auto capability = [](const char *label, bool ok, const char *detail) {
+    ImGui::TextColored(ok ? ImVec4(0.3f, 0.9f, 0.3f, 1.0f)
+                          : ImVec4(0.6f, 0.6f, 0.6f, 1.0f),
+                       "%s %s", ok ? "[x]" : "[ ]", label);
+    if (detail && *detail) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("%s", detail);
+    }
+  };
+
+  ImGui::Spacing();
+  ImGui::Text("Detected Capabilities");
+  ImGui::Separator();
+  capability("ntsync", caps.ntsync, "/dev/ntsync");
+  capability("fsync", caps.fsync, "futex_waitv");
+  capability("Gamemode", !caps.gamemodeLib.empty(), caps.gamemodeLib.c_str());
+  ImGui::TextDisabled("%d CPUs, kernel %s", caps.cpuCount, caps.kernel.c_str());
+
+  ImGui::Spacing();
+  ImGui::Text("Options");
+  ImGui::Separator();
+
+  const char *syncModes[] = {"auto", "ntsync", "fsync", "esync", "none"};
+  const char *syncLabels[] = {"Auto (best supported)", "ntsync", "fsync",
+                              "esync", "None"};
+  int syncIdx = 0;
+  for (int i = 0; i < 5; i++)
+    if (perf.syncMode == syncModes[i])
+      syncIdx = i;
+  if (ImGui::Combo("Sync Primitive", &syncIdx, syncLabels, 5)) {
+    perf.syncMode = syncModes[syncIdx];
+    changed = true;
+  }
+
+  // Probing reads the build's ntdll, so only redo it when the root changes
+  static std::string probedRoot = "\x01";
+  static std::string syncSummary;
+  const auto &gen = config->general;
+  if (probedRoot != gen.wineSource.installedRoot || changed) {
+    probedRoot = gen.wineSource.installedRoot;
+    std::string reason;
+    std::string chosen = Performance::instance().selectSync(
+        probedRoot, PathManager::instance().prefix().string(), &reason);
+    syncSummary = "Will use " + chosen + " (" + reason + ")";
+  }
+  ImGui::TextDisabled("%s", syncSummary.c_str());
+
+  ImGui::BeginDisabled(caps.gamemodeLib.empty());
+  bool gamemode = perf.gamemode;
+  if (ImGui::Checkbox("Request Gamemode", &gamemode)) {
+    perf.gamemode = gamemode;
+    changed = true;
+  }
+  ImGui::EndDisabled();
+
+  char cpuBuf[64];
+  strncpy(cpuBuf, perf.studioCpus.c_str(), sizeof(cpuBuf) - 1);
+  cpuBuf[sizeof(cpuBuf) - 1] = '\0';
+  if (ImGui::InputTextWithHint("Studio CPUs", "all (e.g. 0-7)", cpuBuf,
+                               sizeof(cpuBuf))) {
+    perf.studioCpus = cpuBuf;
+    changed = true;
+  }
+  if (!perf.studioCpus.empty() &&
+      !Performance::parseCpuList(perf.studioCpus)) {
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f),
+                       "Invalid CPU list, it will be ignored.");
+  }
+
+  bool pinServer = perf.wineserverCpu >= 0;
+  if (ImGui::Checkbox("Pin wineserver to a core", &pinServer)) {
+    perf.wineserverCpu = pinServer ? caps.cpuCount - 1 : -1;
+    changed = true;
+  }
+  if (pinServer) {
+    int core = perf.wineserverCpu;
+    if (ImGui::SliderInt("wineserver Core", &core, 0, caps.cpuCount - 1)) {
+      perf.wineserverCpu = core;
+      changed = true;
+    }
+    ImGui::TextDisabled("Studio is kept off this core.");
+  }
+
+  bool lowPrio = perf.lowPriorityBackground;
+  if (ImGui::Checkbox("Low Priority Background Work", &lowPrio)) {
+    perf.lowPriorityBackground = lowPrio;
+    changed = true;
+  }
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Runs background downloads, installs and cache work "
+                      "with nice 10 and idle I/O priority.");
+
+  if (changed)
+    cfg.update([&](ConfigSnapshot &next) { next.performance = perf; });
 }
 
 void SettingsPage::update() { ensureVersions(); }
 
 void SettingsPage::ensureVersions() {
-  auto &gen = Config::instance().getGeneral();
+  auto config = Config::instance().snapshot();
+  const auto &gen = config->general;
   if (gen.dxvk) {
     if (gen.dxvkSource.repo == "CUSTOM")
       ensureVersions(gen.dxvkCustomUrl);
@@ -926,19 +1183,57 @@ void SettingsPage::ensureVersions(const std::string &repo) {
       repo.find("://") != std::string::npos)
     return;
 
-  auto &cfg = Config::instance();
-  std::lock_guard<std::recursive_mutex> lock(cfg.getMutex());
+  std::lock_guard<std::mutex> lock(releaseMutex_);
   if (releaseCache_.count(repo) == 0 && fetching_.count(repo) == 0) {
     fetching_.insert(repo);
-    TaskRunner::instance().run([this, repo]() {
-      Downloader dl(PathManager::instance().root().string());
-      auto releases = dl.fetchReleases(repo);
+    TaskRunner::instance().run(
+        [this, repo]() {
+          // Show the cached list right away, then whatever revalidation
+          // brings
+          auto &cache = ReleaseCache::instance();
+          auto cached = cache.cached(repo);
+          if (!cached.empty()) {
+            std::lock_guard<std::mutex> lock(releaseMutex_);
+            releaseCache_[repo] = std::move(cached);
+            GUI::instance().wake();
+          }
 
-      std::lock_guard<std::recursive_mutex> lock(Config::instance().getMutex());
-      releaseCache_[repo] = releases;
-      fetching_.erase(repo);
-    });
+          Downloader dl(PathManager::instance().root().string());
+          auto releases = dl.fetchReleases(repo);
+          bool more = cache.hasMore(repo);
+
+          std::lock_guard<std::mutex> lock(releaseMutex_);
+          if (!releases.empty() || !releaseCache_.count(repo))
+            releaseCache_[repo] = releases;
+          if (more)
+            moreReleases_.insert(repo);
+          else
+            moreReleases_.erase(repo);
+          fetching_.erase(repo);
+          GUI::instance().wake();
+        },
+        TaskPriority::INTERACTIVE, "Fetch " + repo);
   }
 }
 
+void SettingsPage::loadOlderVersions(const std::string &repo) {
+  std::lock_guard<std::mutex> lock(releaseMutex_);
+  if (!fetching_.insert(repo).second)
+    return;
+  TaskRunner::instance().run(
+      [this, repo]() {
+        auto &cache = ReleaseCache::instance();
+        bool more = cache.fetchMore(repo);
+        auto releases = cache.cached(repo);
+
+        std::lock_guard<std::mutex> lock(releaseMutex_);
+        releaseCache_[repo] = std::move(releases);
+        if (!more)
+          moreReleases_.erase(repo);
+        fetching_.erase(repo);
+        GUI::instance().wake();
+      },
+      TaskPriority::INTERACTIVE, "Fetch " + repo);
+}
+
 } // namespace rsjfw
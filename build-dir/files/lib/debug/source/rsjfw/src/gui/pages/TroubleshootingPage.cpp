@@ -13,10 +13,12 @@
 
 #include "rsjfw/task_runner.hpp"
 #include "rsjfw/launcher.hpp"
+#include "rsjfw/log_retention.hpp"
+#include "rsjfw/storage.hpp"
 
 namespace rsjfw {
 
-TroubleshootingPage::TroubleshootingPage() {
+TroubleshootingPage::TroubleshootingPage() : logIndex_(LogIndex::create()) {
     refreshLogList();
     // runHealthChecks(); // Lazy load instead
 }
@@ -45,6 +47,10 @@ void TroubleshootingPage::render() {
                 tabTransition_ = 0.0f;
                 // Actions on switch
                 if (i == 0) runHealthChecks();
+                if (i == 1) {
+                    refreshShaderStats();
+                    Storage::instance().refreshUsage();
+                }
                 if (i == 2) refreshLogList();
             }
         }
@@ -55,6 +61,8 @@ void TroubleshootingPage::render() {
     if (ImGui::Button("Refresh", ImVec2(sidebarWidth - 16, 30))) {
         runHealthChecks();
         refreshLogList();
+        refreshShaderStats();
+        Storage::instance().refreshUsage();
     }
     ImGui::EndChild();
 
@@ -68,6 +76,7 @@ void TroubleshootingPage::render() {
     const float transitionSpeed = 4.0f;
     
     if (currentTab_ != targetTab_) {
+        GUI::instance().requestFrame();
         tabTransition_ += dt * transitionSpeed;
         if (tabTransition_ >= 1.0f) {
             currentTab_ = targetTab_;
@@ -119,6 +128,7 @@ void TroubleshootingPage::render() {
         bool isFailed = (fixStatus_.find("Failed") != std::string::npos || fixStatus_.find("Missing") != std::string::npos);
         
         if (isComplete || isFailed) {
+            GUI::instance().requestFrame(0.1);
             autoCloseTimer += ImGui::GetIO().DeltaTime;
             ImGui::Spacing();
             
@@ -214,7 +224,7 @@ void TroubleshootingPage::renderDiagnosticsTab() {
                                      fixProgress_ = p;
                                      fixStatus_ = s;
                                  });
-                             });
+                             }, TaskPriority::INTERACTIVE, currentFixName_);
                          }
                          ImGui::PopStyleColor();
                     }
@@ -304,25 +314,77 @@ void TroubleshootingPage::renderFixesTab() {
     ImGui::Spacing();
     
     auto& pm = PathManager::instance();
-    
+    auto& storage = Storage::instance();
+    renderStorageUsage();
+
+    // Each of these moves the tree to trash/ at once; the space comes back
+    // in the background
+    bool discarded = false;
     if (ImGui::Button("Clear All Versions", ImVec2(200, 30))) {
-        std::filesystem::remove_all(pm.versions());
-        std::filesystem::create_directories(pm.versions());
+        discarded |= storage.discard(pm.versions(), true);
     }
     ImGui::SameLine();
     if (ImGui::Button("Nuke Wine Prefix", ImVec2(200, 30))) {
-        std::filesystem::remove_all(pm.prefix());
+        discarded |= storage.discard(pm.prefix());
     }
     
     if (ImGui::Button("Remove Cached Wine", ImVec2(200, 30))) {
-        std::filesystem::remove_all(pm.wine());
-        std::filesystem::create_directories(pm.wine());
+        discarded |= storage.discard(pm.wine(), true);
     }
     ImGui::SameLine();
     if (ImGui::Button("Remove DXVK Cache", ImVec2(200, 30))) {
-        std::filesystem::remove_all(pm.dxvk());
-        std::filesystem::create_directories(pm.dxvk());
+        discarded |= storage.discard(pm.dxvk(), true);
+    }
+    if (discarded) storage.refreshUsage();
+
+    auto reclaim = storage.progress();
+    if (reclaim.pending > 0) {
+        ImGui::TextDisabled("Reclaiming space... %.1f MB freed so far", reclaim.bytes / (1024.0 * 1024.0));
+        GUI::instance().requestFrame(0.25);
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    ImGui::Text("Shader Cache");
+    ImGui::Spacing();
+    {
+        std::lock_guard<std::mutex> lock(shaderStatsMutex_);
+        if (shaderStatsLoading_) {
+            ImGui::TextDisabled("Measuring...");
+        } else if (shaderStats_.versions.empty()) {
+            ImGui::TextDisabled("No shader caches yet. They are created on the next launch.");
+        } else {
+            ImGui::Text("Total: %.1f MB", shaderStats_.totalBytes / (1024.0 * 1024.0));
+            if (ImGui::BeginTable("ShaderCacheTable", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                ImGui::TableSetupColumn("Version");
+                ImGui::TableSetupColumn("Size");
+                ImGui::TableSetupColumn("Sessions");
+                ImGui::TableSetupColumn("Entries Loaded");
+                ImGui::TableHeadersRow();
+                for (const auto& v : shaderStats_.versions) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", v.version.c_str());
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", v.gpuKey.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f MB (%llu files)", v.sizeBytes / (1024.0 * 1024.0), (unsigned long long)v.files);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%d", v.sessions);
+                    ImGui::TableNextColumn();
+                    if (v.loadedEntries >= 0) ImGui::Text("%lld", (long long)v.loadedEntries);
+                    else ImGui::TextDisabled("-");
+                }
+                ImGui::EndTable();
+            }
+        }
     }
+    if (ImGui::Button("Clear Shader Cache", ImVec2(200, 30))) {
+        ShaderCache::instance().clear();
+        refreshShaderStats();
+    }
+    ImGui::TextDisabled("Caches are kept per Studio version and GPU driver, and pruned on upgrades.");
     
     ImGui::Spacing();
     if (ImGui::Button("Reset All Configuration", ImVec2(200, 35))) {
@@ -371,11 +433,155 @@ void TroubleshootingPage::renderFixesTab() {
     }
 }
 
+void TroubleshootingPage::renderStorageUsage() {
+    auto& storage = Storage::instance();
+    auto usage = storage.usage();
+    if (!usage->ready) {
+        ImGui::TextDisabled("Measuring disk usage...");
+        if (storage.measuring()) GUI::instance().requestFrame(0.25);
+        return;
+    }
+
+    if (ImGui::BeginTable("StorageTable", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Data");
+        ImGui::TableSetupColumn("Size");
+        ImGui::TableHeadersRow();
+        for (const auto& item : usage->items) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", item.name.c_str());
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", item.path.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f MB", item.bytes / (1024.0 * 1024.0));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Total: %.1f GB, %.1f GB free on disk", usage->totalBytes / (1024.0 * 1024.0 * 1024.0),
+                usage->freeBytes / (1024.0 * 1024.0 * 1024.0));
+    if (storage.measuring()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(updating)");
+        GUI::instance().requestFrame(0.25);
+    }
+    ImGui::Spacing();
+}
+
+void TroubleshootingPage::refreshShaderStats() {
+    if (shaderStatsLoading_.exchange(true)) return;
+    TaskRunner::instance().run([this]() {
+        auto stats = ShaderCache::instance().stats();
+        std::lock_guard<std::mutex> lock(shaderStatsMutex_);
+        shaderStats_ = std::move(stats);
+        shaderStatsLoading_ = false;
+    });
+}
+
+void TroubleshootingPage::runLogSearch() {
+    if (searching_.exchange(true)) return;
+    std::string query = searchQuery_;
+    TaskRunner::instance().run([this, query]() {
+        auto result = LogSearch::instance().search(query);
+        std::lock_guard<std::mutex> lock(searchMutex_);
+        searchResult_ = std::move(result);
+        hasSearchResult_ = true;
+        searching_ = false;
+        GUI::instance().wake();
+    });
+}
+
+void TroubleshootingPage::renderLogSearch() {
+    ImGui::SetNextItemWidth(300);
+    bool submit = ImGui::InputTextWithHint("##logsearch", "Search all logs...", searchQuery_,
+                                           sizeof(searchQuery_), ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    if (ImGui::Button("Search", ImVec2(80, 0))) submit = true;
+    if (submit && searchQuery_[0]) runLogSearch();
+
+    std::lock_guard<std::mutex> lock(searchMutex_);
+    if (searching_) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Searching...");
+        GUI::instance().requestFrame(0.1);
+    }
+    if (!hasSearchResult_) return;
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear", ImVec2(60, 0))) {
+        hasSearchResult_ = false;
+        searchResult_ = {};
+        return;
+    }
+
+    const auto& res = searchResult_;
+    ImGui::TextDisabled("%zu%s hits in %zu files (%.1f ms, %zu blocks read)", res.hits.size(),
+                        res.truncated ? "+" : "", res.fileCounts.size(), res.millis, res.blocksRead);
+    auto levelCount = [&](LogIndex::Level level) {
+        auto it = res.levelCounts.find(level);
+        return it == res.levelCounts.end() ? (size_t)0 : it->second;
+    };
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%zu errors", levelCount(LogIndex::LEVEL_ERROR));
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "%zu warnings", levelCount(LogIndex::LEVEL_WARN));
+    ImGui::SameLine();
+    ImGui::TextDisabled("%zu info", levelCount(LogIndex::LEVEL_INFO));
+
+    if (ImGui::BeginTable("LogSearchResults", 4,
+                          ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                              ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable,
+                          ImVec2(0, 180))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("File", ImGuiTableColumnFlags_WidthFixed, 180.0f);
+        ImGui::TableSetupColumn("Line", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Time", ImGuiTableColumnFlags_WidthFixed, 140.0f);
+        ImGui::TableSetupColumn("Text", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)res.hits.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const auto& hit = res.hits[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID(i);
+                // Opens the hit in the viewer below
+                if (ImGui::Selectable(hit.file.c_str(), false, ImGuiSelectableFlags_SpanAllColumns)) {
+                    auto it = std::find(logFiles_.begin(), logFiles_.end(), hit.file);
+                    if (it != logFiles_.end()) {
+                        selectedLog_ = (int)(it - logFiles_.begin());
+                        jumpLine_ = hit.line;
+                    }
+                }
+                ImGui::PopID();
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu", hit.line);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(hit.timestamp.c_str());
+                ImGui::TableNextColumn();
+                if (hit.level == LogIndex::LEVEL_ERROR) {
+                    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+                } else if (hit.level == LogIndex::LEVEL_WARN) {
+                    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.8f, 0.2f, 1.0f));
+                } else {
+                    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
+                }
+                ImGui::TextUnformatted(hit.text.c_str(), hit.text.c_str() + hit.text.size());
+                ImGui::PopStyleColor();
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Spacing();
+}
+
 void TroubleshootingPage::renderLogsTab() {
     ImGui::Text("Application Logs");
     ImGui::Separator();
     ImGui::Spacing();
 
+    renderLogSearch();
+
     if (logFiles_.empty()) {
         ImGui::TextDisabled("No logs found.");
     } else {
@@ -407,62 +613,81 @@ void TroubleshootingPage::renderLogsTab() {
         ImGui::Checkbox("Info", &showInfo);
         
         ImGui::Spacing();
+
+        // Line numbers from search only map onto the unfiltered view
+        if (jumpLine_ > 0) {
+            showErrors = showWarnings = showInfo = true;
+            liveMode = false;
+        }
         
-        // Log content area
-        static std::string logContent;
-        static std::string lastLogPath;
+        unsigned mask = (showErrors ? LogIndex::LEVEL_ERROR : 0) |
+                        (showWarnings ? LogIndex::LEVEL_WARN : 0) |
+                        (showInfo ? LogIndex::LEVEL_INFO : 0);
+        logIndex_->setFilter(mask);
+
+        // Indexing and tailing happen on a worker; this only polls it
         static auto lastRefresh = std::chrono::steady_clock::now();
         static bool autoScroll = true;
         
         std::string currentLogPath = (PathManager::instance().logs() / logFiles_[selectedLog_]).string();
+        logIndex_->open(currentLogPath);
+
         auto now = std::chrono::steady_clock::now();
-        bool needsRefresh = (currentLogPath != lastLogPath) || 
-                           (liveMode && std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRefresh).count() > 200);
-        
-        if (needsRefresh) {
-            std::ifstream ifs(currentLogPath);
-            std::stringstream buffer; 
-            buffer << ifs.rdbuf();
-            logContent = buffer.str();
-            lastLogPath = currentLogPath;
+        if (liveMode && std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRefresh).count() > 200) {
+            logIndex_->refresh();
             lastRefresh = now;
         }
+        if (liveMode || logIndex_->busy()) GUI::instance().requestFrame(0.2);
         
         // Auto-scroll toggle
         ImGui::Checkbox("Auto-scroll", &autoScroll);
         ImGui::SameLine();
         if (ImGui::Button("Copy All", ImVec2(80, 0))) {
-            ImGui::SetClipboardText(logContent.c_str());
+            ImGui::SetClipboardText(logIndex_->text().c_str());
         }
         ImGui::SameLine();
         if (ImGui::Button("Open Folder", ImVec2(100, 0))) {
             std::string cmd = "xdg-open " + PathManager::instance().logs().string() + " &";
             system(cmd.c_str());
         }
+        ImGui::SameLine();
+        size_t visibleCount = logIndex_->visibleCount();
+        ImGui::TextDisabled("%zu of %zu lines%s", visibleCount, logIndex_->lineCount(),
+                            logIndex_->busy() ? " (indexing...)" : "");
         
         ImGui::Spacing();
         
-        // Log viewer with filtering
+        // Log viewer with filtering; only the rows on screen are read
         ImGui::BeginChild("LogContent", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
         
-        std::istringstream stream(logContent);
-        std::string line;
-        while (std::getline(stream, line)) {
-            bool isError = line.find("[ERROR]") != std::string::npos || line.find("error") != std::string::npos;
-            bool isWarning = line.find("[WARN]") != std::string::npos || line.find("warn") != std::string::npos;
-            bool isInfo = !isError && !isWarning;
-            
-            if ((isError && showErrors) || (isWarning && showWarnings) || (isInfo && showInfo)) {
-                if (isError) {
+        std::vector<LogIndex::Row> rows;
+        ImGuiListClipper clipper;
+        clipper.Begin((int)visibleCount);
+        while (clipper.Step()) {
+            logIndex_->rows(clipper.DisplayStart, clipper.DisplayEnd, rows);
+            for (const auto& row : rows) {
+                if (row.level == LogIndex::LEVEL_ERROR) {
                     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
-                } else if (isWarning) {
+                } else if (row.level == LogIndex::LEVEL_WARN) {
                     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.8f, 0.2f, 1.0f));
                 } else {
                     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
                 }
-                ImGui::TextUnformatted(line.c_str());
+                ImGui::TextUnformatted(row.text.c_str(), row.text.c_str() + row.text.size());
                 ImGui::PopStyleColor();
             }
+            // The index can shrink under us (file rotated); keep the clipper's row count honest
+            for (size_t i = rows.size(); i < (size_t)(clipper.DisplayEnd - clipper.DisplayStart); ++i) {
+                ImGui::TextUnformatted("");
+            }
+        }
+        clipper.End();
+
+        if (jumpLine_ > 0 && visibleCount >= jumpLine_ && !logIndex_->busy()) {
+            ImGui::SetScrollY(ImGui::GetTextLineHeightWithSpacing() * (float)(jumpLine_ - 1));
+            jumpLine_ = 0;
+        } else if (jumpLine_ > 0) {
+            GUI::instance().requestFrame(0.1);
         }
         
         if (autoScroll && liveMode) {
@@ -484,9 +709,11 @@ void TroubleshootingPage::refreshLogList() {
     logFiles_.clear();
     auto logsDir = PathManager::instance().logs();
     if (std::filesystem::exists(logsDir)) {
-        for (const auto& entry : std::filesystem::directory_iterator(logsDir)) {
-            if (entry.path().extension() == ".log") {
-                logFiles_.push_back(entry.path().filename().string());
+        // old/ holds archived sessions; names stay relative to the logs dir
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(logsDir)) {
+            const auto& p = entry.path();
+            if (entry.is_regular_file() && LogRetention::isLogFile(p)) {
+                logFiles_.push_back(std::filesystem::relative(entry.path(), logsDir).string());
             }
         }
         std::sort(logFiles_.rbegin(), logFiles_.rend());
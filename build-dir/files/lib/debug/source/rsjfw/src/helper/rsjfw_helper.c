@@ -0,0 +1,377 @@
+/*
+ * rsjfw-helper.exe: runs inside the Wine prefix and answers requests from
+ * RSJFW over stdin/stdout, so a batch of registry and file queries costs one
+ * Wine process start instead of one `wine reg` per query.
+ *
+ * One request per line, fields separated by tabs. Tab, newline, carriage
+ * return and backslash inside a field are escaped as \t, \n, \r and \\.
+ * Every request gets exactly one reply line, "OK" or "ERR" plus fields:
+ *
+ *   PING                                  OK  rsjfw-helper <protocol>
+ *   REG_EXISTS  <key> <name>              OK  0|1
+ *   REG_READ    <key> <name>              OK  <type> <value>
+ *   REG_WRITE   <key> <name> <type> <val> OK
+ *   FILE_EXISTS <path>                    OK  0|1
+ *   ENV         <name>                    OK  <value>   (ERR when unset)
+ *   QUIT                                  (no reply, exits)
+ *
+ * <key> is a full path such as HKEY_CURRENT_USER\Software\Wine; the HKCU,
+ * HKLM, HKCR and HKU short forms work too. An empty <name> is the key's
+ * default value. REG_WRITE takes REG_SZ, REG_EXPAND_SZ, REG_DWORD and
+ * REG_BINARY. REG_DWORD values are decimal (hex with 0x on input) and
+ * REG_BINARY values plain hex digits; text is UTF-8 on the wire.
+ *
+ * Build with MinGW-w64:
+ *   x86_64-w64-mingw32-gcc -O2 -s -o rsjfw-helper.exe rsjfw_helper.c
+ */
+
+#define WIN32_LEAN_AND_MEAN
+#include <fcntl.h>
+#include <io.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define PROTOCOL_VERSION "1"
+#define MAX_FIELDS 8
+
+/* --- Wire format --- */
+
+static void unescape(char *s) {
+  char *out = s;
+  for (; *s; ++s) {
+    if (*s != '\\' || !s[1]) {
+      *out++ = *s;
+      continue;
+    }
+    ++s;
+    switch (*s) {
+    case 't': *out++ = '\t'; break;
+    case 'n': *out++ = '\n'; break;
+    case 'r': *out++ = '\r'; break;
+    default: *out++ = *s; break;
+    }
+  }
+  *out = '\0';
+}
+
+static void putEscaped(const char *s) {
+  for (; *s; ++s) {
+    switch (*s) {
+    case '\t': fputs("\\t", stdout); break;
+    case '\n': fputs("\\n", stdout); break;
+    case '\r': fputs("\\r", stdout); break;
+    case '\\': fputs("\\\\", stdout); break;
+    default: fputc(*s, stdout); break;
+    }
+  }
+}
+
+/* Writes "OK"/"ERR" followed by `count` escaped fields */
+static void reply(int ok, int count, const char **fields) {
+  fputs(ok ? "OK" : "ERR", stdout);
+  for (int i = 0; i < count; ++i) {
+    fputc('\t', stdout);
+    putEscaped(fields[i]);
+  }
+  fputc('\n', stdout);
+  fflush(stdout);
+}
+
+static void replyOk(const char *field) { reply(1, field ? 1 : 0, &field); }
+static void replyErr(const char *why) { reply(0, 1, &why); }
+
+/* One line from stdin without the newline, or NULL at EOF. Reuses *buf. */
+static char *readLine(char **buf, size_t *cap) {
+  size_t len = 0;
+  int c;
+  while ((c = fgetc(stdin)) != EOF && c != '\n') {
+    if (len + 1 >= *cap) {
+      size_t next = *cap ? *cap * 2 : 1024;
+      char *grown = realloc(*buf, next);
+      if (!grown)
+        return NULL;
+      *buf = grown;
+      *cap = next;
+    }
+    (*buf)[len++] = (char)c;
+  }
+  if (c == EOF && len == 0)
+    return NULL;
+  if (!*buf) {
+    *buf = malloc(1);
+    *cap = 1;
+  }
+  if (len > 0 && (*buf)[len - 1] == '\r')
+    len--;
+  (*buf)[len] = '\0';
+  return *buf;
+}
+
+/* --- Text conversion --- */
+
+static wchar_t *toWide(const char *utf8) {
+  int n = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, NULL, 0);
+  wchar_t *w = malloc(sizeof(wchar_t) * (n > 0 ? n : 1));
+  if (n <= 0 || !MultiByteToWideChar(CP_UTF8, 0, utf8, -1, w, n))
+    w[0] = L'\0';
+  return w;
+}
+
+static char *toUtf8(const wchar_t *wide) {
+  int n = WideCharToMultiByte(CP_UTF8, 0, wide, -1, NULL, 0, NULL, NULL);
+  char *s = malloc(n > 0 ? n : 1);
+  if (n <= 0 || !WideCharToMultiByte(CP_UTF8, 0, wide, -1, s, n, NULL, NULL))
+    s[0] = '\0';
+  return s;
+}
+
+/* --- Registry --- */
+
+static const struct {
+  const char *name;
+  HKEY root;
+} ROOTS[] = {{"HKEY_CURRENT_USER", HKEY_CURRENT_USER},
+             {"HKCU", HKEY_CURRENT_USER},
+             {"HKEY_LOCAL_MACHINE", HKEY_LOCAL_MACHINE},
+             {"HKLM", HKEY_LOCAL_MACHINE},
+             {"HKEY_CLASSES_ROOT", HKEY_CLASSES_ROOT},
+             {"HKCR", HKEY_CLASSES_ROOT},
+             {"HKEY_USERS", HKEY_USERS},
+             {"HKU", HKEY_USERS}};
+
+/* Splits "ROOT\sub\key" into a root handle and the subkey; NULL if unknown */
+static const char *splitKey(const char *path, HKEY *root) {
+  const char *slash = strchr(path, '\\');
+  size_t len = slash ? (size_t)(slash - path) : strlen(path);
+  for (size_t i = 0; i < sizeof(ROOTS) / sizeof(ROOTS[0]); ++i) {
+    if (strlen(ROOTS[i].name) == len &&
+        _strnicmp(ROOTS[i].name, path, len) == 0) {
+      *root = ROOTS[i].root;
+      return slash ? slash + 1 : "";
+    }
+  }
+  return NULL;
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+static void regExists(const char *keyPath, const char *name) {
+  HKEY root, key;
+  const char *sub = splitKey(keyPath, &root);
+  if (!sub) {
+    replyErr("unknown root key");
+    return;
+  }
+  wchar_t *wsub = toWide(sub), *wname = toWide(name);
+  int found = 0;
+  if (RegOpenKeyExW(root, wsub, 0, KEY_QUERY_VALUE, &key) == ERROR_SUCCESS) {
+    found = RegQueryValueExW(key, *wname ? wname : NULL, NULL, NULL, NULL,
+                             NULL) == ERROR_SUCCESS;
+    RegCloseKey(key);
+  }
+  free(wsub);
+  free(wname);
+  replyOk(found ? "1" : "0");
+}
+
+static void regRead(const char *keyPath, const char *name) {
+  HKEY root, key;
+  const char *sub = splitKey(keyPath, &root);
+  if (!sub) {
+    replyErr("unknown root key");
+    return;
+  }
+  wchar_t *wsub = toWide(sub), *wname = toWide(name);
+  LONG rc = RegOpenKeyExW(root, wsub, 0, KEY_QUERY_VALUE, &key);
+  free(wsub);
+  if (rc != ERROR_SUCCESS) {
+    free(wname);
+    replyErr("key not found");
+    return;
+  }
+
+  DWORD type = 0, size = 0;
+  const wchar_t *valueName = *wname ? wname : NULL;
+  BYTE *data = NULL;
+  rc = RegQueryValueExW(key, valueName, NULL, &type, NULL, &size);
+  if (rc == ERROR_SUCCESS) {
+    /* Room for a terminator the stored string may lack */
+    data = calloc(size + sizeof(wchar_t), 1);
+    rc = RegQueryValueExW(key, valueName, NULL, &type, data, &size);
+  }
+  RegCloseKey(key);
+  free(wname);
+  if (rc != ERROR_SUCCESS) {
+    free(data);
+    replyErr("value not found");
+    return;
+  }
+
+  const char *fields[2];
+  char *text = NULL;
+  char number[16];
+  if (type == REG_SZ || type == REG_EXPAND_SZ) {
+    fields[0] = type == REG_SZ ? "REG_SZ" : "REG_EXPAND_SZ";
+    text = toUtf8((const wchar_t *)data);
+    fields[1] = text;
+  } else if (type == REG_DWORD && size >= sizeof(DWORD)) {
+    fields[0] = "REG_DWORD";
+    snprintf(number, sizeof(number), "%lu", *(DWORD *)data);
+    fields[1] = number;
+  } else {
+    /* REG_BINARY and anything else, as raw bytes */
+    static const char *digits = "0123456789abcdef";
+    fields[0] = type == REG_BINARY ? "REG_BINARY" : "REG_NONE";
+    text = malloc(size * 2 + 1);
+    for (DWORD i = 0; i < size; ++i) {
+      text[i * 2] = digits[data[i] >> 4];
+      text[i * 2 + 1] = digits[data[i] & 0xf];
+    }
+    text[size * 2] = '\0';
+    fields[1] = text;
+  }
+  reply(1, 2, fields);
+  free(text);
+  free(data);
+}
+
+static void regWrite(const char *keyPath, const char *name, const char *type,
+                     const char *value) {
+  if (strcmp(type, "REG_SZ") != 0 && strcmp(type, "REG_EXPAND_SZ") != 0 &&
+      strcmp(type, "REG_DWORD") != 0 && strcmp(type, "REG_BINARY") != 0) {
+    replyErr("unknown type");
+    return;
+  }
+
+  HKEY root, key;
+  const char *sub = splitKey(keyPath, &root);
+  if (!sub) {
+    replyErr("unknown root key");
+    return;
+  }
+  wchar_t *wsub = toWide(sub);
+  LONG rc = RegCreateKeyExW(root, wsub, 0, NULL, 0, KEY_SET_VALUE, NULL, &key,
+                            NULL);
+  free(wsub);
+  if (rc != ERROR_SUCCESS) {
+    replyErr("cannot create key");
+    return;
+  }
+
+  wchar_t *wname = toWide(name);
+  const wchar_t *valueName = *wname ? wname : NULL;
+  if (strcmp(type, "REG_DWORD") == 0) {
+    DWORD dword = (DWORD)strtoul(value, NULL, 0);
+    rc = RegSetValueExW(key, valueName, 0, REG_DWORD, (const BYTE *)&dword,
+                        sizeof(dword));
+  } else if (strcmp(type, "REG_BINARY") == 0) {
+    size_t len = strlen(value);
+    BYTE *bytes = malloc(len / 2 + 1);
+    DWORD count = 0;
+    int high = -1;
+    for (size_t i = 0; i < len; ++i) {
+      int v = hexValue(value[i]);
+      if (v < 0)
+        continue; /* Separators such as ',' */
+      if (high < 0) {
+        high = v;
+      } else {
+        bytes[count++] = (BYTE)(high << 4 | v);
+        high = -1;
+      }
+    }
+    rc = RegSetValueExW(key, valueName, 0, REG_BINARY, bytes, count);
+    free(bytes);
+  } else {
+    DWORD kind = strcmp(type, "REG_EXPAND_SZ") == 0 ? REG_EXPAND_SZ : REG_SZ;
+    wchar_t *wvalue = toWide(value);
+    rc = RegSetValueExW(key, valueName, 0, kind, (const BYTE *)wvalue,
+                        (DWORD)((wcslen(wvalue) + 1) * sizeof(wchar_t)));
+    free(wvalue);
+  }
+  free(wname);
+  RegCloseKey(key);
+  if (rc == ERROR_SUCCESS)
+    replyOk(NULL);
+  else
+    replyErr("cannot set value");
+}
+
+/* --- Files and environment --- */
+
+static void fileExists(const char *path) {
+  wchar_t *wpath = toWide(path);
+  DWORD attrs = GetFileAttributesW(wpath);
+  free(wpath);
+  replyOk(attrs != INVALID_FILE_ATTRIBUTES ? "1" : "0");
+}
+
+static void env(const char *name) {
+  wchar_t *wname = toWide(name);
+  DWORD n = GetEnvironmentVariableW(wname, NULL, 0);
+  if (n == 0) {
+    free(wname);
+    replyErr("not set");
+    return;
+  }
+  wchar_t *wvalue = malloc(sizeof(wchar_t) * n);
+  GetEnvironmentVariableW(wname, wvalue, n);
+  char *value = toUtf8(wvalue);
+  replyOk(value);
+  free(value);
+  free(wvalue);
+  free(wname);
+}
+
+int main(void) {
+  /* No CRLF translation on the pipes */
+  _setmode(_fileno(stdin), _O_BINARY);
+  _setmode(_fileno(stdout), _O_BINARY);
+
+  char *line = NULL;
+  size_t cap = 0;
+  while (readLine(&line, &cap)) {
+    char *fields[MAX_FIELDS];
+    int count = 0;
+    char *p = line;
+    fields[count++] = p;
+    while ((p = strchr(p, '\t')) && count < MAX_FIELDS) {
+      *p++ = '\0';
+      fields[count++] = p;
+    }
+    for (int i = 0; i < count; ++i)
+      unescape(fields[i]);
+    const char *op = fields[0];
+
+#define ARG(i) (count > (i) ? fields[i] : "")
+    if (strcmp(op, "QUIT") == 0)
+      break;
+    else if (strcmp(op, "PING") == 0)
+      replyOk("rsjfw-helper " PROTOCOL_VERSION);
+    else if (strcmp(op, "REG_EXISTS") == 0)
+      regExists(ARG(1), ARG(2));
+    else if (strcmp(op, "REG_READ") == 0)
+      regRead(ARG(1), ARG(2));
+    else if (strcmp(op, "REG_WRITE") == 0)
+      regWrite(ARG(1), ARG(2), ARG(3), ARG(4));
+    else if (strcmp(op, "FILE_EXISTS") == 0)
+      fileExists(ARG(1));
+    else if (strcmp(op, "ENV") == 0)
+      env(ARG(1));
+    else
+      replyErr("unknown request");
+#undef ARG
+  }
+  free(line);
+  return 0;
+}
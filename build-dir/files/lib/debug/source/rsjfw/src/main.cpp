@@ -2,13 +2,21 @@
 #include "rsjfw/downloader.hpp"
 #include "rsjfw/gui.hpp"
 #include "rsjfw/launcher.hpp"
+#include "rsjfw/log_retention.hpp"
+#include "rsjfw/log_search.hpp"
 #include "rsjfw/logger.hpp"
 #include "rsjfw/path_manager.hpp"
+#include "rsjfw/shader_cache.hpp"
 #include "rsjfw/socket.hpp"
+#include "rsjfw/standby.hpp"
+#include "rsjfw/storage.hpp"
 #include "rsjfw/task_runner.hpp"
+#include "rsjfw/updater.hpp"
+#include "rsjfw/version_gc.hpp"
 #include <algorithm>
 #include <cstdlib>
 #include <filesystem>
+#include <future>
 #include <iostream>
 #include <random>
 #include <string>
@@ -34,6 +42,82 @@ void showHelp() {
 
 #include "rsjfw/version.hpp"
 
+// Studio's command line for RSJFW arguments: auth links are passed raw,
+// other protocol links go behind -protocolString
+static std::vector<std::string>
+studioArgs(const std::vector<std::string> &args, size_t first = 0) {
+  std::vector<std::string> out;
+  for (size_t i = first; i < args.size(); ++i) {
+    if (args[i].find("roblox-studio:") == 0)
+      out.push_back("-protocolString");
+    out.push_back(args[i]);
+  }
+  return out;
+}
+
+// What a protocol link opens: whatever the last full start saw as latest.
+// Installing it is the updater's job, so fall back to the newest install.
+static std::string protocolTarget(const std::string &rsjfwRoot) {
+  rsjfw::Downloader downloader(rsjfwRoot);
+  std::string target = downloader.getCachedLatestVersionGUID();
+  if (target.empty() || !downloader.isVersionInstalled(target)) {
+    auto versions = downloader.getInstalledVersions();
+    target = versions.empty() ? "" : versions[0];
+  }
+  return target;
+}
+
+// Runs a command a later invocation handed over (see CommandServer). The
+// request is that invocation's arguments, command first. Only what needs
+// no window of its own is taken; anything else is declined and the sender
+// exits as before.
+static std::string runForwarded(const std::vector<std::string> &request,
+                                const std::string &rsjfwRoot, bool debug,
+                                bool configMode) {
+  const std::string &command = request[0];
+
+  if (command == "config" && configMode) {
+    rsjfw::Standby::instance().requestShow();
+    rsjfw::GUI::instance().wake();
+    return "OK";
+  }
+
+  if (command == "kill") {
+    rsjfw::Launcher launcher(rsjfwRoot);
+    return launcher.killStudio() ? "OK" : "ERR kill failed";
+  }
+
+  // Protocol links only; a plain launch wants the installer window. The
+  // sender stops at "OK" and the launch happens here, off this thread so
+  // the next request is not kept waiting.
+  if (command == "launch" && request.size() > 1) {
+    std::string target = protocolTarget(rsjfwRoot);
+    if (target.empty())
+      return "ERR no version installed";
+    auto task = rsjfw::TaskRunner::instance().run(
+        [rsjfwRoot, debug, target, launchArgs = studioArgs(request, 1)]() {
+          rsjfw::Launcher launcher(rsjfwRoot);
+          launcher.setDebug(debug);
+          LOG_INFO("Forwarded launch of " + target);
+          launcher.setupFFlags(target);
+          if (!launcher.launchVersion(target, launchArgs, nullptr, nullptr,
+                                      false))
+            LOG_ERROR("Forwarded launch of " + target + " failed");
+        },
+        rsjfw::TaskPriority::INTERACTIVE, "Forwarded launch");
+    // Dropped at once when this instance is on its way out
+    return task.rejected() ? "ERR shutting down" : "OK";
+  }
+
+  // A plain launch finds the config editor in standby: it exits, and the
+  // sender takes the lock and launches as usual
+  if (command == "launch" && configMode &&
+      rsjfw::Standby::instance().handOff())
+    return "HANDOFF";
+
+  return "ERR not handled by the running instance";
+}
+
 int main(int argc, char *argv[]) {
   std::vector<std::string> args;
   for (int i = 1; i < argc; ++i) {
@@ -75,12 +159,44 @@ int main(int argc, char *argv[]) {
     args.erase(itDebug);
   }
 
+  // Protocol links ("Edit" on the website) should open Studio as fast as
+  // possible, so they only resolve paths, read the config and launch. The
+  // directory layout, migrations, log maintenance and the network version
+  // check all wait for the next full start.
+  std::string protocolArg;
+  for (const auto &arg : args) {
+    // The args vector is already filtered for "%u" and empty strings
+    if (arg.find("roblox-studio-auth:") == 0 ||
+        arg.find("roblox-studio:") == 0) {
+      protocolArg = arg;
+      break;
+    }
+  }
+  const bool fullStart = protocolArg.empty();
+
   // Initialize PathManager early for SingleInstance and Logger
-  rsjfw::PathManager::instance().init();
   auto &pathMgr = rsjfw::PathManager::instance();
+  if (fullStart)
+    pathMgr.init();
+  else
+    pathMgr.resolve();
   const std::string rsjfwRoot = pathMgr.root().string();
 
-  rsjfw::Logger::instance().init(pathMgr.currentLog(), verbose);
+  // The fast path only logs to the console; the session log file and its
+  // writer thread are part of a full start
+  auto startLogging = [&] {
+    rsjfw::Logger::instance().init(pathMgr.currentLog(), verbose);
+    if (debug)
+      rsjfw::Logger::instance().setLevel(rsjfw::LogLevel::DEBUG);
+    rsjfw::LogSearch::instance().attach();
+  };
+  if (fullStart) {
+    startLogging();
+  } else {
+    rsjfw::Logger::instance().configure(verbose);
+    if (debug)
+      rsjfw::Logger::instance().setLevel(rsjfw::LogLevel::DEBUG);
+  }
   LOG_INFO("=== RSJFW Main Boot Started ===");
 
   // Log all arguments for debugging protocol issues
@@ -97,89 +213,115 @@ int main(int argc, char *argv[]) {
 
   // Load configuration early
   const std::string configPath = (pathMgr.root() / "config.json").string();
-  rsjfw::Config::instance().load(configPath);
-
-  // Fast Protocol Path - search for roblox-studio links
-  std::string protocolArg;
-  for (const auto &arg : args) {
-    // The args vector is already filtered for "%u" and empty strings
-    if (arg.find("roblox-studio-auth:") == 0 ||
-        arg.find("roblox-studio:") == 0) {
-      protocolArg = arg;
-      break;
-    }
-  }
-
-  if (!protocolArg.empty()) {
-    rsjfw::Downloader downloader(rsjfwRoot);
-    rsjfw::Launcher launcher(rsjfwRoot);
-    launcher.setDebug(debug);
-
-    std::string targetVersion;
-    try {
-      targetVersion = downloader.getLatestVersionGUID();
-    } catch (...) {
-    }
-    if (targetVersion.empty() ||
-        !downloader.isVersionInstalled(targetVersion)) {
-      auto versions = downloader.getInstalledVersions();
-      if (!versions.empty()) {
-        std::sort(versions.rbegin(), versions.rend());
-        targetVersion = versions[0];
-      }
+  rsjfw::Config::instance().load(configPath, fullStart);
+  rsjfw::Logger::instance().setRotateBytes(
+      (uint64_t)std::max(rsjfw::Config::instance().snapshot()->logs.rotateMB, 0)
+      << 20);
+
+  if (!fullStart) {
+    // A running instance has all of this loaded already. Once it has the
+    // link, launching here as well would start Studio twice.
+    auto reply = rsjfw::CommandServer::send(pathMgr.commandSocket(),
+                                            {"launch", protocolArg});
+    if (reply == "OK" || reply == "") {
+      LOG_INFO("Fast-Path: Handed to the running instance" +
+               std::string(*reply == "" ? " (no reply)" : ""));
+      return 0;
     }
 
+    std::string targetVersion = protocolTarget(rsjfwRoot);
     if (!targetVersion.empty()) {
-      std::vector<std::string> launchArgs;
-      // roblox-studio-auth: should NOT use -protocolString
-      if (protocolArg.find("roblox-studio-auth:") == 0) {
-        launchArgs.push_back(protocolArg);
-      } else {
-        launchArgs.push_back("-protocolString");
-        launchArgs.push_back(protocolArg);
-      }
-
+      rsjfw::Launcher launcher(rsjfwRoot);
+      launcher.setDebug(debug);
       LOG_INFO("Fast-Path: Launching " + targetVersion + " (Detached)");
       launcher.setupFFlags(targetVersion);
-      launcher.launchVersion(targetVersion, launchArgs, nullptr, nullptr,
-                             false); // Detached
+      launcher.launchVersion(targetVersion, studioArgs({protocolArg}),
+                             nullptr, nullptr, false); // Detached
       return 0;
     }
+
+    // Nothing installed yet: carry on as a full start
+    LOG_INFO("Fast-Path: No installed version, continuing with full start");
+    pathMgr.init();
+    startLogging();
+    rsjfw::Config::instance().save();
+  }
+  std::string command = args.empty() ? "config" : args[0];
+  // If the first argument IS a protocol, the command is 'launch'
+  if (!args.empty() && (args[0].find("roblox-studio-auth:") == 0 ||
+                        args[0].find("roblox-studio:") == 0)) {
+    command = "launch";
   }
 
   // Not a protocol link. Enforce single instance.
   rsjfw::SingleInstance singleInstance(pathMgr.root() / "rsjfw.lock");
   if (!singleInstance.isPrimary()) {
-    std::cout << "[RSJFW] Another instance is already running. Exiting.\n";
-    return 0;
+    // Hand the command to the primary, which may be able to run it
+    std::vector<std::string> request = args;
+    if (request.empty() || request[0] != command)
+      request.insert(request.begin(), command);
+    auto reply = rsjfw::CommandServer::send(pathMgr.commandSocket(), request);
+    if (reply == "OK" || reply == "") {
+      LOG_INFO("Forwarded '" + command + "' to the running instance");
+      return 0;
+    }
+    if (reply == "HANDOFF" &&
+        singleInstance.isPrimary(std::chrono::seconds(10))) {
+      LOG_INFO("Took over from the instance in standby");
+    } else {
+      if (reply)
+        LOG_INFO("Running instance declined '" + command + "': " + *reply);
+      std::cout << "[RSJFW] Another instance is already running. Exiting.\n";
+      return 0;
+    }
   }
 
-  if (!args.empty() && args[0] == "kill") {
+  // Maintenance is the primary's job; a secondary may be gone in a moment
+  rsjfw::LogRetention::instance().schedule();
+  rsjfw::Storage::instance().sweep();
+
+  // Later invocations hand their commands to this process
+  rsjfw::CommandServer commands(pathMgr.commandSocket());
+  commands.listen([&](const std::vector<std::string> &request) {
+    return runForwarded(request, rsjfwRoot, debug, command == "config");
+  });
+
+  if (command == "kill") {
     LOG_INFO("Terminating Studio...");
     rsjfw::Launcher launcher(rsjfwRoot);
     launcher.setDebug(debug);
     return launcher.killStudio() ? 0 : 1;
   }
 
-  std::string command = args.empty() ? "config" : args[0];
-  // If the first argument IS a protocol, the command is 'launch'
-  if (!args.empty() && (args[0].find("roblox-studio-auth:") == 0 ||
-                        args[0].find("roblox-studio:") == 0)) {
-    command = "launch";
-  }
-
   LOG_INFO("RSJFW Started. Command: " + command);
 
   if (command == "config") {
     auto &gui = rsjfw::GUI::instance();
-    if (gui.init(800, 600, "RSJFW - Config", true)) {
-      gui.setMode(rsjfw::GUI::MODE_CONFIG);
-      gui.run(nullptr);
-      return 0;
-    } else {
+    if (!gui.init(800, 600, "RSJFW - Config", true)) {
       LOG_ERROR("Could not initialize GUI for config editor. Check logs.");
       return 1;
     }
+
+    rsjfw::Updater::instance().start();
+
+    // Closing the window while Studio runs drops the UI until it is asked
+    // for again, Studio exits or a plain `rsjfw launch` takes over
+    for (;;) {
+      gui.setMode(rsjfw::GUI::MODE_CONFIG);
+      gui.run(nullptr);
+      bool standby = gui.closedByUser() &&
+                     rsjfw::Config::instance().snapshot()->general.standby;
+      gui.shutdown();
+      if (!standby || rsjfw::Standby::instance().wait(pathMgr.prefix()) !=
+                          rsjfw::Standby::Wake::SHOW)
+        break;
+      if (!gui.init(800, 600, "RSJFW - Config", true)) {
+        LOG_ERROR("Could not reopen the config editor. Check logs.");
+        break;
+      }
+    }
+    rsjfw::Updater::instance().stop();
+    return 0;
   }
 
   bool isReinstall = (command == "reinstall");
@@ -205,22 +347,8 @@ int main(int argc, char *argv[]) {
 
         try {
           // Re-parse extra arguments inside the task thread from the original
-          // command line args
-          std::vector<std::string> extraArgs;
-          if (args.size() >
-              0) { // args[0] is the command (launch/install/reinstall)
-            for (size_t i = 1; i < args.size(); ++i) {
-              std::string arg = args[i];
-              if (arg.find("roblox-studio-auth:") == 0) {
-                extraArgs.push_back(arg); // AUTH IS RAW
-              } else if (arg.find("roblox-studio:") == 0) {
-                extraArgs.push_back("-protocolString");
-                extraArgs.push_back(arg);
-              } else {
-                extraArgs.push_back(arg);
-              }
-            }
-          }
+          // command line args; args[0] is the command
+          std::vector<std::string> extraArgs = studioArgs(args, 1);
 
           LOG_DEBUG("Parsed " + std::to_string(extraArgs.size()) +
                     " extra arguments.");
@@ -231,9 +359,7 @@ int main(int argc, char *argv[]) {
             gui.setProgress(0.05f, "Removing old versions...");
             std::filesystem::path versionsDir =
                 std::filesystem::path(rsjfwRoot) / "versions";
-            if (std::filesystem::exists(versionsDir)) {
-              std::filesystem::remove_all(versionsDir);
-            }
+            rsjfw::Storage::instance().discard(versionsDir, true);
             std::filesystem::path prefixMarker =
                 std::filesystem::path(rsjfwRoot) / "prefix" /
                 ".rsjfw_setup_complete";
@@ -253,8 +379,8 @@ int main(int argc, char *argv[]) {
               int major = 0, minor = 0;
               sscanf(vkBuf, "%d.%d", &major, &minor);
 
-              auto &cfg = rsjfw::Config::instance();
-              auto &gen = cfg.getGeneral();
+              auto config = rsjfw::Config::instance().snapshot();
+              const auto &gen = config->general;
               std::string dxvkVer = gen.dxvkVersion;
               std::string dxvkClean = dxvkVer;
               if (!dxvkClean.empty() &&
@@ -277,10 +403,13 @@ int main(int argc, char *argv[]) {
                 LOG_WARN(msg + " Auto-fixing to v1.10.3");
 
                 // Auto-fix: switch to DXVK 1.10.3
-                gen.dxvkSource.version = "v1.10.3";
-                gen.dxvkSource.repo = "doitsujin/dxvk";
-                gen.dxvkSource.installedRoot = ""; // Clear to force re-download
-                cfg.save();
+                rsjfw::Config::instance().update(
+                    [](rsjfw::ConfigSnapshot &next) {
+                      next.general.dxvkSource.version = "v1.10.3";
+                      next.general.dxvkSource.repo = "doitsujin/dxvk";
+                      // Clear to force re-download
+                      next.general.dxvkSource.installedRoot = "";
+                    });
 
                 std::this_thread::sleep_for(std::chrono::seconds(2));
               }
@@ -319,6 +448,35 @@ int main(int argc, char *argv[]) {
           gui.setProgress(0.75f, "Installing DXVK...");
           launcher.setupDxvk(latestVersion, launcherProgress);
 
+          // Post-install shader warm-up runs alongside FFlags and health
+          // checks; the launch below waits for it so the session starts warm
+          std::future<bool> warmup;
+          auto &shaderCache = rsjfw::ShaderCache::instance();
+          if (rsjfw::Config::instance().snapshot()->general.dxvk) {
+            if (rsjfw::Config::instance().snapshot()->general.shaderWarmup &&
+                shaderCache.needsWarmup(latestVersion)) {
+              std::filesystem::path versionDir =
+                  std::filesystem::path(rsjfwRoot) / "versions" /
+                  latestVersion;
+              warmup = rsjfw::TaskRunner::instance().async([&gui, latestVersion,
+                                                            versionDir]() {
+                bool ok = rsjfw::ShaderCache::instance().warmup(
+                    latestVersion, versionDir,
+                    [&gui](float p, const std::string &msg) {
+                      gui.setTaskProgress("Shader Warm-up", p, msg);
+                    });
+                gui.removeTask("Shader Warm-up");
+                return ok;
+              });
+            } else {
+              rsjfw::TaskRunner::instance().run(
+                  [latestVersion]() {
+                    rsjfw::ShaderCache::instance().prewarm(latestVersion);
+                  },
+                  rsjfw::TaskPriority::BACKGROUND, "Shader prewarm");
+            }
+          }
+
           gui.setProgress(0.85f, "Injecting FFlags...");
           launcher.setupFFlags(latestVersion, launcherProgress);
 
@@ -358,6 +516,11 @@ int main(int argc, char *argv[]) {
             }
           }
 
+          if (warmup.valid()) {
+            gui.setProgress(0.9f, "Warming up shader cache...");
+            rsjfw::TaskRunner::instance().wait(warmup);
+          }
+
           gui.setProgress(0.95f, "Launching Roblox Studio...");
           gui.setSubProgress(-1.0f, "Waiting for wine...");
 
@@ -389,6 +552,10 @@ int main(int argc, char *argv[]) {
 
                       LOG_INFO("Studio window detected: " + line);
                       studioStarted = true;
+                      // The new version works; older ones can go
+                      rsjfw::VersionGC::instance().schedule(latestVersion);
+                      // Stage the next one while this session runs
+                      rsjfw::Updater::instance().start();
                       gui.setSubProgress(1.0f, "Studio Started.");
                       std::this_thread::sleep_for(
                           std::chrono::milliseconds(800));
@@ -408,7 +575,9 @@ int main(int argc, char *argv[]) {
 
       gui.run(nullptr);
       gui.shutdown();
+      // Returns once Studio has exited
       rsjfw::TaskRunner::instance().shutdown();
+      rsjfw::Updater::instance().stop();
       return 0;
 
     } else {